@@ -0,0 +1,91 @@
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+// Replacement global allocation functions. Linking this translation unit into
+// an executable makes every allocation on every thread observable through
+// proto::bench::allocation_stats().
+
+namespace {
+thread_local proto::bench::AllocationStats t_stats;
+
+void *counted_alloc(std::size_t size) noexcept {
+    ++t_stats.allocations;
+    t_stats.bytes_allocated += size;
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void *counted_aligned_alloc(std::size_t size, std::align_val_t align) noexcept {
+    ++t_stats.allocations;
+    t_stats.bytes_allocated += size;
+    const auto alignment = static_cast<std::size_t>(align);
+    // aligned_alloc requires the size to be a multiple of the alignment
+    const auto rounded = (size + alignment - 1) / alignment * alignment;
+    return std::aligned_alloc(alignment, rounded == 0 ? alignment : rounded);
+}
+
+void counted_free(void *ptr) noexcept {
+    if (ptr != nullptr) {
+        ++t_stats.deallocations;
+        std::free(ptr);
+    }
+}
+} // namespace
+
+namespace proto::bench {
+AllocationStats allocation_stats() noexcept { return t_stats; }
+} // namespace proto::bench
+
+void *operator new(std::size_t size) {
+    if (void *ptr = counted_alloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void *operator new[](std::size_t size) {
+    if (void *ptr = counted_alloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    return counted_alloc(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return counted_alloc(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t align) {
+    if (void *ptr = counted_aligned_alloc(size, align)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void *operator new[](std::size_t size, std::align_val_t align) {
+    if (void *ptr = counted_aligned_alloc(size, align)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void *ptr) noexcept { counted_free(ptr); }
+void operator delete[](void *ptr) noexcept { counted_free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { counted_free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { counted_free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept {
+    counted_free(ptr);
+}
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+    counted_free(ptr);
+}
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept {
+    counted_free(ptr);
+}
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept {
+    counted_free(ptr);
+}
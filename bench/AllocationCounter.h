@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+
+namespace proto::bench {
+
+// Counters maintained by the replacement global operator new/delete in
+// AllocationCounter.cpp. Counts are kept per thread so that background
+// threads (e.g. the test runner's) do not pollute a measurement.
+struct AllocationStats {
+    std::size_t allocations{};
+    std::size_t deallocations{};
+    std::size_t bytes_allocated{};
+};
+
+[[nodiscard]] AllocationStats allocation_stats() noexcept;
+
+// Records the allocations made on the current thread between construction
+// and the call to stats()
+class AllocationScope {
+  public:
+    AllocationScope() noexcept : m_start(allocation_stats()) {}
+
+    [[nodiscard]] AllocationStats stats() const noexcept {
+        const auto now = allocation_stats();
+        return AllocationStats{
+            now.allocations - m_start.allocations,
+            now.deallocations - m_start.deallocations,
+            now.bytes_allocated - m_start.bytes_allocated,
+        };
+    }
+
+  private:
+    AllocationStats m_start;
+};
+
+} // namespace proto::bench
@@ -0,0 +1,426 @@
+#include "AllocationCounter.h"
+#include "TestTypes.h"
+
+#include <protobuf-cpp/BufferPool.h>
+#include <protobuf-cpp/Columnar.h>
+#include <protobuf-cpp/Crc32c.h>
+#include <protobuf-cpp/Deserialize.h>
+#include <protobuf-cpp/Extract.h>
+#include <protobuf-cpp/Fingerprint.h>
+#include <protobuf-cpp/Framing.h>
+#include <protobuf-cpp/Json.h>
+#include <protobuf-cpp/Packed.h>
+#include <protobuf-cpp/Ring.h>
+#include <protobuf-cpp/Serialize.h>
+#include <protobuf-cpp/Utf8.h>
+#include <protobuf-cpp/Validate.h>
+#include <protobuf-cpp/Varint.h>
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+// Report allocations and allocated bytes per iteration alongside the timings
+class AllocationCounters {
+  public:
+    explicit AllocationCounters(benchmark::State &state) : m_state(state) {}
+
+    AllocationCounters(const AllocationCounters &) = delete;
+    AllocationCounters &operator=(const AllocationCounters &) = delete;
+
+    ~AllocationCounters() {
+        const auto stats = m_scope.stats();
+        m_state.counters["allocs/op"] =
+            benchmark::Counter(static_cast<double>(stats.allocations),
+                               benchmark::Counter::kAvgIterations);
+        m_state.counters["alloc_bytes/op"] =
+            benchmark::Counter(static_cast<double>(stats.bytes_allocated),
+                               benchmark::Counter::kAvgIterations);
+    }
+
+  private:
+    benchmark::State &m_state;
+    proto::bench::AllocationScope m_scope;
+};
+
+void BM_varint_serialize(benchmark::State &state) {
+    std::array<std::byte, 10> buffer{};
+    proto::Varint varint{static_cast<std::uint64_t>(state.range(0))};
+
+    AllocationCounters counters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(varint.serialize(buffer));
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_varint_serialize)->Arg(1)->Arg(150)->Arg(1LL << 62);
+
+void BM_varint_deserialize(benchmark::State &state) {
+    std::array<std::byte, 10> buffer{};
+    proto::Varint{static_cast<std::uint64_t>(state.range(0))}.serialize(buffer);
+
+    AllocationCounters counters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(proto::Varint::deserialize(buffer));
+    }
+}
+BENCHMARK(BM_varint_deserialize)->Arg(1)->Arg(150)->Arg(1LL << 62);
+
+void BM_varint_deserialize_as_uint32(benchmark::State &state) {
+    std::array<std::byte, 10> buffer{};
+    proto::Varint{static_cast<std::uint32_t>(state.range(0))}.serialize(buffer);
+
+    AllocationCounters counters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            proto::Varint::deserialize_as<std::uint32_t>(buffer));
+    }
+}
+BENCHMARK(BM_varint_deserialize_as_uint32)->Arg(1)->Arg(150)->Arg(1LL << 31);
+
+void BM_serialize_doubleint_span(benchmark::State &state) {
+    const test::DoubleInt original{42, -150};
+    std::array<std::byte, 32> buffer{};
+
+    AllocationCounters counters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(proto::serialize(original, buffer));
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_serialize_doubleint_span);
+
+void BM_serialize_doubleint_vector(benchmark::State &state) {
+    const test::DoubleInt original{42, -150};
+
+    AllocationCounters counters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(proto::serialize(original));
+    }
+}
+BENCHMARK(BM_serialize_doubleint_vector);
+
+void BM_serialize_doubleint_pooled(benchmark::State &state) {
+    const test::DoubleInt original{42, -150};
+    auto &pool = proto::BufferPool::local();
+
+    AllocationCounters counters(state);
+    for (auto _ : state) {
+        auto pooled = proto::serialize(original, pool);
+        benchmark::DoNotOptimize(pooled.data());
+    }
+}
+BENCHMARK(BM_serialize_doubleint_pooled);
+
+void BM_deserialize_doubleint(benchmark::State &state) {
+    const auto serialized = proto::serialize(test::DoubleInt{42, -150});
+
+    AllocationCounters counters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            proto::deserialize<test::DoubleInt>(serialized));
+    }
+}
+BENCHMARK(BM_deserialize_doubleint);
+
+// Same message through the fused and the per-member codecs
+template <typename T> void BM_serialize_telemetry(benchmark::State &state) {
+    const T telemetry{7, 52.5, 13.4, 34.0f, -90, 3};
+    std::array<std::byte, 64> buffer{};
+
+    AllocationCounters counters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(proto::serialize(telemetry, buffer));
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_serialize_telemetry<test::Telemetry>);
+BENCHMARK(BM_serialize_telemetry<test::TelemetryPerMember>);
+
+template <typename T> void BM_deserialize_telemetry(benchmark::State &state) {
+    const auto serialized =
+        proto::serialize(T{7, 52.5, 13.4, 34.0f, -90, 3});
+
+    AllocationCounters counters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(proto::deserialize<T>(serialized));
+    }
+}
+BENCHMARK(BM_deserialize_telemetry<test::Telemetry>);
+BENCHMARK(BM_deserialize_telemetry<test::TelemetryPerMember>);
+
+void BM_deserialize_routing_table(benchmark::State &state) {
+    test::RoutingTable table{};
+    for (std::int64_t i = 0; i < state.range(0); i++) {
+        table.names[static_cast<std::uint64_t>(i)] = std::to_string(i);
+        table.weights[static_cast<std::int32_t>(i)] = 0.5;
+    }
+    const auto serialized = proto::serialize(table);
+
+    AllocationCounters counters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            proto::deserialize<test::RoutingTable>(serialized));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_deserialize_routing_table)->Arg(100'000);
+
+// Validation of the same input, which decodes no values
+void BM_validate_routing_table(benchmark::State &state) {
+    test::RoutingTable table{};
+    for (std::int64_t i = 0; i < state.range(0); i++) {
+        table.names[static_cast<std::uint64_t>(i)] = std::to_string(i);
+        table.weights[static_cast<std::int32_t>(i)] = 0.5;
+    }
+    const auto serialized = proto::serialize(table);
+
+    AllocationCounters counters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            proto::validate<test::RoutingTable>(serialized));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() *
+                            static_cast<std::int64_t>(serialized.size()));
+}
+BENCHMARK(BM_validate_routing_table)->Arg(100'000);
+
+void BM_transcode_json_doubleint(benchmark::State &state) {
+    const auto serialized = proto::serialize(test::DoubleInt{42, -150});
+    std::string out;
+
+    AllocationCounters counters(state);
+    for (auto _ : state) {
+        out.clear();
+        proto::transcode_json<test::DoubleInt>(serialized, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(BM_transcode_json_doubleint);
+
+std::vector<std::byte> make_doubleint_frames(std::size_t count) {
+    std::vector<std::byte> frames;
+    for (std::size_t i = 0; i < count; i++) {
+        proto::serialize_delimited(
+            test::DoubleInt{static_cast<std::uint32_t>(i),
+                            -static_cast<std::int32_t>(i)},
+            frames);
+    }
+    return frames;
+}
+
+void BM_column_by_deserialize(benchmark::State &state) {
+    const auto frames =
+        make_doubleint_frames(static_cast<std::size_t>(state.range(0)));
+
+    AllocationCounters counters(state);
+    for (auto _ : state) {
+        std::vector<std::int32_t> column;
+        for (auto frame : proto::split_frames(frames)) {
+            column.push_back(
+                proto::deserialize<test::DoubleInt>(frame).value2);
+        }
+        benchmark::DoNotOptimize(column.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_column_by_deserialize)->Arg(100'000);
+
+void BM_column_by_extract(benchmark::State &state) {
+    const auto frames =
+        make_doubleint_frames(static_cast<std::size_t>(state.range(0)));
+    const auto num_threads = static_cast<std::size_t>(state.range(1));
+
+    AllocationCounters counters(state);
+    for (auto _ : state) {
+        auto column = proto::extract_member<&test::DoubleInt::value2>(
+            frames, num_threads);
+        benchmark::DoNotOptimize(column.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_column_by_extract)->Args({100'000, 1})->Args({100'000, 4});
+
+std::vector<test::IntAndFloat_asFixed> make_records(std::size_t count) {
+    std::vector<test::IntAndFloat_asFixed> records;
+    for (std::size_t i = 0; i < count; i++) {
+        records.push_back({static_cast<std::int32_t>(i),
+                           static_cast<float>(i) * 0.5f});
+    }
+    return records;
+}
+
+void BM_batch_encode_framed(benchmark::State &state) {
+    const auto records = make_records(static_cast<std::size_t>(state.range(0)));
+
+    AllocationCounters counters(state);
+    for (auto _ : state) {
+        std::vector<std::byte> frames;
+        for (const auto &record : records) {
+            proto::serialize_delimited(record, frames);
+        }
+        benchmark::DoNotOptimize(frames.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_batch_encode_framed)->Arg(100'000);
+
+void BM_batch_encode_columnar(benchmark::State &state) {
+    const auto records = make_records(static_cast<std::size_t>(state.range(0)));
+
+    AllocationCounters counters(state);
+    for (auto _ : state) {
+        auto columns = proto::serialize_columnar(std::span{records});
+        benchmark::DoNotOptimize(columns.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_batch_encode_columnar)->Arg(100'000);
+
+void BM_batch_decode_columnar(benchmark::State &state) {
+    const auto records = make_records(static_cast<std::size_t>(state.range(0)));
+    const auto columns = proto::serialize_columnar(std::span{records});
+
+    AllocationCounters counters(state);
+    for (auto _ : state) {
+        auto decoded =
+            proto::deserialize_columns<test::IntAndFloat_asFixed>(columns);
+        benchmark::DoNotOptimize(std::get<0>(decoded).data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_batch_decode_columnar)->Arg(100'000);
+
+void BM_packed_encode_parallel(benchmark::State &state) {
+    std::vector<std::uint64_t> values(static_cast<std::size_t>(state.range(0)));
+    for (std::size_t i = 0; i < values.size(); i++) {
+        values[i] = i * i;
+    }
+    const auto num_threads = static_cast<std::size_t>(state.range(1));
+
+    AllocationCounters counters(state);
+    for (auto _ : state) {
+        auto field = proto::serialize_packed_parallel<proto::Varint>(
+            proto::Field{1}, values, num_threads);
+        benchmark::DoNotOptimize(field.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_packed_encode_parallel)
+    ->Args({10'000'000, 1})
+    ->Args({10'000'000, 4})
+    ->UseRealTime();
+
+// Mostly-ASCII text with a multi-byte sequence every 64 bytes
+std::string make_text(std::size_t size) {
+    std::string text;
+    while (text.size() < size) {
+        text += std::string(62, 'a');
+        text += "\xc3\xa9";
+    }
+    text.resize(size);
+    return text;
+}
+
+void BM_utf8_validate(benchmark::State &state) {
+    const auto text = make_text(static_cast<std::size_t>(state.range(0)));
+    const auto data = std::as_bytes(std::span{text.data(), text.size()});
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(proto::is_valid_utf8(data));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_utf8_validate)->Arg(64)->Arg(64 * 1024);
+
+void BM_utf8_validate_scalar(benchmark::State &state) {
+    const auto text = make_text(static_cast<std::size_t>(state.range(0)));
+    const auto data = std::as_bytes(std::span{text.data(), text.size()});
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(proto::is_valid_utf8_scalar(data));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_utf8_validate_scalar)->Arg(64)->Arg(64 * 1024);
+
+void BM_crc32c(benchmark::State &state) {
+    const std::vector<std::byte> data(static_cast<std::size_t>(state.range(0)),
+                                      std::byte{0x5a});
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(proto::crc32c(data));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_crc32c)->Arg(64)->Arg(64 * 1024);
+
+void BM_crc32c_portable(benchmark::State &state) {
+    const std::vector<std::byte> data(static_cast<std::size_t>(state.range(0)),
+                                      std::byte{0x5a});
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(proto::crc32c_portable(data));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_crc32c_portable)->Arg(64)->Arg(64 * 1024);
+
+// Fingerprint as a second pass over the output versus during encoding
+void BM_serialize_then_fingerprint(benchmark::State &state) {
+    const test::Document document{
+        1, std::string(static_cast<std::size_t>(state.range(0)), 't'), "body",
+        std::string(static_cast<std::size_t>(state.range(0)), 'r')};
+    std::vector<std::byte> buffer(proto::serialized_size(document));
+    for (auto _ : state) {
+        proto::serialize(document, std::span<std::byte>{buffer});
+        benchmark::DoNotOptimize(proto::fingerprint(buffer));
+    }
+    state.SetBytesProcessed(state.iterations() *
+                            static_cast<std::int64_t>(buffer.size()));
+}
+BENCHMARK(BM_serialize_then_fingerprint)->Arg(64)->Arg(1 << 20);
+
+void BM_serialize_fingerprinted(benchmark::State &state) {
+    const test::Document document{
+        1, std::string(static_cast<std::size_t>(state.range(0)), 't'), "body",
+        std::string(static_cast<std::size_t>(state.range(0)), 'r')};
+    std::vector<std::byte> buffer(proto::serialized_size(document));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(proto::serialize_fingerprinted(
+            document, std::span<std::byte>{buffer}));
+    }
+    state.SetBytesProcessed(state.iterations() *
+                            static_cast<std::int64_t>(buffer.size()));
+}
+BENCHMARK(BM_serialize_fingerprinted)->Arg(64)->Arg(1 << 20);
+
+// Producer and consumer on one thread: the cost of a message through the
+// ring without any cross-core traffic
+void BM_ring_roundtrip(benchmark::State &state) {
+    struct alignas(64) Memory {
+        std::array<std::byte, proto::ring_memory_size(64 * 1024)> bytes;
+    };
+    auto memory = std::make_unique<Memory>();
+    proto::initialize_ring(memory->bytes);
+    proto::RingProducer producer{memory->bytes};
+    proto::RingConsumer consumer{memory->bytes};
+    const test::DoubleInt message{150, -3};
+    test::DoubleInt received{};
+
+    AllocationCounters counters(state);
+    for (auto _ : state) {
+        proto::try_write(producer, message);
+        proto::try_read(consumer, received);
+        benchmark::DoNotOptimize(received);
+    }
+}
+BENCHMARK(BM_ring_roundtrip);
+
+} // namespace
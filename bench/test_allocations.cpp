@@ -0,0 +1,163 @@
+#include "AllocationCounter.h"
+#include "TestTypes.h"
+
+#include <protobuf-cpp/BufferPool.h>
+#include <protobuf-cpp/Deserialize.h>
+#include <protobuf-cpp/Fixint.h>
+#include <protobuf-cpp/Patch.h>
+#include <protobuf-cpp/Record.h>
+#include <protobuf-cpp/Serialize.h>
+#include <protobuf-cpp/Validate.h>
+#include <protobuf-cpp/Varint.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+using proto::bench::AllocationScope;
+
+TEST(Allocations, counter_observes_allocations) {
+    AllocationScope scope;
+    {
+        std::vector<std::byte> buffer(64);
+        ASSERT_EQ(buffer.size(), 64);
+    }
+    auto stats = scope.stats();
+    ASSERT_EQ(stats.allocations, 1);
+    ASSERT_EQ(stats.deallocations, 1);
+    ASSERT_EQ(stats.bytes_allocated, 64);
+}
+
+TEST(Allocations, varint_roundtrip_in_span_allocates_nothing) {
+    std::array<std::byte, 10> buffer{};
+
+    AllocationScope scope;
+    auto num_bytes_written = proto::Varint{150u}.serialize(buffer);
+    auto deserialized = proto::Varint::deserialize(buffer);
+    auto stats = scope.stats();
+
+    ASSERT_EQ(deserialized.num_bytes_read, num_bytes_written);
+    ASSERT_EQ(stats.allocations, 0);
+}
+
+TEST(Allocations, record_roundtrip_in_span_allocates_nothing) {
+    std::array<std::byte, 16> buffer{};
+    const proto::Record record{proto::Field{1}, proto::Fixint64{42}};
+
+    AllocationScope scope;
+    auto num_bytes_written = record.serialize(buffer);
+    auto deserialized = proto::Record<proto::Fixint64>::deserialize(buffer);
+    auto stats = scope.stats();
+
+    ASSERT_EQ(deserialized.num_bytes_read, num_bytes_written);
+    ASSERT_EQ(stats.allocations, 0);
+}
+
+TEST(Allocations, serialize_doubleint_into_span_allocates_nothing) {
+    constexpr test::DoubleInt original{42, -150};
+    std::array<std::byte, 32> buffer{};
+
+    AllocationScope scope;
+    auto num_bytes_written = proto::serialize(original, buffer);
+    auto stats = scope.stats();
+
+    ASSERT_EQ(num_bytes_written, proto::serialized_size(original));
+    ASSERT_EQ(stats.allocations, 0);
+}
+
+TEST(Allocations, serialize_string_members_into_span_allocates_nothing) {
+    const test::Document original{7, "a title long enough to be heap allocated",
+                                  "body", "raw bytes"};
+    std::array<std::byte, 128> buffer{};
+
+    AllocationScope scope;
+    auto num_bytes_written = proto::serialize(original, buffer);
+    auto stats = scope.stats();
+
+    ASSERT_EQ(num_bytes_written, proto::serialized_size(original));
+    ASSERT_EQ(stats.allocations, 0);
+}
+
+TEST(Allocations, serialize_doubleint_into_vector_allocates_once) {
+    constexpr test::DoubleInt original{42, -150};
+
+    AllocationScope scope;
+    auto serialized = proto::serialize(original);
+    auto stats = scope.stats();
+
+    ASSERT_EQ(stats.allocations, 1);
+    ASSERT_EQ(stats.bytes_allocated, serialized.size());
+}
+
+TEST(Allocations, deserialize_doubleint_allocates_nothing) {
+    constexpr test::DoubleInt original{42, -150};
+    auto serialized = proto::serialize(original);
+
+    AllocationScope scope;
+    auto deserialized = proto::deserialize<test::DoubleInt>(serialized);
+    auto stats = scope.stats();
+
+    ASSERT_EQ(deserialized, original);
+    ASSERT_EQ(stats.allocations, 0);
+}
+
+TEST(Allocations, int_and_float_roundtrip_in_span_allocates_nothing) {
+    constexpr test::IntAndFloat_asFixed original{-1, 0.5f};
+    std::array<std::byte, 32> buffer{};
+
+    AllocationScope scope;
+    auto num_bytes_written = proto::serialize(original, buffer);
+    auto deserialized = proto::deserialize<test::IntAndFloat_asFixed>(
+        std::span{buffer}.first(num_bytes_written));
+    auto stats = scope.stats();
+
+    ASSERT_EQ(deserialized, original);
+    ASSERT_EQ(stats.allocations, 0);
+}
+
+TEST(Allocations, serialize_doubleint_into_warm_pool_allocates_nothing) {
+    constexpr test::DoubleInt original{42, -150};
+    auto &pool = proto::BufferPool::local();
+    // Warm up the size class
+    pool.acquire(proto::serialized_size(original)).reset();
+
+    AllocationScope scope;
+    {
+        auto pooled = proto::serialize(original, pool);
+        ASSERT_EQ(pooled.size(), proto::serialized_size(original));
+    }
+    auto stats = scope.stats();
+
+    ASSERT_EQ(stats.allocations, 0);
+}
+
+TEST(Allocations, patch_counter_in_place_allocates_nothing) {
+    std::array<std::byte, 32> buffer{};
+    auto size = proto::serialize(test::DoubleInt{42, -150}, buffer);
+
+    AllocationScope scope;
+    size = proto::patch_member<&test::DoubleInt::value1>(buffer, size, 43);
+    size = proto::patch_member<&test::DoubleInt::value1>(buffer, size, 70'000);
+    auto stats = scope.stats();
+
+    ASSERT_EQ(proto::deserialize<test::DoubleInt>(
+                  std::span{buffer}.first(size)),
+              (test::DoubleInt{70'000, -150}));
+    ASSERT_EQ(stats.allocations, 0);
+}
+
+TEST(Allocations, validate_allocates_nothing) {
+    test::RoutingTable table{};
+    table.routes["a"] = 1;
+    table.names[2] = "b";
+    const auto serialized = proto::serialize(table);
+
+    AllocationScope scope;
+    const auto validation = proto::validate<test::RoutingTable>(serialized);
+    auto stats = scope.stats();
+
+    ASSERT_TRUE(validation);
+    ASSERT_EQ(stats.allocations, 0);
+}
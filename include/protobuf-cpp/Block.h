@@ -0,0 +1,275 @@
+#pragma once
+
+#include "Deserialize.h"
+#include "Encoding.h"
+#include "Framing.h"
+#include "Packed.h"
+#include "Serialize.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace proto {
+
+// Block-compressed message files. Messages are written as length-delimited
+// frames (see Framing.h) and grouped into blocks of roughly a given size.
+// Every block is compressed on its own, so blocks can be decompressed and
+// decoded independently, on as many threads as there are blocks, and an
+// index at the end of the file locates every block without a scan:
+//
+//     file:    block... index trailer
+//     block:   codec (1 byte), uncompressed size (fixed32), compressed size
+//              (fixed32), CRC32C of the compressed bytes (fixed32), then the
+//              compressed frames
+//     index:   one delimited frame per block, holding a BlockInfo
+//     trailer: offset of the index (fixed64), k_block_file_magic (fixed32)
+//
+// Blocks that do not shrink when compressed are stored as they are.
+
+// Compression codecs. Lz4 and Zstd are only available if the library was
+// built against them (the WITH_LZ4 and WITH_ZSTD CMake options, on by
+// default, when the system packages are found).
+enum class BlockCodec : std::uint8_t { Stored = 0, Lz4 = 1, Zstd = 2 };
+
+[[nodiscard]] bool is_available(BlockCodec codec) noexcept;
+
+// The best codec the library was built with: Zstd, then Lz4, then Stored
+[[nodiscard]] BlockCodec default_block_codec() noexcept;
+
+inline constexpr std::size_t k_block_header_size = 13;
+inline constexpr std::uint32_t k_block_file_magic = 0x4b4c4250; // "PBLK"
+inline constexpr std::size_t k_block_trailer_size = 12;
+// Largest uncompressed block written or read, which bounds what a corrupt
+// block header can make a reader allocate
+inline constexpr std::size_t k_max_block_size = 64 * 1024 * 1024;
+
+// Compress `data` into a block appended to `out`, header included. Throws
+// std::logic_error if `codec` is not available, and std::runtime_error if
+// `data` is larger than k_max_block_size.
+void append_block(std::span<const std::byte> data, BlockCodec codec,
+                  std::vector<std::byte> &out);
+
+// Size of the block at the start of `data`, header included. Throws
+// std::runtime_error if `data` does not start with a whole block.
+[[nodiscard]] std::size_t block_size(std::span<const std::byte> data);
+
+// Decompress the block at the start of `block` into `out`, replacing its
+// contents, and return the frames it holds. Throws std::runtime_error on a
+// corrupt block or if its codec is not available.
+std::span<const std::byte> decompress_block(std::span<const std::byte> block,
+                                            std::vector<std::byte> &out);
+
+// Index entry of one block
+struct BlockInfo {
+    // Position and size of the block in the file, header included
+    std::uint64_t offset;
+    std::uint64_t size;
+    // Position of the block's first message among all the messages of the
+    // file, and the number of messages in the block
+    std::uint64_t first_message;
+    std::uint32_t num_messages;
+
+    using members =
+        Members<&BlockInfo::offset, &BlockInfo::size,
+                &BlockInfo::first_message, &BlockInfo::num_messages>;
+
+    auto operator<=>(const BlockInfo &) const = default;
+};
+
+// Writes messages into a block-compressed file. Blocks are written to the
+// file descriptor as they fill up; finish() writes the last block and the
+// index, and must be called for the file to be readable. The file descriptor
+// is not owned.
+class BlockWriter {
+  public:
+    static constexpr std::size_t k_default_block_size = 256 * 1024;
+
+    // Throws std::logic_error if `codec` is not available or `block_size` is
+    // larger than k_max_block_size
+    explicit BlockWriter(int fd, BlockCodec codec = default_block_codec(),
+                         std::size_t block_size = k_default_block_size);
+
+    BlockWriter(const BlockWriter &) = delete;
+    BlockWriter &operator=(const BlockWriter &) = delete;
+
+    // Append `obj` to the block being filled. Throws std::runtime_error,
+    // leaving the writer as it was, if its frame is larger than
+    // k_max_block_size.
+    template <typename T> void write(const T &obj) {
+        const auto frame_size = serialized_delimited_size(obj);
+        if (frame_size > k_max_block_size) {
+            throw std::runtime_error("Message too large for a block");
+        }
+        // Blocks never grow past k_max_block_size, so they can be written
+        if (m_frames.size() + frame_size > k_max_block_size) {
+            flush_block();
+        }
+        const auto offset = m_frames.size();
+        m_frames.resize(offset + frame_size);
+        serialize_delimited(obj, std::span{m_frames}.subspan(offset));
+        m_num_frames++;
+        if (m_frames.size() >= m_block_size) {
+            flush_block();
+        }
+    }
+
+    // Write the pending block, the index and the trailer. Throws
+    // std::system_error on write errors.
+    void finish();
+
+    [[nodiscard]] std::uint64_t num_messages() const noexcept {
+        return m_num_messages + m_num_frames;
+    }
+
+  private:
+    void flush_block();
+
+    int m_fd;
+    BlockCodec m_codec;
+    std::size_t m_block_size;
+
+    // Frames of the block being filled
+    std::vector<std::byte> m_frames;
+    std::uint32_t m_num_frames{};
+    // Reused for every compressed block
+    std::vector<std::byte> m_block;
+
+    std::uint64_t m_offset{};
+    std::uint64_t m_num_messages{};
+    std::vector<BlockInfo> m_index;
+};
+
+// Read-only view of a whole block-compressed file, e.g. mapped into memory.
+// The file must outlive the view.
+class BlockFile {
+  public:
+    // Throws std::runtime_error if the trailer or the index is malformed
+    explicit BlockFile(std::span<const std::byte> file);
+
+    [[nodiscard]] std::size_t num_blocks() const noexcept {
+        return m_index.size();
+    }
+    [[nodiscard]] std::uint64_t num_messages() const noexcept;
+    [[nodiscard]] const BlockInfo &block(std::size_t index) const {
+        return m_index.at(index);
+    }
+
+    // Index of the block holding message number `message`. Throws
+    // std::out_of_range past the last message.
+    [[nodiscard]] std::size_t find_block(std::uint64_t message) const;
+
+    // Decompress block `index` into `out` and return its frames
+    std::span<const std::byte> read_block(std::size_t index,
+                                          std::vector<std::byte> &out) const;
+
+  private:
+    std::span<const std::byte> m_file;
+    std::vector<BlockInfo> m_index;
+};
+
+namespace detail {
+// Number of frames in `frames`. Throws std::runtime_error if it ends in a
+// partial frame.
+inline std::size_t count_block_frames(std::span<const std::byte> frames) {
+    std::size_t count = 0;
+    while (!frames.empty()) {
+        const auto frame = read_frame(frames);
+        if (frame.num_bytes_read == 0) {
+            throw std::runtime_error("Error parsing frame");
+        }
+        frames = frames.subspan(frame.num_bytes_read);
+        count++;
+    }
+    return count;
+}
+
+// Decode one message per frame of `frames` into `out`, which must hold as
+// many elements as there are frames
+template <typename T>
+void decode_block_frames(std::span<const std::byte> frames, std::span<T> out) {
+    for (auto &message : out) {
+        auto frame = read_frame(frames);
+        if (frame.num_bytes_read == 0) {
+            throw std::runtime_error("Error parsing frame");
+        }
+        message = T{};
+        merge(frame.value, message);
+        frames = frames.subspan(frame.num_bytes_read);
+    }
+    if (!frames.empty()) {
+        throw std::runtime_error("Block message count mismatch");
+    }
+}
+} // namespace detail
+
+// Decode the messages of block `index` into `out`, which must hold
+// block(index).num_messages elements. `scratch` receives the decompressed
+// frames; view members of the messages point into it.
+template <typename T>
+void decode_block(const BlockFile &file, std::size_t index, std::span<T> out,
+                  std::vector<std::byte> &scratch) {
+    auto frames = file.read_block(index, scratch);
+    if (out.size() != file.block(index).num_messages) {
+        throw std::runtime_error("Block message count mismatch");
+    }
+    detail::decode_block_frames(frames, out);
+}
+
+// Decode the messages of block `index` into a new vector. Unlike the index,
+// which is only trusted once the block has been decompressed, the number of
+// frames bounds what is allocated for the messages.
+template <typename T>
+std::vector<T> decode_block(const BlockFile &file, std::size_t index,
+                            std::vector<std::byte> &scratch) {
+    auto frames = file.read_block(index, scratch);
+    const auto num_messages = detail::count_block_frames(frames);
+    if (num_messages != file.block(index).num_messages) {
+        throw std::runtime_error("Block message count mismatch");
+    }
+    std::vector<T> messages(num_messages);
+    detail::decode_block_frames(frames, std::span{messages});
+    return messages;
+}
+
+// Decode every message of the file, in order, decompressing and decoding
+// blocks on up to `num_threads` threads. T must not have view members, as
+// the decompressed blocks do not outlive the call.
+template <typename T>
+std::vector<T>
+decode_blocks(const BlockFile &file,
+              std::size_t num_threads = std::thread::hardware_concurrency()) {
+    static_assert(!has_view_members<T>(),
+                  "Views would reference freed decompression buffers");
+    // Blocks are decoded on their own and concatenated afterwards, as
+    // num_messages() comes from the untrusted index
+    std::vector<std::vector<T>> blocks(file.num_blocks());
+    const auto num_chunks = std::clamp<std::size_t>(
+        num_threads, 1, std::max<std::size_t>(file.num_blocks(), 1));
+    run_parallel_chunks(
+        file.num_blocks(), num_chunks,
+        [&](std::size_t, std::size_t begin, std::size_t end) {
+            std::vector<std::byte> scratch;
+            for (auto index = begin; index < end; index++) {
+                blocks[index] = decode_block<T>(file, index, scratch);
+            }
+        });
+
+    std::size_t num_messages = 0;
+    for (const auto &block : blocks) {
+        num_messages += block.size();
+    }
+    std::vector<T> messages;
+    messages.reserve(num_messages);
+    for (auto &block : blocks) {
+        std::ranges::move(block, std::back_inserter(messages));
+    }
+    return messages;
+}
+
+} // namespace proto
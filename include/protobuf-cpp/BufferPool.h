@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+
+namespace proto {
+
+class PooledBuffer;
+
+// Per-thread cache of reusable output buffers, bucketed into power-of-two
+// size classes. Buffers released on the thread that acquired them go straight
+// back onto that thread's free list; buffers released on any other thread are
+// pushed onto a lock-free return stack that the owner drains on its next miss.
+class BufferPool {
+  public:
+    static constexpr std::size_t k_min_size_class = 64;
+    static constexpr std::size_t k_num_size_classes = 11;
+    // Larger requests are allocated and freed directly
+    static constexpr std::size_t k_max_pooled_size =
+        k_min_size_class << (k_num_size_classes - 1);
+    static constexpr std::size_t k_max_cached_per_class = 64;
+
+    // The calling thread's pool. A pool must only be used to acquire buffers
+    // on its own thread; the buffers themselves may be released anywhere.
+    static BufferPool &local();
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+    ~BufferPool();
+
+    [[nodiscard]] PooledBuffer acquire(std::size_t size);
+
+    // Number of buffers currently sitting in this thread's free lists
+    [[nodiscard]] std::size_t cached_buffers() const noexcept;
+
+    struct Block;
+    struct Cache;
+
+  private:
+    friend class PooledBuffer;
+
+    BufferPool();
+
+    static void release(Block *block) noexcept;
+
+    Cache *m_cache;
+};
+
+// Move-only handle to a buffer from a BufferPool. The storage is returned to
+// the pool it came from when the handle is destroyed.
+class PooledBuffer {
+  public:
+    constexpr PooledBuffer() = default;
+
+    PooledBuffer(PooledBuffer &&other) noexcept
+        : m_block(other.m_block), m_data(other.m_data), m_size(other.m_size) {
+        other.m_block = nullptr;
+        other.m_data = nullptr;
+        other.m_size = 0;
+    }
+
+    PooledBuffer &operator=(PooledBuffer &&other) noexcept {
+        if (this != &other) {
+            reset();
+            m_block = other.m_block;
+            m_data = other.m_data;
+            m_size = other.m_size;
+            other.m_block = nullptr;
+            other.m_data = nullptr;
+            other.m_size = 0;
+        }
+        return *this;
+    }
+
+    ~PooledBuffer() { reset(); }
+
+    void reset() noexcept {
+        if (m_block != nullptr) {
+            BufferPool::release(m_block);
+            m_block = nullptr;
+            m_data = nullptr;
+            m_size = 0;
+        }
+    }
+
+    [[nodiscard]] std::byte *data() noexcept { return m_data; }
+    [[nodiscard]] const std::byte *data() const noexcept { return m_data; }
+    [[nodiscard]] std::size_t size() const noexcept { return m_size; }
+    [[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+
+    [[nodiscard]] std::byte *begin() noexcept { return m_data; }
+    [[nodiscard]] std::byte *end() noexcept { return m_data + m_size; }
+    [[nodiscard]] const std::byte *begin() const noexcept { return m_data; }
+    [[nodiscard]] const std::byte *end() const noexcept {
+        return m_data + m_size;
+    }
+
+    [[nodiscard]] std::span<std::byte> span() noexcept {
+        return {m_data, m_size};
+    }
+    [[nodiscard]] std::span<const std::byte> span() const noexcept {
+        return {m_data, m_size};
+    }
+
+  private:
+    friend class BufferPool;
+
+    PooledBuffer(BufferPool::Block *block, std::byte *data,
+                 std::size_t size) noexcept
+        : m_block(block), m_data(data), m_size(size) {}
+
+    BufferPool::Block *m_block{};
+    std::byte *m_data{};
+    std::size_t m_size{};
+};
+
+} // namespace proto
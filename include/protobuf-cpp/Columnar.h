@@ -0,0 +1,207 @@
+#pragma once
+
+#include "Encoding.h"
+#include "Field.h"
+#include "Packed.h"
+#include "Tokenizer.h"
+#include "Varint.h"
+#include "WireType.h"
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace proto {
+
+// Columnar (struct-of-arrays) batch encoding. A batch of records of type T is
+// encoded as one message in which every member of T::members becomes a packed
+// repeated field holding that member's value for every record, in record
+// order. The result is an ordinary protobuf message, equivalent to
+//
+//     message TBatch { repeated M1 member1 = 1; repeated M2 member2 = 2; ... }
+
+template <typename T> struct ColumnsOf;
+
+template <auto... Ptrs> struct ColumnsOf<Members<Ptrs...>> {
+    using type = std::tuple<std::vector<
+        typename MemberPointerTraits<decltype(Ptrs)>::member_type>...>;
+};
+
+// One std::vector per member of T, in the order of T::members
+template <typename T>
+using Columns = typename ColumnsOf<typename T::members>::type;
+
+template <auto MemberPtr>
+concept PackableMember =
+    std::is_arithmetic_v<
+        typename MemberPointerTraits<decltype(MemberPtr)>::member_type> &&
+    (std::is_same_v<typename MemberEncoding<MemberPtr>::type, Varint> ||
+     std::is_same_v<typename MemberEncoding<MemberPtr>::type, Fixint32> ||
+     std::is_same_v<typename MemberEncoding<MemberPtr>::type, Fixint64>);
+
+template <auto MemberPtr, typename T>
+constexpr auto member_column(std::span<const T> records) {
+    static_assert(PackableMember<MemberPtr>,
+                  "Columnar encoding requires scalar members");
+    return records | std::views::transform(
+                         [](const T &record) { return record.*MemberPtr; });
+}
+
+template <typename T>
+constexpr std::size_t serialized_columnar_size(std::span<const T> records) {
+    if (records.empty()) {
+        return 0;
+    }
+    std::size_t size = 0;
+    for_each_member<T>([&]<auto MemberPtr, std::size_t Index>() {
+        size += packed_size<typename MemberEncoding<MemberPtr>::type>(
+            Field{Index + 1}, member_column<MemberPtr>(records));
+    });
+    return size;
+}
+
+template <typename T>
+std::size_t serialize_columnar(std::span<const T> records,
+                               std::span<std::byte> buffer) {
+    if (buffer.size() < serialized_columnar_size(records)) {
+        throw std::runtime_error("Buffer too small to serialize columns");
+    }
+    if (records.empty()) {
+        return 0;
+    }
+
+    std::size_t num_bytes_written = 0;
+    for_each_member<T>([&]<auto MemberPtr, std::size_t Index>() {
+        num_bytes_written +=
+            serialize_packed<typename MemberEncoding<MemberPtr>::type>(
+                Field{Index + 1}, member_column<MemberPtr>(records),
+                buffer.subspan(num_bytes_written));
+    });
+    return num_bytes_written;
+}
+
+template <typename T>
+std::vector<std::byte> serialize_columnar(std::span<const T> records) {
+    std::vector<std::byte> buffer(serialized_columnar_size(records));
+    serialize_columnar(records, std::span<std::byte>{buffer});
+    return buffer;
+}
+
+// Payload segments of every column, and the number of records they hold
+template <typename T> struct ColumnarLayout {
+    static constexpr std::size_t k_num_columns = T::members::s_num_elems;
+
+    std::array<std::vector<std::span<const std::byte>>, k_num_columns>
+        segments;
+    std::size_t num_records{};
+};
+
+// Locate the columns in `data`. A column may be split across several fields,
+// as repeated fields concatenate; a missing column decodes to default values.
+// Throws std::runtime_error if the columns disagree on the record count.
+template <typename T>
+ColumnarLayout<T> scan_columns(std::span<const std::byte> data) {
+    ColumnarLayout<T> layout;
+    std::array<std::size_t, ColumnarLayout<T>::k_num_columns> counts{};
+
+    while (!data.empty()) {
+        auto deserialized = read_field(data);
+        if (deserialized.num_bytes_read == 0) {
+            throw std::runtime_error("Error parsing field");
+        }
+        data = data.subspan(deserialized.num_bytes_read);
+
+        const auto &field = deserialized.value;
+        const auto index = std::to_underlying(field.field_number()) - 1;
+        if (index >= ColumnarLayout<T>::k_num_columns) {
+            // Unknown field, skip
+            continue;
+        }
+        if (field.wire_type() != WireType::LEN) {
+            throw std::runtime_error("Column is not a packed field");
+        }
+
+        for_each_member<T>([&]<auto MemberPtr, std::size_t Index>() {
+            if (Index == index) {
+                counts[Index] +=
+                    packed_count<typename MemberEncoding<MemberPtr>::type>(
+                        field.payload);
+            }
+        });
+        layout.segments[index].push_back(field.payload);
+    }
+
+    std::optional<std::size_t> num_records;
+    for (std::size_t i = 0; i < counts.size(); i++) {
+        if (layout.segments[i].empty()) {
+            continue;
+        }
+        if (num_records.has_value() && *num_records != counts[i]) {
+            throw std::runtime_error("Columns have different lengths");
+        }
+        num_records = counts[i];
+    }
+    layout.num_records = num_records.value_or(0);
+    return layout;
+}
+
+// Decode a columnar batch into struct-of-arrays storage
+template <typename T>
+Columns<T> deserialize_columns(std::span<const std::byte> data) {
+    const auto layout = scan_columns<T>(data);
+    Columns<T> columns;
+
+    for_each_member<T>([&]<auto MemberPtr, std::size_t Index>() {
+        using Encoding = typename MemberEncoding<MemberPtr>::type;
+        using M =
+            typename MemberPointerTraits<decltype(MemberPtr)>::member_type;
+        auto &column = std::get<Index>(columns);
+        column.resize(layout.num_records);
+
+        if constexpr (std::is_same_v<M, bool>) {
+            // std::vector<bool> is not contiguous
+            std::size_t i = 0;
+            for (auto segment : layout.segments[Index]) {
+                for_each_packed<Encoding, M>(
+                    segment, [&](M value) { column[i++] = value; });
+            }
+        } else {
+            std::span out{column};
+            for (auto segment : layout.segments[Index]) {
+                const auto count = packed_count<Encoding>(segment);
+                decode_packed<Encoding>(segment, out.first(count));
+                out = out.subspan(count);
+            }
+        }
+    });
+    return columns;
+}
+
+// Decode a columnar batch back into an array of records
+template <typename T>
+std::vector<T> deserialize_columnar(std::span<const std::byte> data) {
+    const auto layout = scan_columns<T>(data);
+    std::vector<T> records(layout.num_records);
+
+    for_each_member<T>([&]<auto MemberPtr, std::size_t Index>() {
+        using Encoding = typename MemberEncoding<MemberPtr>::type;
+        using M =
+            typename MemberPointerTraits<decltype(MemberPtr)>::member_type;
+
+        std::size_t i = 0;
+        for (auto segment : layout.segments[Index]) {
+            for_each_packed<Encoding, M>(
+                segment, [&](M value) { records[i++].*MemberPtr = value; });
+        }
+    });
+    return records;
+}
+
+} // namespace proto
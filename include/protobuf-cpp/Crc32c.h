@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace proto {
+
+// CRC32C (Castagnoli) of `data`. Pass the result of a previous call as `crc`
+// to continue a checksum over data split into pieces:
+//
+//     crc32c(b, crc32c(a)) == crc32c(a + b)
+//
+// Uses the SSE4.2 crc32 instruction when the CPU supports it, running three
+// independent streams over large inputs and folding them together with
+// PCLMULQDQ. Otherwise falls back to crc32c_portable.
+[[nodiscard]] std::uint32_t crc32c(std::span<const std::byte> data,
+                                   std::uint32_t crc = 0) noexcept;
+
+// Table-driven (slicing-by-8) implementation of crc32c
+[[nodiscard]] std::uint32_t crc32c_portable(std::span<const std::byte> data,
+                                            std::uint32_t crc = 0) noexcept;
+
+} // namespace proto
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "Deserialize.h"
+#include "Encoding.h"
+#include "Map.h"
+#include "Serialize.h"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace proto {
+
+// Delta encoding: a delta is an ordinary message holding only the members
+// that changed, including members that changed back to their default value.
+// Merging it into the previous state with `merge` (or `apply_delta`)
+// reproduces the new state. As with protobuf merge semantics, a delta cannot
+// express resetting a std::optional member to std::nullopt, nor removing map
+// entries, since merging a map only inserts or overwrites entries. Types with
+// std::optional or map members are therefore rejected at compile time.
+
+template <typename Obj> consteval bool has_optional_members() {
+    bool found = false;
+    for_each_member<Obj>([&]<auto MemberPtr, std::size_t Index>() {
+        found = found || is_optional_v<typename MemberPointerTraits<
+                             decltype(MemberPtr)>::member_type>;
+    });
+    return found;
+}
+
+template <typename T>
+concept DeltaEncodable = !has_map_members<T>() && !has_optional_members<T>();
+
+template <typename M> constexpr bool same_value(const M &lhs, const M &rhs) {
+    if constexpr (std::is_floating_point_v<M>) {
+        // Compare the representation so that 0.0 -> -0.0 is a change
+        using Bits = std::conditional_t<sizeof(M) == sizeof(std::uint32_t),
+                                        std::uint32_t, std::uint64_t>;
+        return std::bit_cast<Bits>(lhs) == std::bit_cast<Bits>(rhs);
+    } else {
+        return lhs == rhs;
+    }
+}
+
+// Members of T that differ between `before` and `after`
+template <typename T>
+constexpr Presence<T> changed_members(const T &before, const T &after) {
+    Presence<T> changed;
+    for_each_member<T>([&]<auto MemberPtr, std::size_t Index>() {
+        changed[Index] = !same_value(before.*MemberPtr, after.*MemberPtr);
+    });
+    return changed;
+}
+
+template <DeltaEncodable T>
+std::vector<std::byte> serialize_delta(const T &before, const T &after) {
+    const auto changed = changed_members(before, after);
+    std::vector<std::byte> buffer(serialized_size(after, changed));
+    serialize(after, std::span<std::byte>{buffer}, changed);
+    return buffer;
+}
+
+template <DeltaEncodable T>
+constexpr void apply_delta(std::span<const std::byte> delta, T &obj) {
+    merge(delta, obj);
+}
+
+// Wraps an object and records which members were modified since the last
+// delta was taken, so that no comparison or snapshot is needed
+template <DeltaEncodable T> class Tracked {
+  public:
+    constexpr Tracked() = default;
+    constexpr explicit Tracked(T value) : m_value(std::move(value)) {}
+
+    [[nodiscard]] constexpr const T &get() const noexcept { return m_value; }
+
+    template <auto MemberPtr, typename V> constexpr void set(V &&value) {
+        m_value.*MemberPtr = std::forward<V>(value);
+        mark_dirty<MemberPtr>();
+    }
+
+    // Mutable access to a member, which is assumed to be modified
+    template <auto MemberPtr> [[nodiscard]] constexpr auto &mutate() {
+        mark_dirty<MemberPtr>();
+        return m_value.*MemberPtr;
+    }
+
+    template <auto MemberPtr> constexpr void mark_dirty() {
+        constexpr auto field = field_of<MemberPtr>(typename T::members{});
+        m_dirty.set(std::to_underlying(field) - 1);
+    }
+
+    // Force the next delta to contain every member, e.g. for a new receiver
+    constexpr void mark_all_dirty() { m_dirty.set(); }
+
+    [[nodiscard]] constexpr const Presence<T> &dirty() const noexcept {
+        return m_dirty;
+    }
+
+    [[nodiscard]] constexpr std::size_t delta_size() const {
+        return serialized_size(m_value, m_dirty);
+    }
+
+    // Serialize the dirty members into `buffer` and mark everything clean
+    std::size_t take_delta(std::span<std::byte> buffer) {
+        auto num_bytes_written = serialize(m_value, buffer, m_dirty);
+        m_dirty.reset();
+        return num_bytes_written;
+    }
+
+    [[nodiscard]] std::vector<std::byte> take_delta() {
+        std::vector<std::byte> buffer(delta_size());
+        take_delta(std::span<std::byte>{buffer});
+        return buffer;
+    }
+
+  private:
+    T m_value{};
+    Presence<T> m_dirty;
+};
+
+} // namespace proto
@@ -1,13 +1,19 @@
 #pragma once
 
+#include "Encoding.h"
 #include "Field.h"
 #include "Fixint.h"
+#include "Fused.h"
 #include "Key.h"
+#include "Map.h"
+#include "ParseEvents.h"
+#include "Utf8.h"
 #include "Varint.h"
 #include "Varlen.h"
 #include "WireType.h"
 
 #include <cstddef>
+#include <cstdint>
 #include <ranges>
 #include <span>
 #include <stdexcept>
@@ -23,87 +29,192 @@ template <typename Obj, typename T, auto... MemberPtrs>
 constexpr void set_field_in_obj(Field field, Obj &obj, const T &value,
                                 Members<MemberPtrs...>);
 
-template <typename Obj>
-constexpr Obj deserialize(std::span<const std::byte> data) {
-    Obj obj;
-
-    std::size_t total_bytes_read = 0;
-    while (total_bytes_read < data.size()) {
-        auto deserialized_key =
-            Varint::deserialize(data | std::views::drop(total_bytes_read));
-        if (deserialized_key.num_bytes_read == 0) {
-            throw std::runtime_error("Error parsing varint for key");
+// Sets the members of an object from the events produced by parse_events
+template <typename Obj> struct DeserializeVisitor {
+    Obj &obj;
+
+    constexpr void on_varint(Field field, Varint value) { set(field, value); }
+    constexpr void on_fixed32(Field field, Fixint32 value) {
+        set(field, value);
+    }
+    constexpr void on_fixed64(Field field, Fixint64 value) {
+        set(field, value);
+    }
+    constexpr void on_len(Field field, std::span<const std::byte> payload) {
+        set(field, payload);
+    }
+
+  private:
+    static constexpr bool is_known(Field field) noexcept {
+        // Recall that field number is 1-indexed, so we use <= here
+        return std::to_underlying(field) <= Obj::members::s_num_elems;
+    }
+
+    template <typename T> constexpr void set(Field field, const T &value) {
+        // Unknown fields are skipped
+        if (is_known(field)) {
+            set_field_in_obj(field, obj, value, typename Obj::members{});
         }
-        total_bytes_read += deserialized_key.num_bytes_read;
-
-        Key key(deserialized_key.value);
-        Field field_number = key.field_number();
-        // Recall that field number is 1-indexed, so we use > instead of >= here
-        if (std::to_underlying(field_number) > Obj::members::s_num_elems) {
-            // Unknown field, skip
-            continue;
+    }
+};
+
+// Integral members (or optional integral members) encoded as Varint
+template <auto MemberPtr>
+concept VarintMember =
+    std::is_integral_v<optional_value_t<
+        typename MemberPointerTraits<decltype(MemberPtr)>::member_type>> &&
+    std::is_same_v<typename MemberEncoding<MemberPtr>::type, Varint>;
+
+// Decode a VARINT field for an integral member straight into the member's
+// type, reading at most as many bytes as that type needs. Returns the number
+// of bytes consumed, or 0 to leave the field to the generic path (other wire
+// types, unknown fields, truncated input). Throws std::runtime_error if the
+// varint is longer than the member type allows.
+template <typename Obj>
+constexpr std::size_t merge_varint_field(std::span<const std::byte> data,
+                                         Obj &obj) {
+    // Field numbers are below 2^29, so keys fit in 32 bits. Five-byte keys
+    // are left to the generic path, since their high bits could be lost.
+    const auto key = Varint::deserialize_as<std::uint32_t>(data);
+    if (key.num_bytes_read == 0 ||
+        key.num_bytes_read == Varint::k_max_size_of<std::uint32_t> ||
+        Key{Varint{key.value}}.wire_type() != WireType::VARINT) {
+        return 0;
+    }
+    const auto field_number =
+        std::to_underlying(Key{Varint{key.value}}.field_number());
+    const auto value_data = data.subspan(key.num_bytes_read);
+
+    std::size_t num_bytes_read = 0;
+    for_each_member<Obj>([&]<auto MemberPtr, std::size_t Index>() {
+        if constexpr (VarintMember<MemberPtr>) {
+            using M = optional_value_t<
+                typename MemberPointerTraits<decltype(MemberPtr)>::member_type>;
+            if (field_number != Index + 1) {
+                return;
+            }
+            auto value = Varint::deserialize_as<M>(value_data);
+            if (value.num_bytes_read != 0) {
+                obj.*MemberPtr = value.value;
+                num_bytes_read = key.num_bytes_read + value.num_bytes_read;
+            } else if (value_data.size() >= Varint::k_max_size_of<M>) {
+                throw std::runtime_error(
+                    "Varint is too long for the member type");
+            }
         }
+    });
+    return num_bytes_read;
+}
+
+// Merge `data` into an existing object: members present on the wire are
+// overwritten, all other members are left untouched
+template <typename Obj>
+constexpr void merge(std::span<const std::byte> data, Obj &obj) {
+    if constexpr (has_reservable_maps<Obj>()) {
+        reserve_map_entries(data, obj);
+    }
 
-        switch (key.wire_type()) {
-        case WireType::VARINT: {
-            auto deserialized_value =
-                Varint::deserialize(data | std::views::drop(total_bytes_read));
-            if (deserialized_value.num_bytes_read == 0) {
-                throw std::runtime_error("Error parsing varint for value");
+    DeserializeVisitor<Obj> visitor{obj};
+    while (!data.empty()) {
+        std::size_t num_bytes_read = 0;
+        if constexpr (has_fused_runs<Obj>()) {
+            if !consteval {
+                num_bytes_read = merge_fused_run(data, obj);
             }
-            total_bytes_read += deserialized_value.num_bytes_read;
-            set_field_in_obj(field_number, obj, deserialized_value.value,
-                             typename Obj::members{});
-            break;
         }
-        case WireType::FIXED64: {
-            auto deserialized_value = Fixint<std::uint64_t>::deserialize(
-                data | std::views::drop(total_bytes_read));
-            if (deserialized_value.num_bytes_read == 0) {
-                throw std::runtime_error("Error parsing fixint64 for value");
-            }
-            total_bytes_read += deserialized_value.num_bytes_read;
-            set_field_in_obj(field_number, obj, deserialized_value.value,
-                             typename Obj::members{});
-            break;
+        if (num_bytes_read == 0) {
+            num_bytes_read = merge_varint_field(data, obj);
         }
-        case WireType::LEN: {
-            auto deserialized_value =
-                Varlen::deserialize(data | std::views::drop(total_bytes_read));
-            if (deserialized_value.num_bytes_read == 0) {
-                throw std::runtime_error("Error parsing Varlen for value");
+        if (num_bytes_read == 0) {
+            auto deserialized = read_field(data);
+            if (deserialized.num_bytes_read == 0) {
+                throw std::runtime_error("Error parsing field");
             }
-            total_bytes_read += deserialized_value.num_bytes_read;
-            set_field_in_obj(field_number, obj, deserialized_value.value,
-                             typename Obj::members{});
-            break;
+            parse_event(deserialized.value, visitor);
+            num_bytes_read = deserialized.num_bytes_read;
         }
+        data = data.subspan(num_bytes_read);
+    }
+}
 
-        case WireType::FIXED32: {
-            auto deserialized_value = Fixint<std::uint32_t>::deserialize(
-                data | std::views::drop(total_bytes_read));
-            if (deserialized_value.num_bytes_read == 0) {
-                throw std::runtime_error("Error parsing fixint32 for value");
+template <typename Obj>
+constexpr Obj deserialize(std::span<const std::byte> data) {
+    // Value-initialize: members absent from the wire keep their default
+    Obj obj{};
+    merge(data, obj);
+    return obj;
+}
+
+// Members that reference the input they were decoded from: views, and maps
+// with view keys or values
+template <typename Obj> consteval bool has_view_members() {
+    bool found = false;
+    for_each_member<Obj>([&]<auto MemberPtr, std::size_t Index>() {
+        using M = optional_value_t<
+            typename MemberPointerTraits<decltype(MemberPtr)>::member_type>;
+        if constexpr (MapContainer<M>) {
+            found = found || std::ranges::view<typename M::key_type> ||
+                    std::ranges::view<typename M::mapped_type>;
+        } else {
+            found = found || std::ranges::view<M>;
+        }
+    });
+    return found;
+}
+
+// LEN payloads are assigned straight from the input. View members
+// (std::string_view, std::span<const std::byte>) reference the input buffer
+// instead of copying it, so they are only valid for as long as it is.
+template <auto MemberPtr, typename Obj>
+constexpr void set_from_payload(Obj &obj, std::span<const std::byte> payload) {
+    using M = optional_value_t<std::remove_cvref_t<decltype(obj.*MemberPtr)>>;
+
+    if constexpr (TextSequence<M>) {
+        if constexpr (ValidateUtf8<MemberPtr>::value) {
+            if (!is_valid_utf8(payload)) {
+                throw std::runtime_error("String field is not valid UTF-8");
             }
-            total_bytes_read += deserialized_value.num_bytes_read;
-            set_field_in_obj(field_number, obj, deserialized_value.value,
-                             typename Obj::members{});
-            break;
         }
-        default:
-            throw std::runtime_error("Invalid Wire Type");
+        obj.*MemberPtr =
+            M(reinterpret_cast<const char *>(payload.data()), payload.size());
+    } else if constexpr (ByteSequence<M> &&
+                         std::is_constructible_v<M,
+                                                 std::span<const std::byte>>) {
+        obj.*MemberPtr = M(payload);
+    } else if constexpr (ByteSequence<M> && !std::ranges::view<M>) {
+        obj.*MemberPtr = M(payload.begin(), payload.end());
+    } else if constexpr (MapContainer<M>) {
+        // Each entry arrives as its own LEN field
+        using Encoding = typename MemberEncoding<MemberPtr>::type;
+        auto &member = obj.*MemberPtr;
+        if constexpr (is_optional_v<std::remove_cvref_t<decltype(member)>>) {
+            if (!member.has_value()) {
+                member.emplace();
+            }
+            merge_map_entry<Encoding, ValidateUtf8<MemberPtr>::value>(
+                payload, *member);
+        } else {
+            merge_map_entry<Encoding, ValidateUtf8<MemberPtr>::value>(
+                payload, member);
         }
+    } else {
+        // ABI error - e.g. trying to set an integer from a LEN field
+        throw std::logic_error(
+            "Tried to construct a field from an incompatible type");
     }
-
-    return obj;
 }
 
 template <auto MemberPtr, typename Obj, typename T>
 constexpr void set_if_correct_type(Obj &obj, const T &value) {
     using MemberType = typename std::remove_cvref_t<decltype(obj.*MemberPtr)>;
 
-    if constexpr (InterpretableAs<T, MemberType>) {
+    if constexpr (std::is_same_v<T, std::span<const std::byte>>) {
+        set_from_payload<MemberPtr>(obj, value);
+    } else if constexpr (InterpretableAs<T, MemberType>) {
         obj.*MemberPtr = value.template as<MemberType>();
+    } else if constexpr (is_optional_v<MemberType> &&
+                         InterpretableAs<T, optional_value_t<MemberType>>) {
+        obj.*MemberPtr = value.template as<optional_value_t<MemberType>>();
     } else {
         // ABI error - e.g. trying to set a span from a fixint
         throw std::logic_error(
@@ -1,12 +1,19 @@
 #pragma once
 
 #include "Concepts.h"
+#include "Field.h"
 #include "Fixint.h"
 #include "Varint.h"
 #include "Varlen.h"
+#include "WireType.h"
 
 #include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
 #include <type_traits>
+#include <utility>
 
 namespace proto {
 
@@ -16,6 +23,77 @@ template <auto... Ptrs> struct Members {
     static constexpr std::size_t s_num_elems{sizeof...(Ptrs)};
 };
 
+//
+// Default encoding of a value, independent of the member that holds it
+template <typename T> struct ValueEncoding;
+
+// For any integer, default to Varint
+template <typename T>
+    requires std::is_integral_v<T>
+struct ValueEncoding<T> {
+    using type = Varint;
+};
+
+// For any floating point, default to Fixint
+template <typename T>
+    requires std::is_floating_point_v<T>
+struct ValueEncoding<T> {
+    using type =
+        std::conditional_t<std::is_same_v<T, float>, Fixint<std::uint32_t>,
+                           Fixint<std::uint64_t>>;
+};
+
+// Contiguous sequences of bytes, e.g. std::vector<std::byte> or a
+// std::span<const std::byte> referencing caller-owned memory
+template <typename T>
+concept ByteSequence =
+    std::ranges::contiguous_range<T> && std::ranges::sized_range<T> &&
+    std::is_same_v<std::ranges::range_value_t<T>, std::byte>;
+
+// Contiguous sequences of UTF-8 text, e.g. std::string or std::string_view
+template <typename T>
+concept TextSequence =
+    std::ranges::contiguous_range<T> && std::ranges::sized_range<T> &&
+    std::is_same_v<std::ranges::range_value_t<T>, char>;
+
+// Byte and text sequences are length-delimited
+template <typename T>
+    requires ByteSequence<T> || TextSequence<T>
+struct ValueEncoding<T> {
+    using type = Varlen;
+};
+
+// Associative containers, e.g. std::map, std::unordered_map or proto::FlatMap
+template <typename T>
+concept MapContainer = std::ranges::forward_range<T> && requires {
+    typename T::key_type;
+    typename T::mapped_type;
+};
+
+// Encoding of a map field: a repeated LEN field holding one entry message per
+// element, with the key as field 1 and the value as field 2
+//
+//     message Entry { K key = 1; V value = 2; }
+//     repeated Entry map_field = N;
+//
+// Map members default to the ValueEncoding of their key and mapped types.
+// Specialize MemberEncoding to pick other encodings, e.g.
+//
+//     template <> struct MemberEncoding<&Foo::ids> {
+//         using type = MapEntries<Fixint32, Varint>;
+//     };
+template <typename KeyEncoding, typename MappedEncoding> struct MapEntries {
+    using key_encoding = KeyEncoding;
+    using mapped_encoding = MappedEncoding;
+    static constexpr WireType k_wire_type = WireType::LEN;
+};
+
+template <MapContainer T> struct ValueEncoding<T> {
+    using type =
+        MapEntries<typename ValueEncoding<typename T::key_type>::type,
+                   typename ValueEncoding<typename T::mapped_type>::type>;
+};
+
 //
 // Primary template: Get compiler error if the encoding is not set
 template <auto MemberPtr> struct MemberEncoding;
@@ -24,16 +102,113 @@ template <auto MemberPtr> struct MemberEncoding;
 template <typename Class, typename M, M Class::*MemberPtr>
     requires std::is_integral_v<M>
 struct MemberEncoding<MemberPtr> {
-    using type = Varint;
+    using type = typename ValueEncoding<M>::type;
 };
 
 // For any floating point member, default to Fixint
 template <typename Class, typename M, M Class::*MemberPtr>
     requires std::is_floating_point_v<M>
 struct MemberEncoding<MemberPtr> {
-    using type =
-        std::conditional_t<std::is_same_v<M, float>, Fixint<std::uint32_t>,
-                           Fixint<std::uint64_t>>;
+    using type = typename ValueEncoding<M>::type;
+};
+
+// For any byte or text sequence member, default to Varlen
+template <typename Class, typename M, M Class::*MemberPtr>
+    requires ByteSequence<M> || TextSequence<M>
+struct MemberEncoding<MemberPtr> {
+    using type = typename ValueEncoding<M>::type;
+};
+
+// For any map member, encode entries with the default key and value encodings
+template <typename Class, typename M, M Class::*MemberPtr>
+    requires MapContainer<M>
+struct MemberEncoding<MemberPtr> {
+    using type = typename ValueEncoding<M>::type;
+};
+
+// proto3 requires string fields to hold valid UTF-8, so text members are
+// validated when deserialized. Specialize to std::false_type for members
+// holding trusted or bytes-like data to skip the check. For map members the
+// check covers both text keys and text values:
+//
+//     template <> struct ValidateUtf8<&Foo::raw> : std::false_type {};
+template <auto MemberPtr> struct ValidateUtf8 : std::true_type {};
+
+// Map entries are written in iteration order, which for unordered containers
+// varies between runs and processes. Specialize to std::true_type to write
+// them sorted by key instead, so that equal maps serialize to equal bytes:
+//
+//     template <> struct DeterministicMap<&Foo::counts> : std::true_type {};
+template <auto MemberPtr> struct DeterministicMap : std::false_type {};
+
+// Optional members (explicit presence) are encoded like their value type
+template <typename Class, typename M, std::optional<M> Class::*MemberPtr>
+struct MemberEncoding<MemberPtr> {
+    using type = typename ValueEncoding<M>::type;
 };
 
+template <typename T> struct is_optional : std::false_type {
+    using value_type = T;
+};
+template <typename T> struct is_optional<std::optional<T>> : std::true_type {
+    using value_type = T;
+};
+template <typename T> constexpr bool is_optional_v = is_optional<T>::value;
+// T, or the type held by T if T is a std::optional
+template <typename T>
+using optional_value_t = typename is_optional<T>::value_type;
+
+// The value held by a member, looking through std::optional
+template <typename M> constexpr const auto &unwrap_optional(const M &value) {
+    if constexpr (is_optional_v<M>) {
+        return *value;
+    } else {
+        return value;
+    }
+}
+
+//
+// Invoke `f.template operator()<MemberPtr, Index>()` for every member of T in
+// the order of T::members, where Index is the 0-based position
+template <typename T, typename F> constexpr void for_each_member(F &&f) {
+    [&]<auto... Ptrs, std::size_t... Is>(Members<Ptrs...>,
+                                         std::index_sequence<Is...>) {
+        (f.template operator()<Ptrs, Is>(), ...);
+    }(typename T::members{},
+      std::make_index_sequence<T::members::s_num_elems>{});
+}
+
+//
+// Class and value type of a pointer to data member
+template <typename> struct MemberPointerTraits;
+
+template <typename Class, typename M> struct MemberPointerTraits<M Class::*> {
+    using class_type = Class;
+    using member_type = M;
+};
+
+template <auto A, auto B> consteval bool same_member() {
+    if constexpr (std::is_same_v<decltype(A), decltype(B)>) {
+        return A == B;
+    } else {
+        return false;
+    }
+}
+
+//
+// Field number of a member: its 1-indexed position in Members<...>
+template <auto MemberPtr, auto... Ptrs>
+consteval Field field_of(Members<Ptrs...>) {
+    std::size_t index = 0;
+    std::size_t found = 0;
+    ((++index, found = (found == 0 && same_member<MemberPtr, Ptrs>())
+                           ? index
+                           : found),
+     ...);
+    if (found == 0) {
+        throw std::logic_error("Member is not listed in Members<...>");
+    }
+    return Field{found};
+}
+
 } // namespace proto
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "Encoding.h"
+#include "Field.h"
+#include "Framing.h"
+#include "Tokenizer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace proto {
+
+// Decode a single field out of one message, skipping all other fields at
+// wire level. Absent fields decode to Type{}; if the field is repeated the
+// last occurrence wins, as it would when deserializing. Text must be valid
+// UTF-8 unless `ValidateText` is false.
+template <Field FieldNumber, typename Type,
+          typename Encoding = typename ValueEncoding<Type>::type,
+          bool ValidateText = true>
+constexpr Type extract_from_message(std::span<const std::byte> message) {
+    Type value{};
+    while (!message.empty()) {
+        auto deserialized = read_field(message);
+        if (deserialized.num_bytes_read == 0) {
+            throw std::runtime_error("Error parsing field");
+        }
+        if (deserialized.value.field_number() == FieldNumber) {
+            value = decode_value<Type, Encoding, ValidateText>(
+                deserialized.value);
+        }
+        message = message.subspan(deserialized.num_bytes_read);
+    }
+    return value;
+}
+
+// Columnar projection of one field over a batch of length-delimited messages
+// (see Framing.h). Element i of the result is the field's value in message i.
+// With num_threads > 1 the frame boundaries are found first and the messages
+// are then decoded concurrently in contiguous chunks.
+template <Field FieldNumber, typename Type,
+          typename Encoding = typename ValueEncoding<Type>::type,
+          bool ValidateText = true>
+std::vector<Type> extract_field(std::span<const std::byte> frames,
+                                std::size_t num_threads = 1) {
+    std::vector<Type> column;
+
+    // std::vector<bool> elements cannot be written concurrently
+    if (num_threads <= 1 || std::is_same_v<Type, bool>) {
+        while (!frames.empty()) {
+            auto frame = read_frame(frames);
+            if (frame.num_bytes_read == 0) {
+                throw std::runtime_error("Error parsing frame");
+            }
+            column.push_back(
+                extract_from_message<FieldNumber, Type, Encoding,
+                                     ValidateText>(frame.value));
+            frames = frames.subspan(frame.num_bytes_read);
+        }
+        return column;
+    }
+
+    const auto messages = split_frames(frames);
+    column.resize(messages.size());
+
+    const auto chunk_size = (messages.size() + num_threads - 1) / num_threads;
+    std::vector<std::exception_ptr> errors(num_threads);
+    {
+        std::vector<std::jthread> workers;
+        for (std::size_t t = 0; t * chunk_size < messages.size(); t++) {
+            const auto begin = t * chunk_size;
+            const auto end = std::min(begin + chunk_size, messages.size());
+            workers.emplace_back([&, t, begin, end] {
+                try {
+                    for (auto i = begin; i < end; i++) {
+                        column[i] =
+                            extract_from_message<FieldNumber, Type, Encoding,
+                                                 ValidateText>(messages[i]);
+                    }
+                } catch (...) {
+                    errors[t] = std::current_exception();
+                }
+            });
+        }
+    }
+    for (const auto &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    return column;
+}
+
+// extract_field for a member listed in its class's Members<...>, using the
+// member's field number, MemberEncoding and ValidateUtf8. std::optional
+// members are extracted as their value type, absent fields as V{}.
+template <auto MemberPtr>
+std::vector<optional_value_t<
+    typename MemberPointerTraits<decltype(MemberPtr)>::member_type>>
+extract_member(std::span<const std::byte> frames,
+               std::size_t num_threads = 1) {
+    using Traits = MemberPointerTraits<decltype(MemberPtr)>;
+    constexpr Field field_number =
+        field_of<MemberPtr>(typename Traits::class_type::members{});
+
+    return extract_field<field_number,
+                         optional_value_t<typename Traits::member_type>,
+                         typename MemberEncoding<MemberPtr>::type,
+                         ValidateUtf8<MemberPtr>::value>(frames, num_threads);
+}
+
+} // namespace proto
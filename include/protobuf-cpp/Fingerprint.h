@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Serialize.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace proto {
+
+// Fast non-cryptographic 64-bit fingerprint of a byte sequence, for
+// deduplication and cache keys. The algorithm is XXH64, so fingerprints
+// match other xxHash implementations given the same seed.
+[[nodiscard]] std::uint64_t fingerprint(std::span<const std::byte> data,
+                                        std::uint64_t seed = 0) noexcept;
+
+// Incremental fingerprint: feeding the bytes of a sequence in any number of
+// pieces gives the same result as fingerprint() over the whole sequence
+class Fingerprinter {
+  public:
+    explicit Fingerprinter(std::uint64_t seed = 0) noexcept;
+
+    void update(std::span<const std::byte> data) noexcept;
+
+    // Fingerprint of everything passed to update so far. More data may still
+    // be added afterwards.
+    [[nodiscard]] std::uint64_t digest() const noexcept;
+
+  private:
+    static constexpr std::size_t k_stripe_size = 32;
+
+    std::uint64_t m_seed;
+    std::array<std::uint64_t, 4> m_accumulators;
+    std::uint64_t m_total_size{};
+    // Tail of the input that does not fill a stripe yet
+    std::array<std::byte, k_stripe_size> m_pending{};
+    std::size_t m_pending_size{};
+};
+
+// Output is fingerprinted in pieces of at least this many bytes, small enough
+// to still be in L1 cache when hashed
+inline constexpr std::size_t k_fingerprint_chunk_size = 4096;
+
+struct Fingerprinted {
+    std::size_t num_bytes_written;
+    std::uint64_t fingerprint;
+};
+
+// Serialize `obj` into `buffer` and fingerprint the output in the same pass:
+// the bytes are hashed in chunks as they are written, rather than in a
+// second sweep over the whole buffer. The fingerprint equals
+// fingerprint(buffer.first(num_bytes_written), seed).
+template <typename T>
+Fingerprinted serialize_fingerprinted(const T &obj,
+                                      std::span<std::byte> buffer,
+                                      std::uint64_t seed = 0) {
+    const auto present = presence(obj);
+    if (buffer.size() < serialized_size(obj, present)) {
+        throw std::runtime_error("Buffer too small to serialize object");
+    }
+
+    Fingerprinter fingerprinter{seed};
+    std::size_t num_bytes_hashed = 0;
+    const auto num_bytes_written = serialize_members(
+        obj, buffer, present, [&](std::size_t num_bytes_written) {
+            if (num_bytes_written - num_bytes_hashed >=
+                k_fingerprint_chunk_size) {
+                fingerprinter.update(buffer.subspan(
+                    num_bytes_hashed, num_bytes_written - num_bytes_hashed));
+                num_bytes_hashed = num_bytes_written;
+            }
+        });
+    if (num_bytes_hashed == 0) {
+        // Small output: one-shot hashing skips the streaming bookkeeping
+        const auto output = buffer.first(num_bytes_written);
+        return Fingerprinted{num_bytes_written, fingerprint(output, seed)};
+    }
+    fingerprinter.update(buffer.subspan(num_bytes_hashed,
+                                        num_bytes_written - num_bytes_hashed));
+    return Fingerprinted{num_bytes_written, fingerprinter.digest()};
+}
+
+// Same, into a new buffer. Returns the fingerprint.
+template <typename T>
+std::uint64_t serialize_fingerprinted(const T &obj,
+                                      std::vector<std::byte> &buffer,
+                                      std::uint64_t seed = 0) {
+    buffer.resize(serialized_size(obj));
+    return serialize_fingerprinted(obj, std::span<std::byte>{buffer}, seed)
+        .fingerprint;
+}
+
+} // namespace proto
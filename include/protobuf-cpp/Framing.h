@@ -0,0 +1,189 @@
+#pragma once
+
+#include "Crc32c.h"
+#include "Deserialized.h"
+#include "Fixint.h"
+#include "Serialize.h"
+#include "Tokenizer.h"
+#include "Varint.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace proto {
+
+// Length-delimited framing, compatible with Google's writeDelimitedTo and
+// parseDelimitedFrom: every message is prefixed with its size as a varint.
+//
+// Checksummed frames additionally carry the CRC32C of the message, as a
+// little-endian fixed32 between the size and the message, so that corrupt
+// records in durable logs are detected when read back.
+enum class FrameFormat { Delimited, Checksummed };
+
+// A frame located in a buffer. The checksum is not verified yet and is 0 for
+// delimited frames.
+struct Frame {
+    std::span<const std::byte> payload;
+    std::uint32_t checksum{};
+};
+
+// Locate one frame. num_bytes_read is 0 if `data` does not start with a
+// whole frame.
+[[nodiscard]] constexpr Deserialized<Frame>
+locate_frame(std::span<const std::byte> data, FrameFormat format) noexcept {
+    constexpr Deserialized<Frame> error{{}, 0};
+
+    auto deserialized_length = read_varint(data);
+    if (deserialized_length.num_bytes_read == 0) {
+        return error;
+    }
+    const auto length = deserialized_length.value.value();
+    auto remaining = data.subspan(deserialized_length.num_bytes_read);
+
+    Frame frame;
+    if (format == FrameFormat::Checksummed) {
+        auto deserialized_checksum = Fixint32::deserialize(remaining);
+        if (deserialized_checksum.num_bytes_read == 0) {
+            return error;
+        }
+        frame.checksum =
+            deserialized_checksum.value.template as<std::uint32_t>();
+        remaining = remaining.subspan(deserialized_checksum.num_bytes_read);
+    }
+    if (length > remaining.size()) {
+        return error;
+    }
+    frame.payload = remaining.first(static_cast<std::size_t>(length));
+    return {frame, static_cast<std::size_t>(remaining.data() - data.data()) +
+                       frame.payload.size()};
+}
+
+// Throws std::runtime_error unless the payload of a checksummed frame matches
+// its checksum
+inline void verify_checksum(const Frame &frame) {
+    if (crc32c(frame.payload) != frame.checksum) {
+        throw std::runtime_error("Frame checksum mismatch");
+    }
+}
+
+// Read one frame. The value is the message payload without the length
+// prefix; num_bytes_read is 0 if `data` does not start with a whole frame.
+[[nodiscard]] constexpr Deserialized<std::span<const std::byte>>
+read_frame(std::span<const std::byte> data) noexcept {
+    auto frame = locate_frame(data, FrameFormat::Delimited);
+    return {frame.value.payload, frame.num_bytes_read};
+}
+
+// Like read_frame for checksummed frames. Throws std::runtime_error if the
+// checksum does not match.
+[[nodiscard]] inline Deserialized<std::span<const std::byte>>
+read_checksummed_frame(std::span<const std::byte> data) {
+    auto frame = locate_frame(data, FrameFormat::Checksummed);
+    if (frame.num_bytes_read != 0) {
+        verify_checksum(frame.value);
+    }
+    return {frame.value.payload, frame.num_bytes_read};
+}
+
+// Split a buffer of back-to-back frames into their payloads, verifying
+// checksums if there are any. Throws std::runtime_error if the buffer ends in
+// a partial frame or a checksum does not match.
+[[nodiscard]] inline std::vector<std::span<const std::byte>>
+split_frames(std::span<const std::byte> data,
+             FrameFormat format = FrameFormat::Delimited) {
+    std::vector<std::span<const std::byte>> frames;
+    while (!data.empty()) {
+        auto frame = locate_frame(data, format);
+        if (frame.num_bytes_read == 0) {
+            throw std::runtime_error("Error parsing frame");
+        }
+        if (format == FrameFormat::Checksummed) {
+            verify_checksum(frame.value);
+        }
+        frames.push_back(frame.value.payload);
+        data = data.subspan(frame.num_bytes_read);
+    }
+    return frames;
+}
+
+[[nodiscard]] constexpr std::size_t
+frame_header_size(std::size_t message_size,
+                  FrameFormat format = FrameFormat::Delimited) noexcept {
+    return Varint{message_size}.size() +
+           (format == FrameFormat::Checksummed ? sizeof(std::uint32_t) : 0);
+}
+
+[[nodiscard]] constexpr std::size_t
+framed_size(std::size_t message_size,
+            FrameFormat format = FrameFormat::Delimited) noexcept {
+    return frame_header_size(message_size, format) + message_size;
+}
+
+// Write the header for a frame whose payload is already in place right after
+// it, and return the header size
+inline std::size_t write_frame_header(std::span<const std::byte> message,
+                                      std::span<std::byte> buffer,
+                                      FrameFormat format) {
+    auto num_bytes_written = Varint{message.size()}.serialize(buffer);
+    if (format == FrameFormat::Checksummed) {
+        num_bytes_written += Fixint32{crc32c(message)}.serialize(
+            buffer.subspan(num_bytes_written));
+    }
+    return num_bytes_written;
+}
+
+// Write `message` as a single frame
+inline std::size_t write_frame(std::span<const std::byte> message,
+                               std::span<std::byte> buffer,
+                               FrameFormat format = FrameFormat::Delimited) {
+    if (buffer.size() < framed_size(message.size(), format)) {
+        throw std::runtime_error("Buffer too small to write frame");
+    }
+    const auto header_size = frame_header_size(message.size(), format);
+    if (!message.empty()) {
+        std::memcpy(buffer.data() + header_size, message.data(),
+                    message.size());
+    }
+    write_frame_header(message, buffer, format);
+    return header_size + message.size();
+}
+
+template <typename T>
+[[nodiscard]] constexpr std::size_t
+serialized_delimited_size(const T &obj,
+                          FrameFormat format = FrameFormat::Delimited) {
+    return framed_size(serialized_size(obj), format);
+}
+
+// Serialize `obj` as a single frame
+template <typename T>
+std::size_t serialize_delimited(const T &obj, std::span<std::byte> buffer,
+                                FrameFormat format = FrameFormat::Delimited) {
+    const auto present = presence(obj);
+    const auto message_size = serialized_size(obj, present);
+    if (buffer.size() < framed_size(message_size, format)) {
+        throw std::runtime_error("Buffer too small to write frame");
+    }
+    // Serialize the message in place first so that its checksum can be
+    // computed without a copy
+    const auto header_size = frame_header_size(message_size, format);
+    auto message = buffer.subspan(header_size, message_size);
+    serialize(obj, message, present);
+    write_frame_header(message, buffer, format);
+    return header_size + message_size;
+}
+
+// Append `obj` as a single frame to the end of `buffer`
+template <typename T>
+void serialize_delimited(const T &obj, std::vector<std::byte> &buffer,
+                         FrameFormat format = FrameFormat::Delimited) {
+    const auto offset = buffer.size();
+    buffer.resize(offset + serialized_delimited_size(obj, format));
+    serialize_delimited(obj, std::span{buffer}.subspan(offset), format);
+}
+
+} // namespace proto
@@ -0,0 +1,219 @@
+#pragma once
+
+#include "Encoding.h"
+#include "Field.h"
+#include "Fixint.h"
+#include "Key.h"
+#include "Varint.h"
+
+#include <array>
+#include <bit>
+#include <bitset>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace proto {
+
+// Fused codecs for runs of consecutive fixed-width members. The layout of
+// such a run on the wire is known at compile time: every key is a constant
+// and every value has a fixed size. Instead of encoding the members one at a
+// time, a run is written by copying a compile-time template holding the keys
+// and then storing each value into its slot, and read back by checking the
+// keys against the template and loading each value from its slot. The bytes
+// produced are identical to the per-member path.
+//
+// Runs are derived from T::members. Once the compiler supports reflection,
+// the same runs can be derived from the layout of T itself.
+
+// Fusion is enabled for every type by default. Specialize to std::false_type
+// to always use the per-member path:
+//
+//     template <> struct FuseFixedWidthMembers<Foo> : std::false_type {};
+template <typename T> struct FuseFixedWidthMembers : std::true_type {};
+
+// Pointer to the member at 0-based `Index` in Members<...>
+template <std::size_t Index, auto... Ptrs>
+consteval auto member_at(Members<Ptrs...>) {
+    return std::get<Index>(std::tuple{Ptrs...});
+}
+
+// Members whose in-memory representation is their fixed-width encoding
+template <auto MemberPtr>
+concept FusableMember =
+    std::endian::native == std::endian::little &&
+    std::is_arithmetic_v<
+        typename MemberPointerTraits<decltype(MemberPtr)>::member_type> &&
+    !std::is_same_v<
+        typename MemberPointerTraits<decltype(MemberPtr)>::member_type,
+        bool> &&
+    ((std::is_same_v<typename MemberEncoding<MemberPtr>::type, Fixint32> &&
+      sizeof(typename MemberPointerTraits<
+             decltype(MemberPtr)>::member_type) == sizeof(std::uint32_t)) ||
+     (std::is_same_v<typename MemberEncoding<MemberPtr>::type, Fixint64> &&
+      sizeof(typename MemberPointerTraits<
+             decltype(MemberPtr)>::member_type) == sizeof(std::uint64_t)));
+
+// Whether each member of T, in the order of T::members, is fusable
+template <typename T> consteval auto fusable_members() {
+    return []<auto... Ptrs>(Members<Ptrs...>) {
+        return std::array<bool, sizeof...(Ptrs)>{FusableMember<Ptrs>...};
+    }(typename T::members{});
+}
+
+// One past the last member of the run of fusable members starting at
+// `Index`, or 0 if no run of at least two members starts there
+template <typename T, std::size_t Index> consteval std::size_t fused_run_end() {
+    if constexpr (!FuseFixedWidthMembers<T>::value) {
+        return 0;
+    } else {
+        constexpr auto fusable = fusable_members<T>();
+        // Only the first member of a run starts it
+        if (Index > 0 && fusable[Index - 1]) {
+            return 0;
+        }
+        auto end = Index;
+        while (end < fusable.size() && fusable[end]) {
+            end++;
+        }
+        return end - Index >= 2 ? end : 0;
+    }
+}
+
+template <typename T> consteval bool has_fused_runs() {
+    bool found = false;
+    [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+        ((found = found || fused_run_end<T, Is>() != 0), ...);
+    }(std::make_index_sequence<T::members::s_num_elems>{});
+    return found;
+}
+
+// Wire layout of the run of members [Begin, End) of T
+template <typename T, std::size_t Begin, std::size_t End> struct FusedRun {
+    static constexpr std::size_t k_num_members = End - Begin;
+
+    template <std::size_t I>
+    static constexpr auto k_member =
+        member_at<Begin + I>(typename T::members{});
+
+    template <std::size_t I>
+    static constexpr std::size_t k_value_size =
+        sizeof(typename MemberPointerTraits<
+               std::remove_cv_t<decltype(k_member<I>)>>::member_type);
+
+    template <std::size_t I> static consteval Varint key() {
+        return Varint{
+            Key{Field{Begin + I + 1},
+                MemberEncoding<k_member<I>>::type::k_wire_type}
+                .value()};
+    }
+
+    struct Layout {
+        std::array<std::size_t, k_num_members> key_offsets{};
+        std::array<std::size_t, k_num_members> key_sizes{};
+        std::array<std::size_t, k_num_members> value_offsets{};
+        std::size_t size{};
+    };
+
+    static consteval Layout layout() {
+        Layout layout;
+        [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+            ((layout.key_offsets[Is] = layout.size,
+              layout.key_sizes[Is] = key<Is>().size(),
+              layout.value_offsets[Is] = layout.size + layout.key_sizes[Is],
+              layout.size = layout.value_offsets[Is] + k_value_size<Is>),
+             ...);
+        }(std::make_index_sequence<k_num_members>{});
+        return layout;
+    }
+
+    static constexpr Layout k_layout = layout();
+    static constexpr std::size_t k_size = k_layout.size;
+
+    // The encoded run with every value set to zero
+    static consteval std::array<std::byte, k_size> make_template() {
+        std::array<std::byte, k_size> bytes{};
+        [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+            (key<Is>().serialize(std::span{bytes}.subspan(
+                 k_layout.key_offsets[Is], k_layout.key_sizes[Is])),
+             ...);
+        }(std::make_index_sequence<k_num_members>{});
+        return bytes;
+    }
+
+    static constexpr std::array<std::byte, k_size> k_template =
+        make_template();
+
+    // Whether every member of the run is to be serialized
+    template <std::size_t N>
+    static constexpr bool all_present(const std::bitset<N> &present) {
+        return [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+            return (present[Begin + Is] && ...);
+        }(std::make_index_sequence<k_num_members>{});
+    }
+
+    // Write the run into `out`, which must hold at least k_size bytes
+    static void serialize(const T &obj, std::byte *out) noexcept {
+        std::memcpy(out, k_template.data(), k_size);
+        [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+            (std::memcpy(out + k_layout.value_offsets[Is],
+                         &(obj.*k_member<Is>), k_value_size<Is>),
+             ...);
+        }(std::make_index_sequence<k_num_members>{});
+    }
+
+    // Read the run from the start of `data` into `obj` if the data holds
+    // exactly its keys in order. Returns the number of bytes read, or 0 if
+    // the data does not match, leaving `obj` unchanged.
+    static std::size_t deserialize(std::span<const std::byte> data,
+                                   T &obj) noexcept {
+        if (data.size() < k_size) {
+            return 0;
+        }
+        const bool keys_match =
+            [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+                return ((std::memcmp(data.data() + k_layout.key_offsets[Is],
+                                     k_template.data() +
+                                         k_layout.key_offsets[Is],
+                                     k_layout.key_sizes[Is]) == 0) &&
+                        ...);
+            }(std::make_index_sequence<k_num_members>{});
+        if (!keys_match) {
+            return 0;
+        }
+        [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+            (std::memcpy(&(obj.*k_member<Is>),
+                         data.data() + k_layout.value_offsets[Is],
+                         k_value_size<Is>),
+             ...);
+        }(std::make_index_sequence<k_num_members>{});
+        return k_size;
+    }
+};
+
+// Try every fused run of Obj against the start of `data`. Returns the number
+// of bytes read, or 0 if no run matches.
+template <typename Obj>
+std::size_t merge_fused_run(std::span<const std::byte> data,
+                            Obj &obj) noexcept {
+    std::size_t num_bytes_read = 0;
+    [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+        (
+            [&] {
+                if constexpr (fused_run_end<Obj, Is>() != 0) {
+                    if (num_bytes_read == 0) {
+                        num_bytes_read =
+                            FusedRun<Obj, Is, fused_run_end<Obj, Is>()>::
+                                deserialize(data, obj);
+                    }
+                }
+            }(),
+            ...);
+    }(std::make_index_sequence<Obj::members::s_num_elems>{});
+    return num_bytes_read;
+}
+
+} // namespace proto
@@ -0,0 +1,190 @@
+#pragma once
+
+#include "Encoding.h"
+#include "Field.h"
+#include "Key.h"
+#include "Serialize.h"
+#include "Varint.h"
+#include "WireType.h"
+
+#include <cstddef>
+#include <cstring>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <sys/uio.h>
+
+namespace proto {
+
+// Output of serialize_gather: the serialized message as a list of iovec
+// segments, ready for writev or sendmsg. Keys, length prefixes and small
+// members are encoded into a scratch buffer owned by the GatherBuffer, while
+// byte and text sequence members of at least `threshold()` bytes are
+// referenced in place from the object being serialized. The segments are
+// therefore only valid while both the GatherBuffer and that object are alive
+// and unchanged.
+//
+// A GatherBuffer may be reused; its scratch storage is kept between calls.
+class GatherBuffer {
+  public:
+    static constexpr std::size_t k_default_threshold = 4096;
+
+    explicit GatherBuffer(std::size_t threshold = k_default_threshold)
+        : m_threshold(threshold) {}
+
+    [[nodiscard]] std::size_t threshold() const noexcept {
+        return m_threshold;
+    }
+
+    [[nodiscard]] std::span<const iovec> segments() const noexcept {
+        return m_segments;
+    }
+
+    // Total number of bytes across all segments
+    [[nodiscard]] std::size_t size() const noexcept { return m_size; }
+
+    // Drop all segments and make room for `scratch_size` bytes of scratch.
+    // The scratch storage is never reallocated between two resets, so the
+    // segments pointing into it stay valid.
+    void reset(std::size_t scratch_size) {
+        m_segments.clear();
+        m_size = 0;
+        m_scratch_used = 0;
+        if (m_scratch.size() < scratch_size) {
+            m_scratch.resize(scratch_size);
+        }
+    }
+
+    // Reserve `size` bytes at the end of the scratch buffer for the caller to
+    // fill in
+    [[nodiscard]] std::span<std::byte> append_scratch(std::size_t size) {
+        if (m_scratch.size() - m_scratch_used < size) {
+            throw std::runtime_error("Gather scratch buffer too small");
+        }
+        auto *data = m_scratch.data() + m_scratch_used;
+        // Consecutive scratch writes share a segment
+        if (!m_segments.empty() &&
+            static_cast<std::byte *>(m_segments.back().iov_base) +
+                    m_segments.back().iov_len ==
+                data) {
+            m_segments.back().iov_len += size;
+        } else {
+            m_segments.push_back(iovec{data, size});
+        }
+        m_scratch_used += size;
+        m_size += size;
+        return {data, size};
+    }
+
+    // Append a segment referencing caller-owned memory without copying it
+    void append_reference(std::span<const std::byte> data) {
+        if (data.empty()) {
+            return;
+        }
+        // iovec is shared by readv and writev, hence the non-const pointer
+        m_segments.push_back(
+            iovec{const_cast<std::byte *>(data.data()), data.size()});
+        m_size += data.size();
+    }
+
+  private:
+    std::size_t m_threshold;
+    std::vector<std::byte> m_scratch;
+    std::size_t m_scratch_used{};
+    std::vector<iovec> m_segments;
+    std::size_t m_size{};
+};
+
+// Byte or text sequence members are the ones eligible for referencing
+template <typename M>
+concept GatherableSequence = ByteSequence<M> || TextSequence<M>;
+
+template <GatherableSequence M>
+std::span<const std::byte> sequence_bytes(const M &value) noexcept {
+    return std::as_bytes(
+        std::span{std::ranges::data(value), std::ranges::size(value)});
+}
+
+template <auto MemberPtr, typename T>
+constexpr std::size_t gather_scratch_size(const T &obj, Field field_number,
+                                          std::size_t threshold) {
+    using M = optional_value_t<
+        typename MemberPointerTraits<decltype(MemberPtr)>::member_type>;
+
+    if constexpr (GatherableSequence<M>) {
+        const auto size = std::ranges::size(unwrap_optional(obj.*MemberPtr));
+        const auto header_size =
+            Varint{Key{field_number, WireType::LEN}.value()}.size() +
+            Varint{size}.size();
+        return size >= threshold ? header_size : header_size + size;
+    } else {
+        return member_field_size<MemberPtr>(obj, field_number);
+    }
+}
+
+template <auto MemberPtr, typename T>
+void serialize_gather_member(const T &obj, GatherBuffer &out,
+                             Field field_number) {
+    using M = optional_value_t<
+        typename MemberPointerTraits<decltype(MemberPtr)>::member_type>;
+
+    if constexpr (GatherableSequence<M>) {
+        // Written directly rather than through a Record, which would copy
+        // the payload into a temporary Varlen first
+        const auto payload = sequence_bytes(unwrap_optional(obj.*MemberPtr));
+        const Varint key{Key{field_number, WireType::LEN}.value()};
+        const Varint length{payload.size()};
+
+        if (payload.size() >= out.threshold()) {
+            auto header = out.append_scratch(key.size() + length.size());
+            length.serialize(header.subspan(key.serialize(header)));
+            out.append_reference(payload);
+        } else {
+            auto field = out.append_scratch(key.size() + length.size() +
+                                            payload.size());
+            auto offset = key.serialize(field);
+            offset += length.serialize(field.subspan(offset));
+            if (!payload.empty()) {
+                std::memcpy(field.data() + offset, payload.data(),
+                            payload.size());
+            }
+        }
+    } else {
+        auto field =
+            out.append_scratch(member_field_size<MemberPtr>(obj, field_number));
+        serialize_member_field<MemberPtr>(obj, field, field_number);
+    }
+}
+
+// Serialize the members set in `present` into `out`, replacing its previous
+// contents. The bytes produced are identical to serialize(obj).
+template <typename T>
+void serialize_gather(const T &obj, GatherBuffer &out,
+                      const Presence<T> &present) {
+    std::size_t scratch_size = 0;
+    for_each_member<T>([&]<auto MemberPtr, std::size_t Index>() {
+        if (present[Index] && has_value(obj.*MemberPtr)) {
+            scratch_size += gather_scratch_size<MemberPtr>(
+                obj, Field{Index + 1}, out.threshold());
+        }
+    });
+
+    out.reset(scratch_size);
+    for_each_member<T>([&]<auto MemberPtr, std::size_t Index>() {
+        if (present[Index] && has_value(obj.*MemberPtr)) {
+            serialize_gather_member<MemberPtr>(obj, out, Field{Index + 1});
+        }
+    });
+}
+
+template <typename T> void serialize_gather(const T &obj, GatherBuffer &out) {
+    serialize_gather(obj, out, presence(obj));
+}
+
+// Write all segments to `fd` with writev, resuming after partial writes.
+// Throws std::system_error if a write fails.
+void write_segments(int fd, std::span<const iovec> segments);
+
+} // namespace proto
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "Deserialize.h"
+#include "Encoding.h"
+#include "Framing.h"
+#include "Map.h"
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <unordered_set>
+#include <vector>
+
+namespace proto {
+
+// Interning of length-delimited payloads. View members (std::string_view,
+// std::span<const std::byte>) normally point into the input they were decoded
+// from, which then has to be kept around in full. Decoding with an
+// InternTable instead points them at a single immutable copy of every
+// distinct payload, owned by the table: inputs can be dropped right after
+// decoding, and payloads that repeat across messages, such as host names or
+// tags, are stored once. The same goes for view keys and values of map
+// members. Owning members (std::string, std::vector) still get their own
+// copy; declare them as views to share them.
+
+// Distinct payloads seen so far, copied into chunks that are never moved or
+// freed before the table itself. Not thread-safe.
+class InternTable {
+  public:
+    static constexpr std::size_t k_chunk_size = 64 * 1024;
+
+    InternTable() = default;
+    InternTable(const InternTable &) = delete;
+    InternTable &operator=(const InternTable &) = delete;
+
+    // A view of the table's copy of `value`, made on first sight
+    [[nodiscard]] std::string_view intern(std::string_view value);
+
+    [[nodiscard]] std::span<const std::byte>
+    intern(std::span<const std::byte> value) {
+        const auto interned = intern(std::string_view{
+            reinterpret_cast<const char *>(value.data()), value.size()});
+        return std::as_bytes(std::span{interned});
+    }
+
+    // Number of distinct payloads and the bytes needed to store them
+    [[nodiscard]] std::size_t size() const noexcept { return m_values.size(); }
+    [[nodiscard]] std::size_t bytes_stored() const noexcept {
+        return m_bytes_stored;
+    }
+
+  private:
+    [[nodiscard]] char *allocate(std::size_t size);
+
+    std::unordered_set<std::string_view> m_values;
+    std::vector<std::unique_ptr<char[]>> m_chunks;
+    // Free space at the end of the current chunk
+    char *m_free{};
+    std::size_t m_free_size{};
+    std::size_t m_bytes_stored{};
+};
+
+template <typename M>
+concept InternableView = std::is_same_v<M, std::string_view> ||
+                         std::is_same_v<M, std::span<const std::byte>>;
+
+// Point the view keys and values of `map` at their interned copies. Keys
+// cannot be changed in place, so maps with view keys are rebuilt.
+template <MapContainer M> void intern_map(M &map, InternTable &table) {
+    using K = typename M::key_type;
+    using V = typename M::mapped_type;
+    if constexpr (InternableView<K>) {
+        M interned;
+        if constexpr (ReservableMap<M>) {
+            interned.reserve(map.size());
+        }
+        for (auto &[key, value] : map) {
+            if constexpr (InternableView<V>) {
+                interned.insert_or_assign(table.intern(key),
+                                          table.intern(value));
+            } else {
+                interned.insert_or_assign(table.intern(key), std::move(value));
+            }
+        }
+        map = std::move(interned);
+    } else if constexpr (InternableView<V>) {
+        for (auto &[key, value] : map) {
+            value = table.intern(value);
+        }
+    }
+}
+
+// Point every view member of `obj`, and every view in its map members, at
+// its interned copy
+template <typename T> void intern_members(T &obj, InternTable &table) {
+    for_each_member<T>([&]<auto MemberPtr, std::size_t>() {
+        auto &member = obj.*MemberPtr;
+        using M = std::remove_cvref_t<decltype(member)>;
+        if constexpr (InternableView<M>) {
+            member = table.intern(member);
+        } else if constexpr (MapContainer<M>) {
+            intern_map(member, table);
+        } else if constexpr (is_optional_v<M> &&
+                             InternableView<optional_value_t<M>>) {
+            if (member.has_value()) {
+                *member = table.intern(*member);
+            }
+        } else if constexpr (is_optional_v<M> &&
+                             MapContainer<optional_value_t<M>>) {
+            if (member.has_value()) {
+                intern_map(*member, table);
+            }
+        }
+    });
+}
+
+// deserialize, with view members pointing into `table` rather than `data`
+template <typename T>
+T deserialize_interned(std::span<const std::byte> data, InternTable &table) {
+    auto obj = deserialize<T>(data);
+    intern_members(obj, table);
+    return obj;
+}
+
+// Decode a batch of length-delimited frames (see Framing.h) sharing one
+// table, so that payloads repeated across the batch are stored once
+template <typename T>
+std::vector<T> deserialize_frames_interned(
+    std::span<const std::byte> frames, InternTable &table,
+    FrameFormat format = FrameFormat::Delimited) {
+    std::vector<T> messages;
+    for (auto frame : split_frames(frames, format)) {
+        messages.push_back(deserialize_interned<T>(frame, table));
+    }
+    return messages;
+}
+
+} // namespace proto
@@ -0,0 +1,327 @@
+#pragma once
+
+#include "Encoding.h"
+#include "Field.h"
+#include "Map.h"
+#include "Tokenizer.h"
+#include "Utf8.h"
+#include "Varlen.h"
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace proto {
+
+// Member names for JSON are declared next to `members`, in the same order:
+//
+//     using members = proto::Members<&Foo::id, &Foo::load>;
+//     static constexpr std::array member_names{"id", "load"};
+//
+// Types without member_names use their field numbers as JSON keys.
+template <typename T>
+concept NamedMembers = requires {
+    { std::size(T::member_names) };
+    { std::string_view{T::member_names[0]} };
+} && std::size(T::member_names) == T::members::s_num_elems;
+
+// Append `value` to `out` as a quoted JSON string, escaping quotes,
+// backslashes and control characters
+void append_json_string(std::string &out, std::string_view value);
+
+// Like append_json_string, but replaces every byte that is not part of
+// well-formed UTF-8 with U+FFFD, so that the output is valid JSON
+void append_json_string_lossy(std::string &out, std::string_view value);
+
+// Append `value` to `out` as a quoted base64 string, as proto3 JSON does for
+// `bytes` fields
+void append_json_base64(std::string &out, std::span<const std::byte> value);
+
+template <typename T>
+void append_json_member_name(std::string &out, std::size_t index) {
+    if constexpr (NamedMembers<T>) {
+        append_json_string(out, T::member_names[index]);
+    } else {
+        std::array<char, 24> digits{};
+        auto result = std::to_chars(
+            digits.data(), digits.data() + digits.size(), index + 1);
+        out += '"';
+        out.append(digits.data(), result.ptr);
+        out += '"';
+    }
+}
+
+template <typename M> void append_json_number(std::string &out, M value) {
+    if constexpr (std::is_same_v<M, bool>) {
+        out += value ? "true" : "false";
+    } else if constexpr (std::is_floating_point_v<M>) {
+        if (std::isnan(value)) {
+            out += "\"NaN\"";
+            return;
+        }
+        if (std::isinf(value)) {
+            out += value > 0 ? "\"Infinity\"" : "\"-Infinity\"";
+            return;
+        }
+        std::array<char, 32> digits{};
+        auto result =
+            std::to_chars(digits.data(), digits.data() + digits.size(), value);
+        out.append(digits.data(), result.ptr);
+    } else {
+        std::array<char, 24> digits{};
+        auto result =
+            std::to_chars(digits.data(), digits.data() + digits.size(), value);
+        // proto3 JSON maps 64-bit integers to strings, as they do not fit
+        // in a double
+        constexpr bool quoted = sizeof(M) == sizeof(std::uint64_t);
+        if constexpr (quoted) {
+            out += '"';
+        }
+        out.append(digits.data(), result.ptr);
+        if constexpr (quoted) {
+            out += '"';
+        }
+    }
+}
+
+template <auto MemberPtr>
+void append_json_value(std::string &out, const WireField &field) {
+    using M = optional_value_t<
+        typename MemberPointerTraits<decltype(MemberPtr)>::member_type>;
+    using Encoding = typename MemberEncoding<MemberPtr>::type;
+
+    if constexpr (std::is_same_v<Encoding, Varlen>) {
+        if (field.wire_type() != WireType::LEN) {
+            throw std::runtime_error(
+                "Attempted to deserialize the wrong type!");
+        }
+        if constexpr (std::is_same_v<std::ranges::range_value_t<M>, char>) {
+            const std::string_view text{
+                reinterpret_cast<const char *>(field.payload.data()),
+                field.payload.size()};
+            // Text is checked as deserialize would; exempt members may hold
+            // anything and are made valid instead
+            if constexpr (ValidateUtf8<MemberPtr>::value) {
+                if (!is_valid_utf8(field.payload)) {
+                    throw std::runtime_error(
+                        "String field is not valid UTF-8");
+                }
+                append_json_string(out, text);
+            } else {
+                append_json_string_lossy(out, text);
+            }
+        } else {
+            append_json_base64(out, field.payload);
+        }
+    } else {
+        append_json_number(out, decode_value<M, Encoding>(field));
+    }
+}
+
+// Text that was checked while decoding is written as is; unchecked text is
+// made valid, as for plain string members
+template <bool ValidateText>
+void append_json_text(std::string &out, std::string_view text) {
+    if constexpr (ValidateText) {
+        append_json_string(out, text);
+    } else {
+        append_json_string_lossy(out, text);
+    }
+}
+
+// proto3 JSON writes map keys as strings, whatever their type
+template <bool ValidateText, typename K>
+void append_json_map_key(std::string &out, const K &key) {
+    if constexpr (TextSequence<K>) {
+        append_json_text<ValidateText>(
+            out, std::string_view{std::ranges::data(key),
+                                  std::ranges::size(key)});
+    } else if constexpr (std::is_same_v<K, bool>) {
+        out += key ? "\"true\"" : "\"false\"";
+    } else {
+        std::array<char, 24> digits{};
+        auto result =
+            std::to_chars(digits.data(), digits.data() + digits.size(), key);
+        out += '"';
+        out.append(digits.data(), result.ptr);
+        out += '"';
+    }
+}
+
+template <bool ValidateText, typename V>
+void append_json_map_value(std::string &out, const V &value) {
+    if constexpr (TextSequence<V>) {
+        append_json_text<ValidateText>(
+            out, std::string_view{std::ranges::data(value),
+                                  std::ranges::size(value)});
+    } else if constexpr (ByteSequence<V>) {
+        append_json_base64(out, std::span{std::ranges::data(value),
+                                          std::ranges::size(value)});
+    } else {
+        append_json_number(out, value);
+    }
+}
+
+// Map keys and values are read off the wire as views of the message, so
+// writing a map allocates nothing per entry
+template <typename V>
+using json_view_t =
+    std::conditional_t<TextSequence<V>, std::string_view,
+                       std::conditional_t<ByteSequence<V>,
+                                          std::span<const std::byte>, V>>;
+
+// Write map member `MemberPtr`, field number Index + 1, as a JSON object.
+// Its entries are the LEN fields among `map_fields`, collected in wire
+// order. As when deserializing, a later entry replaces an earlier one with
+// the same key; entries are written in key order.
+template <auto MemberPtr, std::size_t Index>
+void append_json_map(std::string &out,
+                     std::span<const WireField> map_fields) {
+    using M = optional_value_t<
+        typename MemberPointerTraits<decltype(MemberPtr)>::member_type>;
+    using Encoding = typename MemberEncoding<MemberPtr>::type;
+    using K = json_view_t<typename M::key_type>;
+    using V = json_view_t<typename M::mapped_type>;
+    constexpr bool validate = ValidateUtf8<MemberPtr>::value;
+
+    std::vector<std::pair<K, V>> entries;
+    for (const auto &field : map_fields) {
+        if (std::to_underlying(field.field_number()) - 1 != Index) {
+            continue;
+        }
+        if (field.wire_type() != WireType::LEN) {
+            throw std::runtime_error(
+                "Attempted to deserialize the wrong type!");
+        }
+        std::pair<K, V> entry{};
+        auto payload = field.payload;
+        while (!payload.empty()) {
+            auto deserialized = read_field(payload);
+            if (deserialized.num_bytes_read == 0) {
+                throw std::runtime_error("Error parsing map entry");
+            }
+            const auto &member = deserialized.value;
+            if (member.field_number() == k_map_key_field) {
+                entry.first =
+                    decode_value<K, typename Encoding::key_encoding,
+                                 validate>(member);
+            } else if (member.field_number() == k_map_value_field) {
+                entry.second =
+                    decode_value<V, typename Encoding::mapped_encoding,
+                                 validate>(member);
+            }
+            payload = payload.subspan(deserialized.num_bytes_read);
+        }
+        entries.push_back(entry);
+    }
+
+    // Stable, so the last of a run of equal keys is the one that wins
+    std::ranges::stable_sort(entries, std::less{},
+                             [](const auto &entry) { return entry.first; });
+
+    out += '{';
+    bool first = true;
+    for (std::size_t i = 0; i < entries.size(); i++) {
+        if (i + 1 < entries.size() &&
+            entries[i + 1].first == entries[i].first) {
+            continue;
+        }
+        if (!first) {
+            out += ',';
+        }
+        first = false;
+        append_json_map_key<validate>(out, entries[i].first);
+        out += ':';
+        append_json_map_value<validate>(out, entries[i].second);
+    }
+    out += '}';
+}
+
+// Which members of T are maps, by index
+template <typename T> consteval auto map_member_mask() {
+    std::array<bool, T::members::s_num_elems> mask{};
+    for_each_member<T>([&]<auto MemberPtr, std::size_t Index>() {
+        mask[Index] = MapContainer<optional_value_t<
+            typename MemberPointerTraits<decltype(MemberPtr)>::member_type>>;
+    });
+    return mask;
+}
+
+// Transcode a serialized T straight to a JSON object appended to `out`,
+// without materializing a T. Members are written in the order of T::members;
+// members absent from the wire are omitted and, as when deserializing, the
+// last occurrence of a repeated field wins. Map members are written as JSON
+// objects holding the entries of every occurrence. Unknown fields are
+// skipped. Throws std::runtime_error on malformed input.
+template <typename T>
+void transcode_json(std::span<const std::byte> data, std::string &out) {
+    constexpr auto num_members = T::members::s_num_elems;
+    constexpr auto map_members = map_member_mask<T>();
+    std::array<WireField, num_members> fields{};
+    std::bitset<num_members> seen;
+    // Every entry of every map member, which are spread over the message
+    std::vector<WireField> map_fields;
+
+    while (!data.empty()) {
+        auto deserialized = read_field(data);
+        if (deserialized.num_bytes_read == 0) {
+            throw std::runtime_error("Error parsing field");
+        }
+        data = data.subspan(deserialized.num_bytes_read);
+
+        const auto index =
+            std::to_underlying(deserialized.value.field_number()) - 1;
+        if (index < num_members) {
+            fields[index] = deserialized.value;
+            seen.set(index);
+            if (map_members[index]) {
+                map_fields.push_back(deserialized.value);
+            }
+        }
+    }
+
+    out += '{';
+    bool first = true;
+    for_each_member<T>([&]<auto MemberPtr, std::size_t Index>() {
+        if (!seen[Index]) {
+            return;
+        }
+        if (!first) {
+            out += ',';
+        }
+        first = false;
+        append_json_member_name<T>(out, Index);
+        out += ':';
+        using M = optional_value_t<
+            typename MemberPointerTraits<decltype(MemberPtr)>::member_type>;
+        if constexpr (MapContainer<M>) {
+            append_json_map<MemberPtr, Index>(out, map_fields);
+        } else {
+            append_json_value<MemberPtr>(out, fields[Index]);
+        }
+    });
+    out += '}';
+}
+
+template <typename T>
+[[nodiscard]] std::string to_json(std::span<const std::byte> data) {
+    std::string out;
+    out.reserve(2 * data.size() + 2);
+    transcode_json<T>(data, out);
+    return out;
+}
+
+} // namespace proto
@@ -0,0 +1,367 @@
+#pragma once
+
+#include "Encoding.h"
+#include "Field.h"
+#include "Key.h"
+#include "Record.h"
+#include "Tokenizer.h"
+#include "Varint.h"
+#include "Varlen.h"
+#include "WireType.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace proto {
+
+// Map stored as a vector of key/value pairs sorted by key. Lookups are binary
+// searches over contiguous memory and there is one allocation for the whole
+// map rather than one per node. Inserting a key greater than all others
+// appends, so decoding entries that were written in key order (as any
+// ordered or deterministic map is) never shifts elements.
+template <typename K, typename V, typename Compare = std::less<K>>
+class FlatMap {
+  public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<K, V>;
+    using key_compare = Compare;
+    using iterator = typename std::vector<value_type>::iterator;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+    FlatMap() = default;
+
+    FlatMap(std::initializer_list<value_type> entries) {
+        reserve(entries.size());
+        for (const auto &[key, value] : entries) {
+            insert_or_assign(key, value);
+        }
+    }
+
+    [[nodiscard]] iterator begin() noexcept { return m_entries.begin(); }
+    [[nodiscard]] iterator end() noexcept { return m_entries.end(); }
+    [[nodiscard]] const_iterator begin() const noexcept {
+        return m_entries.begin();
+    }
+    [[nodiscard]] const_iterator end() const noexcept {
+        return m_entries.end();
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept {
+        return m_entries.size();
+    }
+    [[nodiscard]] bool empty() const noexcept { return m_entries.empty(); }
+    void reserve(std::size_t size) { m_entries.reserve(size); }
+    void clear() noexcept { m_entries.clear(); }
+
+    [[nodiscard]] iterator find(const K &key) {
+        auto it = lower_bound(key);
+        return it != end() && !m_compare(key, it->first) ? it : end();
+    }
+    [[nodiscard]] const_iterator find(const K &key) const {
+        auto it = lower_bound(key);
+        return it != end() && !m_compare(key, it->first) ? it : end();
+    }
+    [[nodiscard]] bool contains(const K &key) const {
+        return find(key) != end();
+    }
+
+    [[nodiscard]] V &at(const K &key) {
+        auto it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("Key not found in FlatMap");
+        }
+        return it->second;
+    }
+    [[nodiscard]] const V &at(const K &key) const {
+        auto it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("Key not found in FlatMap");
+        }
+        return it->second;
+    }
+
+    V &operator[](const K &key) {
+        return try_emplace(key).first->second;
+    }
+
+    template <typename KK, typename VV>
+    std::pair<iterator, bool> insert_or_assign(KK &&key, VV &&value) {
+        auto [it, inserted] = try_emplace(std::forward<KK>(key));
+        it->second = std::forward<VV>(value);
+        return {it, inserted};
+    }
+
+    template <typename KK> std::pair<iterator, bool> try_emplace(KK &&key) {
+        if (m_entries.empty() || m_compare(m_entries.back().first, key)) {
+            m_entries.emplace_back(std::forward<KK>(key), V{});
+            return {std::prev(end()), true};
+        }
+        auto it = lower_bound(key);
+        if (it != end() && !m_compare(key, it->first)) {
+            return {it, false};
+        }
+        return {m_entries.emplace(it, std::forward<KK>(key), V{}), true};
+    }
+
+    std::size_t erase(const K &key) {
+        auto it = find(key);
+        if (it == end()) {
+            return 0;
+        }
+        m_entries.erase(it);
+        return 1;
+    }
+
+    friend bool operator==(const FlatMap &lhs, const FlatMap &rhs) {
+        return lhs.m_entries == rhs.m_entries;
+    }
+
+  private:
+    [[nodiscard]] iterator lower_bound(const K &key) {
+        return std::ranges::lower_bound(m_entries, key, m_compare,
+                                        &value_type::first);
+    }
+    [[nodiscard]] const_iterator lower_bound(const K &key) const {
+        return std::ranges::lower_bound(m_entries, key, m_compare,
+                                        &value_type::first);
+    }
+
+    std::vector<value_type> m_entries;
+    [[no_unique_address]] Compare m_compare;
+};
+
+// Map entry fields hold the key as field 1 and the value as field 2
+inline constexpr Field k_map_key_field{1};
+inline constexpr Field k_map_value_field{2};
+
+// Encoded size of the key or value of an entry, field key included
+template <typename Encoding, typename V>
+constexpr std::size_t map_entry_field_size(Field field, const V &value) {
+    if constexpr (std::is_same_v<Encoding, Varlen>) {
+        // Sized directly rather than through a Record, which would copy the
+        // sequence into a temporary Varlen first
+        const auto size = std::ranges::size(value);
+        return Varint{Key{field, WireType::LEN}.value()}.size() +
+               Varint{size}.size() + size;
+    } else {
+        return Record{field, Encoding{value}}.size();
+    }
+}
+
+template <typename Encoding, typename V>
+constexpr std::size_t serialize_map_entry_field(Field field, const V &value,
+                                                std::span<std::byte> buffer) {
+    if constexpr (std::is_same_v<Encoding, Varlen>) {
+        const auto bytes = std::as_bytes(
+            std::span{std::ranges::data(value), std::ranges::size(value)});
+        auto num_bytes_written =
+            Varint{Key{field, WireType::LEN}.value()}.serialize(buffer);
+        num_bytes_written +=
+            Varint{bytes.size()}.serialize(buffer.subspan(num_bytes_written));
+        if (buffer.size() - num_bytes_written < bytes.size()) {
+            throw std::runtime_error("Buffer too small to serialize map");
+        }
+        if (!bytes.empty()) {
+            std::memcpy(buffer.data() + num_bytes_written, bytes.data(),
+                        bytes.size());
+        }
+        return num_bytes_written + bytes.size();
+    } else {
+        return Record{field, Encoding{value}}.serialize(buffer);
+    }
+}
+
+// Size of an entry message, without its field key and length prefix. Both
+// key and value are always written, as Google's implementation does.
+template <typename Encoding, typename K, typename V>
+constexpr std::size_t map_entry_size(const K &key, const V &value) {
+    return map_entry_field_size<typename Encoding::key_encoding>(
+               k_map_key_field, key) +
+           map_entry_field_size<typename Encoding::mapped_encoding>(
+               k_map_value_field, value);
+}
+
+// Size of the whole map field: one keyed, length-prefixed entry per element
+template <typename Encoding, MapContainer M>
+constexpr std::size_t map_field_size(Field field, const M &map) {
+    const auto key_size = Varint{Key{field, WireType::LEN}.value()}.size();
+    std::size_t size = 0;
+    for (const auto &[key, value] : map) {
+        const auto entry_size = map_entry_size<Encoding>(key, value);
+        size += key_size + Varint{entry_size}.size() + entry_size;
+    }
+    return size;
+}
+
+template <typename Encoding, typename K, typename V>
+constexpr std::size_t serialize_map_entry(Field field, const K &key,
+                                          const V &value,
+                                          std::span<std::byte> buffer) {
+    const auto entry_size = map_entry_size<Encoding>(key, value);
+    auto num_bytes_written =
+        Varint{Key{field, WireType::LEN}.value()}.serialize(buffer);
+    num_bytes_written +=
+        Varint{entry_size}.serialize(buffer.subspan(num_bytes_written));
+    num_bytes_written +=
+        serialize_map_entry_field<typename Encoding::key_encoding>(
+            k_map_key_field, key, buffer.subspan(num_bytes_written));
+    num_bytes_written +=
+        serialize_map_entry_field<typename Encoding::mapped_encoding>(
+            k_map_value_field, value, buffer.subspan(num_bytes_written));
+    return num_bytes_written;
+}
+
+// Ordered containers already iterate in key order
+template <typename M>
+concept OrderedMap = MapContainer<M> && requires { typename M::key_compare; };
+
+// Write every element of `map` as an entry of field `field`. With
+// `SortByKey`, entries of unordered containers are written in key order.
+template <typename Encoding, bool SortByKey, MapContainer M>
+constexpr std::size_t serialize_map_field(Field field, const M &map,
+                                          std::span<std::byte> buffer) {
+    std::size_t num_bytes_written = 0;
+    if constexpr (SortByKey && !OrderedMap<M>) {
+        std::vector<const typename M::value_type *> entries;
+        entries.reserve(std::ranges::size(map));
+        for (const auto &entry : map) {
+            entries.push_back(&entry);
+        }
+        std::ranges::sort(entries, [](const auto *lhs, const auto *rhs) {
+            return lhs->first < rhs->first;
+        });
+        for (const auto *entry : entries) {
+            num_bytes_written += serialize_map_entry<Encoding>(
+                field, entry->first, entry->second,
+                buffer.subspan(num_bytes_written));
+        }
+    } else {
+        for (const auto &[key, value] : map) {
+            num_bytes_written += serialize_map_entry<Encoding>(
+                field, key, value, buffer.subspan(num_bytes_written));
+        }
+    }
+    return num_bytes_written;
+}
+
+// Decode one entry message. A missing key or value decodes to its default,
+// and unknown fields are skipped. Text keys and values are checked for UTF-8
+// if `ValidateText`, which is ValidateUtf8 of the map member.
+template <typename Encoding, MapContainer M, bool ValidateText = true>
+constexpr std::pair<typename M::key_type, typename M::mapped_type>
+decode_map_entry(std::span<const std::byte> payload) {
+    std::pair<typename M::key_type, typename M::mapped_type> entry{};
+    while (!payload.empty()) {
+        auto deserialized = read_field(payload);
+        if (deserialized.num_bytes_read == 0) {
+            throw std::runtime_error("Error parsing map entry");
+        }
+        const auto &field = deserialized.value;
+        if (field.field_number() == k_map_key_field) {
+            entry.first =
+                decode_value<typename M::key_type,
+                             typename Encoding::key_encoding, ValidateText>(
+                    field);
+        } else if (field.field_number() == k_map_value_field) {
+            entry.second =
+                decode_value<typename M::mapped_type,
+                             typename Encoding::mapped_encoding, ValidateText>(
+                    field);
+        }
+        payload = payload.subspan(deserialized.num_bytes_read);
+    }
+    return entry;
+}
+
+// Decode one entry message into `map`. As in Google's implementation, a
+// later entry with the same key replaces an earlier one.
+template <typename Encoding, bool ValidateText = true, MapContainer M>
+constexpr void merge_map_entry(std::span<const std::byte> payload, M &map) {
+    auto [key, value] = decode_map_entry<Encoding, M, ValidateText>(payload);
+    map.insert_or_assign(std::move(key), std::move(value));
+}
+
+template <typename Obj> consteval bool has_map_members() {
+    bool found = false;
+    for_each_member<Obj>([&]<auto MemberPtr, std::size_t Index>() {
+        found = found ||
+                MapContainer<optional_value_t<typename MemberPointerTraits<
+                    decltype(MemberPtr)>::member_type>>;
+    });
+    return found;
+}
+
+// Map containers that can make room for their elements up front, e.g.
+// std::unordered_map and FlatMap
+template <typename M>
+concept ReservableMap =
+    MapContainer<M> && requires(M &map, std::size_t size) {
+        map.reserve(size);
+    };
+
+template <typename Obj> consteval bool has_reservable_maps() {
+    bool found = false;
+    for_each_member<Obj>([&]<auto MemberPtr, std::size_t Index>() {
+        found = found ||
+                ReservableMap<optional_value_t<typename MemberPointerTraits<
+                    decltype(MemberPtr)>::member_type>>;
+    });
+    return found;
+}
+
+// Count the entries of every map member in `data` and reserve room for all
+// of them at once, so that decoding does not rehash or reallocate as the
+// map grows. The count only looks at field keys and lengths, without
+// decoding the entries. Malformed input is left for the decoder to report.
+template <typename Obj>
+constexpr void reserve_map_entries(std::span<const std::byte> data,
+                                   Obj &obj) {
+    std::array<std::size_t, Obj::members::s_num_elems> counts{};
+    while (!data.empty()) {
+        auto deserialized = read_field(data);
+        if (deserialized.num_bytes_read == 0) {
+            break;
+        }
+        const auto index =
+            std::to_underlying(deserialized.value.field_number()) - 1;
+        if (index < counts.size() &&
+            deserialized.value.wire_type() == WireType::LEN) {
+            counts[index]++;
+        }
+        data = data.subspan(deserialized.num_bytes_read);
+    }
+
+    for_each_member<Obj>([&]<auto MemberPtr, std::size_t Index>() {
+        using Member =
+            typename MemberPointerTraits<decltype(MemberPtr)>::member_type;
+        if constexpr (ReservableMap<optional_value_t<Member>>) {
+            if (counts[Index] == 0) {
+                return;
+            }
+            auto &member = obj.*MemberPtr;
+            if constexpr (is_optional_v<Member>) {
+                // Decoding the entries would engage it anyway
+                if (!member.has_value()) {
+                    member.emplace();
+                }
+                member->reserve(member->size() + counts[Index]);
+            } else {
+                member.reserve(member.size() + counts[Index]);
+            }
+        }
+    });
+}
+
+} // namespace proto
@@ -0,0 +1,380 @@
+#pragma once
+
+#include "Field.h"
+#include "Fixint.h"
+#include "Key.h"
+#include "Varint.h"
+#include "WireType.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <numeric>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace proto {
+
+// Packed repeated scalars: a single LEN field whose payload is the
+// concatenated encodings of the elements, without per-element keys.
+// `Encoding` is Varint, Fixint32 or Fixint64.
+
+// Encoded size of every element, or 0 for variable-width encodings
+template <typename Encoding> consteval std::size_t fixed_element_size() {
+    if constexpr (std::is_same_v<Encoding, Varint>) {
+        return 0;
+    } else {
+        return Encoding::size();
+    }
+}
+
+template <typename Encoding, typename T>
+constexpr Encoding encode_element(const T &value) noexcept {
+    return Encoding{value};
+}
+
+template <typename Encoding, std::ranges::input_range R>
+constexpr std::size_t packed_payload_size(R &&values) {
+    if constexpr (std::is_same_v<Encoding, Varint>) {
+        std::size_t size = 0;
+        for (const auto &value : values) {
+            size += encode_element<Encoding>(value).size();
+        }
+        return size;
+    } else {
+        return static_cast<std::size_t>(std::ranges::distance(values)) *
+               Encoding::size();
+    }
+}
+
+// Size of the whole field: key, length prefix and payload
+template <typename Encoding, std::ranges::input_range R>
+constexpr std::size_t packed_size(Field field, R &&values) {
+    const auto payload_size = packed_payload_size<Encoding>(values);
+    return Varint{Key{field, WireType::LEN}.value()}.size() +
+           Varint{payload_size}.size() + payload_size;
+}
+
+// Write the elements back to back, without key or length prefix
+template <typename Encoding, std::ranges::input_range R>
+constexpr std::size_t serialize_packed_payload(R &&values,
+                                               std::span<std::byte> buffer) {
+    std::size_t num_bytes_written = 0;
+    for (const auto &value : values) {
+        num_bytes_written += encode_element<Encoding>(value).serialize(
+            buffer.subspan(num_bytes_written));
+    }
+    return num_bytes_written;
+}
+
+template <typename Encoding, std::ranges::input_range R>
+constexpr std::size_t serialize_packed(Field field, R &&values,
+                                       std::span<std::byte> buffer) {
+    const auto payload_size = packed_payload_size<Encoding>(values);
+    const Varint key{Key{field, WireType::LEN}.value()};
+    const Varint length{payload_size};
+    if (buffer.size() < key.size() + length.size() + payload_size) {
+        throw std::runtime_error("Buffer too small to serialize packed field");
+    }
+
+    auto num_bytes_written = key.serialize(buffer);
+    num_bytes_written += length.serialize(buffer.subspan(num_bytes_written));
+    return num_bytes_written +
+           serialize_packed_payload<Encoding>(
+               values, buffer.subspan(num_bytes_written));
+}
+
+// Number of elements in a packed payload. Throws std::runtime_error if the
+// payload does not hold a whole number of elements.
+template <typename Encoding>
+constexpr std::size_t packed_count(std::span<const std::byte> payload) {
+    if constexpr (std::is_same_v<Encoding, Varint>) {
+        constexpr std::byte continue_mask{0b1000'0000};
+        std::size_t count = 0;
+        for (auto byte : payload) {
+            count += bool(byte & continue_mask) ? 0 : 1;
+        }
+        if (!payload.empty() && bool(payload.back() & continue_mask)) {
+            throw std::runtime_error("Packed field ends in a partial varint");
+        }
+        return count;
+    } else {
+        if (payload.size() % Encoding::size() != 0) {
+            throw std::runtime_error("Packed field has a partial element");
+        }
+        return payload.size() / Encoding::size();
+    }
+}
+
+// Decode every element of a packed payload as `T`, calling f(value) in order
+template <typename Encoding, typename T, typename F>
+constexpr void for_each_packed(std::span<const std::byte> payload, F &&f) {
+    while (!payload.empty()) {
+        if constexpr (std::is_same_v<Encoding, Varint> &&
+                      std::is_integral_v<T>) {
+            // Bounded by the width of T rather than decoded as 64-bit
+            auto deserialized = Varint::deserialize_as<T>(payload);
+            if (deserialized.num_bytes_read == 0) {
+                throw std::runtime_error("Error parsing packed element");
+            }
+            f(deserialized.value);
+            payload = payload.subspan(deserialized.num_bytes_read);
+        } else {
+            auto deserialized = Encoding::deserialize(payload);
+            if (deserialized.num_bytes_read == 0) {
+                throw std::runtime_error("Error parsing packed element");
+            }
+            f(deserialized.value.template as<T>());
+            payload = payload.subspan(deserialized.num_bytes_read);
+        }
+    }
+}
+
+// Decode a packed payload into contiguous storage, which must hold exactly
+// packed_count<Encoding>(payload) elements
+template <typename Encoding, typename T>
+void decode_packed(std::span<const std::byte> payload, std::span<T> out) {
+    if constexpr (sizeof(T) == fixed_element_size<Encoding>() &&
+                  std::is_trivially_copyable_v<T> &&
+                  std::endian::native == std::endian::little) {
+        // Fixed-width little-endian elements have the in-memory layout
+        if (payload.size() != out.size_bytes()) {
+            throw std::runtime_error("Packed field size mismatch");
+        }
+        if (!payload.empty()) {
+            std::memcpy(out.data(), payload.data(), payload.size());
+        }
+    } else {
+        std::size_t i = 0;
+        for_each_packed<Encoding, T>(payload, [&](T value) {
+            if (i == out.size()) {
+                throw std::runtime_error("Packed field size mismatch");
+            }
+            out[i++] = value;
+        });
+        if (i != out.size()) {
+            throw std::runtime_error("Packed field size mismatch");
+        }
+    }
+}
+
+// Parallel encoding and decoding of a single large packed field. The work is
+// split into one contiguous chunk per thread, and the chunk results are
+// placed with a prefix sum, so the bytes produced are identical to the
+// sequential functions above.
+
+// Chunks smaller than this many elements (or payload bytes) are not worth a
+// thread of their own
+inline constexpr std::size_t k_min_parallel_chunk = 16 * 1024;
+
+// Number of chunks to split `count` units of work into
+constexpr std::size_t parallel_chunk_count(std::size_t count,
+                                           std::size_t num_threads) noexcept {
+    return std::clamp<std::size_t>(count / k_min_parallel_chunk, 1,
+                                   std::max<std::size_t>(num_threads, 1));
+}
+
+// Call f(chunk, begin, end) for `num_chunks` contiguous chunks of
+// [0, count), each on its own thread. The first exception thrown by a chunk
+// is rethrown once all of them have finished.
+template <typename F>
+void run_parallel_chunks(std::size_t count, std::size_t num_chunks, F &&f) {
+    if (num_chunks <= 1) {
+        f(std::size_t{0}, std::size_t{0}, count);
+        return;
+    }
+
+    std::vector<std::exception_ptr> errors(num_chunks);
+    {
+        std::vector<std::jthread> workers;
+        for (std::size_t chunk = 0; chunk < num_chunks; chunk++) {
+            const auto begin = count * chunk / num_chunks;
+            const auto end = count * (chunk + 1) / num_chunks;
+            workers.emplace_back([&, chunk, begin, end] {
+                try {
+                    f(chunk, begin, end);
+                } catch (...) {
+                    errors[chunk] = std::current_exception();
+                }
+            });
+        }
+    }
+    for (const auto &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+// Payload offset of every chunk of `values`, plus the total payload size as
+// the last element
+template <typename Encoding, std::ranges::random_access_range R>
+    requires std::ranges::sized_range<R>
+std::vector<std::size_t> packed_chunk_offsets(R &&values,
+                                              std::size_t num_chunks) {
+    std::vector<std::size_t> offsets(num_chunks + 1);
+    run_parallel_chunks(
+        std::ranges::size(values), num_chunks,
+        [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+            offsets[chunk + 1] = packed_payload_size<Encoding>(
+                std::ranges::subrange(std::ranges::begin(values) + begin,
+                                      std::ranges::begin(values) + end));
+        });
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    return offsets;
+}
+
+// Write the key, the length prefix and every chunk of `values` at the
+// offsets given by packed_chunk_offsets, encoding the chunks concurrently
+template <typename Encoding, std::ranges::random_access_range R>
+    requires std::ranges::sized_range<R>
+std::size_t serialize_packed_chunks(Field field, R &&values,
+                                    std::span<const std::size_t> offsets,
+                                    std::span<std::byte> buffer) {
+    const Varint key{Key{field, WireType::LEN}.value()};
+    const Varint length{offsets.back()};
+    if (buffer.size() < key.size() + length.size() + offsets.back()) {
+        throw std::runtime_error("Buffer too small to serialize packed field");
+    }
+    auto header_size = key.serialize(buffer);
+    header_size += length.serialize(buffer.subspan(header_size));
+    const auto payload = buffer.subspan(header_size, offsets.back());
+
+    run_parallel_chunks(
+        std::ranges::size(values), offsets.size() - 1,
+        [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+            serialize_packed_payload<Encoding>(
+                std::ranges::subrange(std::ranges::begin(values) + begin,
+                                      std::ranges::begin(values) + end),
+                payload.subspan(offsets[chunk],
+                                offsets[chunk + 1] - offsets[chunk]));
+        });
+    return header_size + offsets.back();
+}
+
+// serialize_packed using up to `num_threads` threads: the encoded size of
+// every chunk is computed in parallel, then every chunk is encoded into its
+// own slot of the payload
+template <typename Encoding, std::ranges::random_access_range R>
+    requires std::ranges::sized_range<R>
+std::size_t serialize_packed_parallel(Field field, R &&values,
+                                      std::span<std::byte> buffer,
+                                      std::size_t num_threads) {
+    const auto offsets = packed_chunk_offsets<Encoding>(
+        values,
+        parallel_chunk_count(std::ranges::size(values), num_threads));
+    return serialize_packed_chunks<Encoding>(field, values, offsets, buffer);
+}
+
+// Same, into a new buffer sized from the chunk sizes
+template <typename Encoding, std::ranges::random_access_range R>
+    requires std::ranges::sized_range<R>
+std::vector<std::byte> serialize_packed_parallel(Field field, R &&values,
+                                                 std::size_t num_threads) {
+    const auto offsets = packed_chunk_offsets<Encoding>(
+        values,
+        parallel_chunk_count(std::ranges::size(values), num_threads));
+    std::vector<std::byte> buffer(
+        Varint{Key{field, WireType::LEN}.value()}.size() +
+        Varint{offsets.back()}.size() + offsets.back());
+    serialize_packed_chunks<Encoding>(field, values, offsets,
+                                      std::span<std::byte>{buffer});
+    return buffer;
+}
+
+// Split a packed payload into about `num_chunks` segments holding a whole
+// number of elements each. Varint boundaries are found by moving each split
+// point forward past the end of the element it falls in.
+template <typename Encoding>
+std::vector<std::span<const std::byte>>
+split_packed(std::span<const std::byte> payload, std::size_t num_chunks) {
+    constexpr std::byte continue_mask{0b1000'0000};
+
+    std::vector<std::span<const std::byte>> segments;
+    std::size_t begin = 0;
+    for (std::size_t chunk = 1; chunk <= num_chunks; chunk++) {
+        auto end = payload.size() * chunk / num_chunks;
+        if constexpr (std::is_same_v<Encoding, Varint>) {
+            while (end < payload.size() && end > 0 &&
+                   bool(payload[end - 1] & continue_mask)) {
+                end++;
+            }
+        } else {
+            end -= end % Encoding::size();
+        }
+        end = chunk == num_chunks ? payload.size() : std::max(begin, end);
+        if (end > begin) {
+            segments.push_back(payload.subspan(begin, end - begin));
+        }
+        begin = end;
+    }
+    return segments;
+}
+
+// Output offset of every segment, plus the total element count as the last
+// element
+template <typename Encoding>
+std::vector<std::size_t>
+packed_segment_offsets(std::span<const std::span<const std::byte>> segments) {
+    std::vector<std::size_t> offsets(segments.size() + 1);
+    run_parallel_chunks(
+        segments.size(), segments.size(),
+        [&](std::size_t chunk, std::size_t, std::size_t) {
+            offsets[chunk + 1] = packed_count<Encoding>(segments[chunk]);
+        });
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    return offsets;
+}
+
+template <typename Encoding, typename T>
+void decode_packed_segments(
+    std::span<const std::span<const std::byte>> segments,
+    std::span<const std::size_t> offsets, std::span<T> out) {
+    run_parallel_chunks(
+        segments.size(), segments.size(),
+        [&](std::size_t chunk, std::size_t, std::size_t) {
+            decode_packed<Encoding>(
+                segments[chunk],
+                out.subspan(offsets[chunk],
+                            offsets[chunk + 1] - offsets[chunk]));
+        });
+}
+
+// decode_packed using up to `num_threads` threads: element boundaries are
+// located first, then the segments between them are counted and decoded
+// concurrently
+template <typename Encoding, typename T>
+void decode_packed_parallel(std::span<const std::byte> payload,
+                            std::span<T> out, std::size_t num_threads) {
+    const auto segments = split_packed<Encoding>(
+        payload, parallel_chunk_count(payload.size(), num_threads));
+    const auto offsets = packed_segment_offsets<Encoding>(segments);
+    if (offsets.back() != out.size()) {
+        throw std::runtime_error("Packed field size mismatch");
+    }
+    decode_packed_segments<Encoding>(segments, offsets, out);
+}
+
+template <typename Encoding, typename T>
+std::vector<T> decode_packed_parallel(std::span<const std::byte> payload,
+                                      std::size_t num_threads) {
+    // std::vector<bool> elements cannot be written concurrently
+    static_assert(!std::is_same_v<T, bool>,
+                  "Use the std::span overload to decode bool elements");
+
+    const auto segments = split_packed<Encoding>(
+        payload, parallel_chunk_count(payload.size(), num_threads));
+    const auto offsets = packed_segment_offsets<Encoding>(segments);
+    std::vector<T> out(offsets.back());
+    decode_packed_segments<Encoding>(segments, offsets, std::span{out});
+    return out;
+}
+
+} // namespace proto
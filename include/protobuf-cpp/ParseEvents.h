@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Field.h"
+#include "Fixint.h"
+#include "Tokenizer.h"
+#include "Varint.h"
+#include "WireType.h"
+
+#include <concepts>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+
+namespace proto {
+
+// Receives the fields of a message as they are read off the wire
+template <typename V>
+concept EventVisitor = requires(V visitor, Field field, Varint varint,
+                                Fixint32 fixed32, Fixint64 fixed64,
+                                std::span<const std::byte> payload) {
+    visitor.on_varint(field, varint);
+    visitor.on_fixed32(field, fixed32);
+    visitor.on_fixed64(field, fixed64);
+    visitor.on_len(field, payload);
+};
+
+// A visitor may claim a LEN field as a nested message by returning true from
+// begin_message, in which case the payload is walked recursively and closed
+// with end_message instead of being passed to on_len
+template <typename V>
+concept NestedEventVisitor =
+    EventVisitor<V> && requires(V visitor, Field field,
+                                std::span<const std::byte> payload) {
+        { visitor.begin_message(field, payload) } -> std::convertible_to<bool>;
+        visitor.end_message(field);
+    };
+
+// Same limit as Google's implementation
+inline constexpr std::size_t k_max_nesting_depth = 100;
+
+template <EventVisitor Visitor>
+constexpr void parse_events(std::span<const std::byte> data, Visitor &visitor,
+                            std::size_t depth = 0);
+
+// Report a single field read off the wire to `visitor`
+template <EventVisitor Visitor>
+constexpr void parse_event(const WireField &field, Visitor &visitor,
+                           std::size_t depth = 0) {
+    switch (field.wire_type()) {
+    case WireType::VARINT:
+        visitor.on_varint(field.field_number(), Varint{field.varint});
+        break;
+    case WireType::FIXED64:
+        visitor.on_fixed64(field.field_number(),
+                           Fixint64::deserialize(field.payload).value);
+        break;
+    case WireType::FIXED32:
+        visitor.on_fixed32(field.field_number(),
+                           Fixint32::deserialize(field.payload).value);
+        break;
+    case WireType::LEN:
+        if constexpr (NestedEventVisitor<Visitor>) {
+            if (visitor.begin_message(field.field_number(), field.payload)) {
+                parse_events(field.payload, visitor, depth + 1);
+                visitor.end_message(field.field_number());
+                break;
+            }
+        }
+        visitor.on_len(field.field_number(), field.payload);
+        break;
+    default:
+        throw std::runtime_error("Invalid Wire Type");
+    }
+}
+
+// Walk the wire format of `data` and report every field to `visitor` without
+// materializing an object or allocating. No schema is needed; the visitor
+// decides which LEN fields are nested messages. Throws std::runtime_error on
+// malformed input.
+template <EventVisitor Visitor>
+constexpr void parse_events(std::span<const std::byte> data, Visitor &visitor,
+                            std::size_t depth) {
+    if (depth > k_max_nesting_depth) {
+        throw std::runtime_error("Exceeded maximum message nesting depth");
+    }
+
+    while (!data.empty()) {
+        auto deserialized = read_field(data);
+        if (deserialized.num_bytes_read == 0) {
+            throw std::runtime_error("Error parsing field");
+        }
+        data = data.subspan(deserialized.num_bytes_read);
+        parse_event(deserialized.value, visitor, depth);
+    }
+}
+
+} // namespace proto
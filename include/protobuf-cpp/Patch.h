@@ -0,0 +1,152 @@
+#pragma once
+
+#include "Concepts.h"
+#include "Encoding.h"
+#include "Field.h"
+#include "Key.h"
+#include "Tokenizer.h"
+#include "Varint.h"
+
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace proto {
+
+// In-place updates of single fields in an already-serialized message, without
+// deserializing it. The field is located with a wire-level scan and its value
+// rewritten where it lies: fixed-width values and values whose new encoding
+// has the same size are overwritten, anything else shifts the rest of the
+// message once to make or give back room.
+
+// Position of a field's value within a message
+struct FieldSlot {
+    // Offset of the value, just past the field key
+    std::size_t offset;
+    // Encoded size of the value
+    std::size_t size;
+    // False if the message has no such field. The slot is then the empty
+    // range at the end of the message, where the field is to be appended.
+    bool found;
+};
+
+// Locate the last field with `key` in `message`, which is the one a decoder
+// keeps. Throws std::runtime_error on malformed input.
+constexpr FieldSlot find_field_slot(std::span<const std::byte> message,
+                                    Key key) {
+    FieldSlot slot{message.size(), 0, false};
+    std::size_t offset = 0;
+    while (offset < message.size()) {
+        auto deserialized = read_field(message.subspan(offset));
+        if (deserialized.num_bytes_read == 0) {
+            throw std::runtime_error("Error parsing field");
+        }
+        const auto &field = deserialized.value;
+        if (field.key == key) {
+            const auto key_size = read_varint(field.bytes).num_bytes_read;
+            slot = FieldSlot{offset + key_size, field.bytes.size() - key_size,
+                             true};
+        }
+        offset += deserialized.num_bytes_read;
+    }
+    return slot;
+}
+
+// Encoded size of the message once `value` is written into `slot`
+template <Wirable Encoding>
+constexpr std::size_t patched_size(std::size_t size, const FieldSlot &slot,
+                                   Key key, const Encoding &value) {
+    const auto key_size = slot.found ? 0 : Varint{key.value()}.size();
+    return size - slot.size + key_size + value.size();
+}
+
+// Write `value` into `slot` of the message held in buffer.first(size),
+// moving the bytes after the slot if its size changes. The buffer must have
+// room for patched_size bytes.
+template <Wirable Encoding>
+constexpr void write_field_slot(std::span<std::byte> buffer, std::size_t size,
+                                const FieldSlot &slot, Key key,
+                                const Encoding &value) {
+    const Varint key_varint{key.value()};
+    const auto key_size = slot.found ? 0 : key_varint.size();
+    const auto new_slot_size = key_size + value.size();
+
+    if (new_slot_size != slot.size) {
+        const auto tail = slot.offset + slot.size;
+        std::memmove(buffer.data() + slot.offset + new_slot_size,
+                     buffer.data() + tail, size - tail);
+    }
+    if (!slot.found) {
+        key_varint.serialize(buffer.subspan(slot.offset, key_size));
+    }
+    value.serialize(buffer.subspan(slot.offset + key_size, value.size()));
+}
+
+// Set field `field` of the message held in buffer.first(size) to `value`,
+// appending the field if it is absent. The rest of `buffer` is spare room
+// for a value that grows. Returns the new size of the message. Throws
+// std::runtime_error on malformed input or if the buffer is too small.
+template <Wirable Encoding>
+constexpr std::size_t patch_field(std::span<std::byte> buffer,
+                                  std::size_t size, Field field,
+                                  const Encoding &value) {
+    if (size > buffer.size()) {
+        throw std::runtime_error("Message size exceeds buffer");
+    }
+    const Key key{field, Encoding::k_wire_type};
+    const auto slot = find_field_slot(buffer.first(size), key);
+    const auto new_size = patched_size(size, slot, key, value);
+    if (new_size > buffer.size()) {
+        throw std::runtime_error("Buffer too small to patch field");
+    }
+    write_field_slot(buffer, size, slot, key, value);
+    return new_size;
+}
+
+// Same, resizing `message` to fit the new value
+template <Wirable Encoding>
+void patch_field(std::vector<std::byte> &message, Field field,
+                 const Encoding &value) {
+    const Key key{field, Encoding::k_wire_type};
+    const auto size = message.size();
+    const auto slot = find_field_slot(message, key);
+    const auto new_size = patched_size(size, slot, key, value);
+    if (new_size > size) {
+        message.resize(new_size);
+    }
+    write_field_slot(std::span<std::byte>{message}, size, slot, key, value);
+    if (new_size < size) {
+        message.resize(new_size);
+    }
+}
+
+// Value type of a member, looking through std::optional
+template <auto MemberPtr>
+using member_value_t = optional_value_t<
+    typename MemberPointerTraits<decltype(MemberPtr)>::member_type>;
+
+// patch_field for a member listed in its class's Members<...>, using the
+// member's field number and MemberEncoding
+template <auto MemberPtr>
+constexpr std::size_t patch_member(std::span<std::byte> buffer,
+                                   std::size_t size,
+                                   const member_value_t<MemberPtr> &value) {
+    using Class = typename MemberPointerTraits<decltype(MemberPtr)>::class_type;
+    using Encoding = typename MemberEncoding<MemberPtr>::type;
+    return patch_field(buffer, size,
+                       field_of<MemberPtr>(typename Class::members{}),
+                       Encoding{value});
+}
+
+template <auto MemberPtr>
+void patch_member(std::vector<std::byte> &message,
+                  const member_value_t<MemberPtr> &value) {
+    using Class = typename MemberPointerTraits<decltype(MemberPtr)>::class_type;
+    using Encoding = typename MemberEncoding<MemberPtr>::type;
+    patch_field(message, field_of<MemberPtr>(typename Class::members{}),
+                Encoding{value});
+}
+
+} // namespace proto
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "Deserialize.h"
+#include "Serialize.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace proto {
+
+// Opt-in profiling of the codec entry points on live traffic. The
+// profiled_serialize and profiled_deserialize wrappers behave like
+// serialize and deserialize, and additionally measure one call in every
+// sample period with the CPU's performance counters (Linux perf_event_open:
+// cycles, instructions, branch misses, cache misses). The measurements are
+// aggregated per message type and operation into cycles per byte and
+// instructions per cycle. Where perf events are not available (non-Linux,
+// containers, perf_event_paranoid), only wall time is measured.
+//
+// Calls that are not sampled cost a thread-local counter decrement.
+
+enum class CodecOperation : std::uint8_t { Serialize, Deserialize };
+
+enum class Counter : std::uint8_t {
+    Cycles,
+    Instructions,
+    BranchMisses,
+    CacheMisses,
+};
+inline constexpr std::size_t k_num_counters = 4;
+
+// Counter values at one point in time on the calling thread
+struct CounterReading {
+    std::array<std::uint64_t, k_num_counters> counters{};
+    // Counters the thread could not open are left out
+    std::array<bool, k_num_counters> counted{};
+    // How long the counters were enabled and actually counting. They differ
+    // when the kernel multiplexes more events than the CPU has counters.
+    std::uint64_t time_enabled{};
+    std::uint64_t time_running{};
+    std::uint64_t nanoseconds{};
+};
+
+// Aggregated measurements of one operation on one message type
+struct CodecProfile {
+    std::string message_type;
+    CodecOperation operation;
+    std::uint64_t num_samples{};
+    std::uint64_t num_bytes{};
+    std::uint64_t nanoseconds{};
+    std::array<std::uint64_t, k_num_counters> counters{};
+    // Which counters were measured for every sample
+    std::array<bool, k_num_counters> counted{};
+
+    [[nodiscard]] std::uint64_t counter(Counter counter) const noexcept {
+        return counters[static_cast<std::size_t>(counter)];
+    }
+    [[nodiscard]] bool has(Counter counter) const noexcept {
+        return counted[static_cast<std::size_t>(counter)];
+    }
+
+    [[nodiscard]] double nanoseconds_per_byte() const noexcept;
+    // Only meaningful if has(Counter::Cycles)
+    [[nodiscard]] double cycles_per_byte() const noexcept;
+    // Only meaningful if has(Counter::Cycles) and has(Counter::Instructions)
+    [[nodiscard]] double instructions_per_cycle() const noexcept;
+};
+
+class CodecProfiler {
+  public:
+    static constexpr std::uint32_t k_default_sample_period = 64;
+
+    // The process-wide profiler used by the profiled_* wrappers
+    static CodecProfiler &global();
+
+    CodecProfiler() = default;
+    CodecProfiler(const CodecProfiler &) = delete;
+    CodecProfiler &operator=(const CodecProfiler &) = delete;
+
+    // Measure one call in every `sample_period` on each thread, on average.
+    // The calls in between are skipped in random numbers so that sampling
+    // does not lock onto a periodic call pattern. 0 turns profiling off,
+    // which is the default.
+    void set_sample_period(std::uint32_t sample_period) noexcept {
+        m_sample_period.store(sample_period, std::memory_order_relaxed);
+    }
+
+    // Whether the calling thread can read hardware counters
+    [[nodiscard]] static bool hardware_counters_available();
+
+    // Start a measurement if this call is to be sampled
+    [[nodiscard]] std::optional<CounterReading> start_sample() {
+        const auto period = m_sample_period.load(std::memory_order_relaxed);
+        if (period == 0) {
+            return std::nullopt;
+        }
+        // A thread's first countdown is drawn on its first call rather than
+        // sampling that call, and a countdown drawn for a longer period is
+        // redrawn, so that a shorter period applies at once
+        if (s_calls_until_sample == 0 ||
+            s_calls_until_sample > 2 * std::uint64_t{period} - 1) {
+            s_calls_until_sample = next_sample_gap(period);
+        }
+        if (s_calls_until_sample > 1) {
+            s_calls_until_sample--;
+            return std::nullopt;
+        }
+        s_calls_until_sample = next_sample_gap(period);
+        return read_counters();
+    }
+
+    // Finish a measurement started by start_sample
+    void finish_sample(const std::type_info &type, CodecOperation operation,
+                       std::size_t num_bytes, const CounterReading &start);
+
+    // Everything measured so far, sorted by message type and operation
+    [[nodiscard]] std::vector<CodecProfile> profiles() const;
+
+    // profiles() as a human-readable table
+    [[nodiscard]] std::string report() const;
+
+    void reset();
+
+  private:
+    struct Key {
+        std::type_index type;
+        CodecOperation operation;
+        bool operator==(const Key &) const = default;
+    };
+
+    [[nodiscard]] static CounterReading read_counters();
+    // Calls until the next sample, uniform in [1, 2 * period - 1]
+    [[nodiscard]] static std::uint32_t
+    next_sample_gap(std::uint32_t period) noexcept;
+
+    static thread_local std::uint32_t s_calls_until_sample;
+
+    std::atomic<std::uint32_t> m_sample_period{};
+    mutable std::mutex m_mutex;
+    std::vector<std::pair<Key, CodecProfile>> m_profiles;
+};
+
+template <typename T>
+std::size_t profiled_serialize(const T &obj, std::span<std::byte> buffer) {
+    auto &profiler = CodecProfiler::global();
+    const auto sample = profiler.start_sample();
+    const auto size = serialize(obj, buffer);
+    if (sample.has_value()) {
+        profiler.finish_sample(typeid(T), CodecOperation::Serialize, size,
+                               *sample);
+    }
+    return size;
+}
+
+template <typename T> std::vector<std::byte> profiled_serialize(const T &obj) {
+    auto &profiler = CodecProfiler::global();
+    const auto sample = profiler.start_sample();
+    auto serialized = serialize(obj);
+    if (sample.has_value()) {
+        profiler.finish_sample(typeid(T), CodecOperation::Serialize,
+                               serialized.size(), *sample);
+    }
+    return serialized;
+}
+
+template <typename T> T profiled_deserialize(std::span<const std::byte> data) {
+    auto &profiler = CodecProfiler::global();
+    const auto sample = profiler.start_sample();
+    auto obj = deserialize<T>(data);
+    if (sample.has_value()) {
+        profiler.finish_sample(typeid(T), CodecOperation::Deserialize,
+                               data.size(), *sample);
+    }
+    return obj;
+}
+
+} // namespace proto
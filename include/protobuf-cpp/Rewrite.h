@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Field.h"
+#include "Key.h"
+#include "Tokenizer.h"
+#include "Varint.h"
+
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace proto {
+
+// Maps an input field number to its output field number, or std::nullopt to
+// drop the field
+template <typename F>
+concept FieldMapping = std::invocable<F &, Field> &&
+                       std::convertible_to<std::invoke_result_t<F &, Field>,
+                                           std::optional<Field>>;
+
+// Copy the fields of `input` into `output` in a single pass, dropping or
+// renumbering them according to `mapping`. Values are never decoded: kept
+// fields are copied as raw bytes, with adjacent kept fields coalesced into a
+// single memcpy, and renumbered fields only have their key rewritten.
+// Returns the number of bytes written. Throws std::runtime_error on malformed
+// input or if `output` is too small.
+template <FieldMapping Mapping>
+std::size_t rewrite_fields(std::span<const std::byte> input,
+                           std::span<std::byte> output, Mapping mapping) {
+    std::size_t num_bytes_written = 0;
+
+    auto write = [&](std::span<const std::byte> bytes) {
+        if (bytes.empty()) {
+            return;
+        }
+        if (output.size() - num_bytes_written < bytes.size()) {
+            throw std::runtime_error("Buffer too small to rewrite fields");
+        }
+        std::memcpy(output.data() + num_bytes_written, bytes.data(),
+                    bytes.size());
+        num_bytes_written += bytes.size();
+    };
+
+    // Input bytes that are kept verbatim but not yet copied
+    const std::byte *pending_begin = input.data();
+    const std::byte *pending_end = input.data();
+
+    auto remaining = input;
+    while (!remaining.empty()) {
+        auto deserialized = read_field(remaining);
+        if (deserialized.num_bytes_read == 0) {
+            throw std::runtime_error("Error parsing field");
+        }
+        const auto &field = deserialized.value;
+        remaining = remaining.subspan(deserialized.num_bytes_read);
+
+        const std::optional<Field> mapped = mapping(field.field_number());
+        if (mapped == field.field_number()) {
+            pending_end = field.bytes.data() + field.bytes.size();
+            continue;
+        }
+
+        write({pending_begin, pending_end});
+        pending_begin = pending_end = field.bytes.data() + field.bytes.size();
+
+        if (mapped.has_value()) {
+            if (std::to_underlying(*mapped) == 0) {
+                throw std::logic_error("Cannot renumber a field to 0");
+            }
+            const Varint new_key{Key{*mapped, field.wire_type()}.value()};
+            if (output.size() - num_bytes_written < new_key.size()) {
+                throw std::runtime_error("Buffer too small to rewrite fields");
+            }
+            num_bytes_written +=
+                new_key.serialize(output.subspan(num_bytes_written));
+
+            // Everything after the key is copied as-is, and may coalesce with
+            // the fields that follow
+            const auto key_size = read_varint(field.bytes).num_bytes_read;
+            pending_begin = field.bytes.data() + key_size;
+        }
+    }
+    write({pending_begin, pending_end});
+
+    return num_bytes_written;
+}
+
+} // namespace proto
@@ -0,0 +1,250 @@
+#pragma once
+
+#include "Deserialize.h"
+#include "Serialize.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+namespace proto {
+
+// Single-producer single-consumer ring of messages in a memory region that
+// the two sides share, typically a SharedMemory segment mapped by two
+// processes. The producer reserves room for a message, serializes it in
+// place and commits it; the consumer decodes it straight out of the ring and
+// releases it. Nothing is copied besides the encoding itself and no system
+// call is made, so both sides poll rather than block.
+//
+// Every message is stored as a 4-byte size followed by the message, padded to
+// 8 bytes. A message that would straddle the end of the ring is written at
+// its start instead, after a marker telling the consumer to wrap around.
+
+struct RingHeader {
+    static constexpr std::uint64_t k_magic = 0x474e495242504f52; // "ROPBRING"
+
+    std::uint64_t magic;
+    std::uint64_t capacity;
+    // Bytes committed by the producer and released by the consumer since the
+    // ring was created, each on its own cache line
+    alignas(64) std::atomic<std::uint64_t> head;
+    alignas(64) std::atomic<std::uint64_t> tail;
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "Rings shared between processes need lock-free atomics");
+
+inline constexpr std::size_t k_ring_data_offset = sizeof(RingHeader);
+
+// Size of the memory region for a ring holding `capacity` bytes of messages,
+// a power of two
+[[nodiscard]] constexpr std::size_t
+ring_memory_size(std::size_t capacity) noexcept {
+    return k_ring_data_offset + capacity;
+}
+
+// Set up an empty ring in `memory`, which must be aligned to 64 bytes. The
+// capacity is the largest power of two that fits. Throws std::runtime_error
+// if `memory` is too small for a ring.
+void initialize_ring(std::span<std::byte> memory);
+
+// Common state of both ends of a ring
+class RingEnd {
+  public:
+    [[nodiscard]] std::size_t capacity() const noexcept { return m_capacity; }
+
+    // Largest message the ring can hold. Capping records at half the ring
+    // guarantees that one always fits once the ring has drained, even after
+    // the padding needed to wrap around.
+    [[nodiscard]] std::size_t max_message_size() const noexcept {
+        return m_capacity / 2 - k_record_header_size;
+    }
+
+  protected:
+    static constexpr std::size_t k_record_header_size = sizeof(std::uint32_t);
+    static constexpr std::size_t k_record_alignment = 8;
+    static constexpr std::uint32_t k_wrap_marker = 0xffffffff;
+
+    // Attach to a ring set up by initialize_ring, possibly in another
+    // process. Throws std::runtime_error if `memory` holds no ring.
+    explicit RingEnd(std::span<std::byte> memory);
+
+    [[nodiscard]] static constexpr std::size_t
+    record_size(std::size_t message_size) noexcept {
+        return (k_record_header_size + message_size + k_record_alignment - 1) &
+               ~(k_record_alignment - 1);
+    }
+
+    RingHeader *m_header;
+    std::byte *m_data;
+    std::size_t m_capacity;
+};
+
+// The producing end. Only one thread may use it at a time.
+class RingProducer : public RingEnd {
+  public:
+    explicit RingProducer(std::span<std::byte> memory);
+
+    // Room for a message of up to `size` bytes, or std::nullopt if the ring
+    // is too full. Throws std::runtime_error if the message can never fit.
+    [[nodiscard]] std::optional<std::span<std::byte>>
+    try_reserve(std::size_t size) {
+        if (size > max_message_size()) {
+            throw std::runtime_error("Message too large for ring");
+        }
+        const auto record = record_size(size);
+        const auto index = static_cast<std::size_t>(m_head & (m_capacity - 1));
+        const auto contiguous = m_capacity - index;
+        const auto padding = contiguous < record ? contiguous : 0;
+
+        if (m_head + padding + record - m_cached_tail > m_capacity) {
+            m_cached_tail = m_header->tail.load(std::memory_order_acquire);
+            if (m_head + padding + record - m_cached_tail > m_capacity) {
+                return std::nullopt;
+            }
+        }
+        m_padding = padding;
+        const auto start = padding != 0 ? 0 : index;
+        if (padding != 0) {
+            std::memcpy(m_data + index, &k_wrap_marker, sizeof(k_wrap_marker));
+        }
+        m_reserved = start;
+        return std::span{m_data + start + k_record_header_size, size};
+    }
+
+    // Publish the message written into the last reservation, which may be
+    // shorter than reserved
+    void commit(std::size_t size) noexcept {
+        const auto header = static_cast<std::uint32_t>(size);
+        std::memcpy(m_data + m_reserved, &header, sizeof(header));
+        m_head += m_padding + record_size(size);
+        m_header->head.store(m_head, std::memory_order_release);
+    }
+
+  private:
+    std::uint64_t m_head;
+    // Last value of the tail read, refreshed only when the ring looks full
+    std::uint64_t m_cached_tail;
+    std::size_t m_padding{};
+    std::size_t m_reserved{};
+};
+
+// The consuming end. Only one thread may use it at a time.
+class RingConsumer : public RingEnd {
+  public:
+    explicit RingConsumer(std::span<std::byte> memory);
+
+    // The oldest message in the ring, or std::nullopt if it is empty. The
+    // message stays in the ring, and valid, until release(). Throws
+    // std::runtime_error if the ring is corrupt.
+    [[nodiscard]] std::optional<std::span<const std::byte>> try_peek() {
+        if (m_tail == m_cached_head) {
+            m_cached_head = m_header->head.load(std::memory_order_acquire);
+            if (m_tail == m_cached_head) {
+                return std::nullopt;
+            }
+        }
+        auto index = static_cast<std::size_t>(m_tail & (m_capacity - 1));
+        auto size = load_record_header(index);
+        m_padding = 0;
+        if (size == k_wrap_marker) {
+            m_padding = m_capacity - index;
+            index = 0;
+            size = load_record_header(index);
+        }
+        if (size > m_capacity - index - k_record_header_size) {
+            throw std::runtime_error("Corrupt ring record");
+        }
+        m_peeked = record_size(size);
+        return std::span<const std::byte>{m_data + index + k_record_header_size,
+                                          size};
+    }
+
+    // Drop the message returned by the last try_peek
+    void release() noexcept {
+        m_tail += m_padding + m_peeked;
+        m_padding = 0;
+        m_peeked = 0;
+        m_header->tail.store(m_tail, std::memory_order_release);
+    }
+
+  private:
+    [[nodiscard]] std::uint32_t
+    load_record_header(std::size_t index) const noexcept {
+        std::uint32_t size;
+        std::memcpy(&size, m_data + index, sizeof(size));
+        return size;
+    }
+
+    std::uint64_t m_tail;
+    // Last value of the head read, refreshed only when the ring looks empty
+    std::uint64_t m_cached_head;
+    std::size_t m_padding{};
+    std::size_t m_peeked{};
+};
+
+// Serialize `obj` directly into the ring. Returns false if the ring is too
+// full.
+template <typename T> bool try_write(RingProducer &ring, const T &obj) {
+    const auto present = presence(obj);
+    const auto size = serialized_size(obj, present);
+    auto slot = ring.try_reserve(size);
+    if (!slot.has_value()) {
+        return false;
+    }
+    serialize(obj, *slot, present);
+    ring.commit(size);
+    return true;
+}
+
+// Decode the oldest message of the ring into `obj` and release it. Returns
+// false if the ring is empty. View members of `obj` would point into the
+// released message, so T must not have any; use try_peek to decode views.
+template <typename T> bool try_read(RingConsumer &ring, T &obj) {
+    auto message = ring.try_peek();
+    if (!message.has_value()) {
+        return false;
+    }
+    obj = T{};
+    merge(*message, obj);
+    ring.release();
+    return true;
+}
+
+// POSIX shared memory object mapped into this process. The object itself
+// outlives the mapping until it is unlinked.
+class SharedMemory {
+  public:
+    // Create the object `name` ("/something"), which must not exist yet, and
+    // map `size` zeroed bytes of it. Throws std::system_error on failure.
+    static SharedMemory create(const std::string &name, std::size_t size);
+
+    // Map the existing object `name` in full
+    static SharedMemory open(const std::string &name);
+
+    // Remove the object name; existing mappings stay valid
+    static void unlink(const std::string &name) noexcept;
+
+    SharedMemory(SharedMemory &&other) noexcept;
+    SharedMemory &operator=(SharedMemory &&other) noexcept;
+    ~SharedMemory();
+
+    // Page aligned, hence suitable for initialize_ring
+    [[nodiscard]] std::span<std::byte> span() const noexcept {
+        return {m_data, m_size};
+    }
+
+  private:
+    SharedMemory(std::byte *data, std::size_t size) noexcept
+        : m_data(data), m_size(size) {}
+
+    std::byte *m_data{};
+    std::size_t m_size{};
+};
+
+} // namespace proto
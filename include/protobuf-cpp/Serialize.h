@@ -1,37 +1,252 @@
 #pragma once
 
+#include "BufferPool.h"
 #include "Encoding.h"
 #include "Field.h"
+#include "Fused.h"
+#include "Key.h"
+#include "Map.h"
 #include "Record.h"
 #include "Utils.h"
 #include "Varint.h"
+#include "WireType.h"
 
+#include <bit>
+#include <bitset>
+#include <concepts>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 
 namespace proto {
 
+// One bit per member of T, in the order of T::members. A set bit means the
+// member is serialized.
+template <typename T> using Presence = std::bitset<T::members::s_num_elems>;
+
+// Types may maintain their own presence bitmap (e.g. updated by setters), in
+// which case the encoder uses it instead of inspecting every member
+template <typename T>
+concept TracksPresence = requires(const T &obj) {
+    { obj.presence() } -> std::convertible_to<Presence<T>>;
+};
+
+// proto3 implicit presence: scalars equal to zero and empty byte sequences
+// are not serialized. std::optional members have explicit presence and are
+// serialized whenever they hold a value, even if that value is zero.
+template <typename M> constexpr bool is_default_value(const M &value) {
+    if constexpr (is_optional_v<M>) {
+        return !value.has_value();
+    } else if constexpr (std::is_floating_point_v<M>) {
+        // Compare the representation so that -0.0 is still serialized
+        using Bits = std::conditional_t<sizeof(M) == sizeof(std::uint32_t),
+                                        std::uint32_t, std::uint64_t>;
+        return std::bit_cast<Bits>(value) == 0;
+    } else if constexpr (std::is_arithmetic_v<M>) {
+        return value == M{};
+    } else if constexpr (std::ranges::sized_range<M>) {
+        return std::ranges::empty(value);
+    } else {
+        return false;
+    }
+}
+
+// A disengaged std::optional cannot be serialized even if its presence bit
+// is set
+template <typename M> constexpr bool has_value(const M &value) {
+    if constexpr (is_optional_v<M>) {
+        return value.has_value();
+    } else {
+        return true;
+    }
+}
+
+template <typename T> constexpr Presence<T> presence(const T &obj) {
+    if constexpr (TracksPresence<T>) {
+        return obj.presence();
+    } else {
+        Presence<T> present;
+        for_each_member<T>([&]<auto MemberPtr, std::size_t Index>() {
+            present[Index] = !is_default_value(obj.*MemberPtr);
+        });
+        return present;
+    }
+}
+
+// Text and byte sequence members encoded as Varlen
+template <auto MemberPtr>
+concept LenSequenceMember =
+    std::is_same_v<typename MemberEncoding<MemberPtr>::type, Varlen> &&
+    (TextSequence<optional_value_t<typename MemberPointerTraits<
+         decltype(MemberPtr)>::member_type>> ||
+     ByteSequence<optional_value_t<typename MemberPointerTraits<
+         decltype(MemberPtr)>::member_type>>);
+
 template <auto MemberPtr, typename T>
-void serialize_member_field(const T &obj, std::vector<std::byte> &buffer,
-                            Field &field_number) {
+constexpr auto make_member_record(const T &obj, Field field_number) {
     using EncodingType = typename MemberEncoding<MemberPtr>::type;
 
-    EncodingType encoded_obj{obj.*MemberPtr};
-    Record record{field_number, encoded_obj};
-    auto serialized = serialize(record);
-    buffer.insert(buffer.end(), serialized.begin(), serialized.end());
-    field_number = Field{std::to_underlying(field_number) + 1};
+    EncodingType encoded_obj{unwrap_optional(obj.*MemberPtr)};
+    return Record{field_number, encoded_obj};
 }
 
-template <typename T> std::vector<std::byte> serialize(const T &obj) {
-    std::vector<std::byte> buffer;
-    Field field_number{1};
+// Encoded size of one member, field keys included
+template <auto MemberPtr, typename T>
+constexpr std::size_t member_field_size(const T &obj, Field field_number) {
+    using M = optional_value_t<
+        typename MemberPointerTraits<decltype(MemberPtr)>::member_type>;
+
+    if constexpr (MapContainer<M>) {
+        return map_field_size<typename MemberEncoding<MemberPtr>::type>(
+            field_number, unwrap_optional(obj.*MemberPtr));
+    } else if constexpr (LenSequenceMember<MemberPtr>) {
+        // Sized directly rather than through a Record, which would copy the
+        // sequence into a temporary Varlen first
+        const auto size = std::ranges::size(unwrap_optional(obj.*MemberPtr));
+        return Varint{Key{field_number, WireType::LEN}.value()}.size() +
+               Varint{size}.size() + size;
+    } else {
+        return make_member_record<MemberPtr>(obj, field_number).size();
+    }
+}
+
+template <auto MemberPtr, typename T>
+constexpr std::size_t serialize_member_field(const T &obj,
+                                             std::span<std::byte> &buffer,
+                                             Field field_number) {
+    using M = optional_value_t<
+        typename MemberPointerTraits<decltype(MemberPtr)>::member_type>;
+    using EncodingType = typename MemberEncoding<MemberPtr>::type;
 
-    [&]<auto... MemberPtrs>(Members<MemberPtrs...>) {
-        (serialize_member_field<MemberPtrs>(obj, buffer, field_number), ...);
-    }(typename T::members{});
+    std::size_t num_bytes_written = 0;
+    if constexpr (MapContainer<M>) {
+        constexpr bool sort_by_key = DeterministicMap<MemberPtr>::value;
+        num_bytes_written = serialize_map_field<EncodingType, sort_by_key>(
+            field_number, unwrap_optional(obj.*MemberPtr), buffer);
+    } else if constexpr (std::is_same_v<EncodingType, Varint> &&
+                         std::is_integral_v<M>) {
+        // Encode in the width of the member rather than as a 64-bit Varint.
+        // Field numbers are below 2^29, so keys fit in 32 bits.
+        const auto key = static_cast<std::uint32_t>(
+            Key{field_number, WireType::VARINT}.value());
+        num_bytes_written = Varint::serialize_as(key, buffer);
+        num_bytes_written += Varint::serialize_as(
+            unwrap_optional(obj.*MemberPtr), buffer.subspan(num_bytes_written));
+    } else if constexpr (LenSequenceMember<MemberPtr>) {
+        // Length prefix and payload are written straight from the member
+        const auto &value = unwrap_optional(obj.*MemberPtr);
+        const auto bytes = std::as_bytes(
+            std::span{std::ranges::data(value), std::ranges::size(value)});
+        const auto key = static_cast<std::uint32_t>(
+            Key{field_number, WireType::LEN}.value());
+        num_bytes_written = Varint::serialize_as(key, buffer);
+        num_bytes_written +=
+            Varint{bytes.size()}.serialize(buffer.subspan(num_bytes_written));
+        if (buffer.size() - num_bytes_written < bytes.size()) {
+            throw std::runtime_error("Not enough space in provided span");
+        }
+        if (!bytes.empty()) {
+            std::memcpy(buffer.data() + num_bytes_written, bytes.data(),
+                        bytes.size());
+        }
+        num_bytes_written += bytes.size();
+    } else {
+        num_bytes_written =
+            make_member_record<MemberPtr>(obj, field_number).serialize(buffer);
+    }
+    buffer = buffer.subspan(num_bytes_written);
+    return num_bytes_written;
+}
+
+// Number of bytes `serialize(obj)` will produce when only the members set in
+// `present` are serialized
+template <typename T>
+constexpr std::size_t serialized_size(const T &obj,
+                                      const Presence<T> &present) {
+    std::size_t size = 0;
+    for_each_member<T>([&]<auto MemberPtr, std::size_t Index>() {
+        if (present[Index] && has_value(obj.*MemberPtr)) {
+            size += member_field_size<MemberPtr>(obj, Field{Index + 1});
+        }
+    });
+    return size;
+}
+
+template <typename T> constexpr std::size_t serialized_size(const T &obj) {
+    return serialized_size(obj, presence(obj));
+}
+
+// Write the members set in `present` into `buffer`, which must be large
+// enough, calling after_member(num_bytes_written) each time a member or a
+// fused run of members has been written
+template <typename T, typename F>
+constexpr std::size_t serialize_members(const T &obj,
+                                        std::span<std::byte> buffer,
+                                        const Presence<T> &present,
+                                        F &&after_member) {
+    std::size_t num_bytes_written = 0;
+    // Members already written as part of a fused run
+    std::size_t skip_until = 0;
+    for_each_member<T>([&]<auto MemberPtr, std::size_t Index>() {
+        if (Index < skip_until) {
+            return;
+        }
+        if constexpr (constexpr auto end = fused_run_end<T, Index>()) {
+            using Run = FusedRun<T, Index, end>;
+            if !consteval {
+                if (Run::all_present(present)) {
+                    Run::serialize(obj, buffer.data());
+                    buffer = buffer.subspan(Run::k_size);
+                    num_bytes_written += Run::k_size;
+                    skip_until = end;
+                    after_member(num_bytes_written);
+                    return;
+                }
+            }
+        }
+        if (present[Index] && has_value(obj.*MemberPtr)) {
+            num_bytes_written += serialize_member_field<MemberPtr>(
+                obj, buffer, Field{Index + 1});
+            after_member(num_bytes_written);
+        }
+    });
+    return num_bytes_written;
+}
+
+// Serialize the members set in `present` into a caller-provided buffer
+// without allocating
+template <typename T>
+constexpr std::size_t serialize(const T &obj, std::span<std::byte> buffer,
+                                const Presence<T> &present) {
+    if (buffer.size() < serialized_size(obj, present)) {
+        throw std::runtime_error("Buffer too small to serialize object");
+    }
+    return serialize_members(obj, buffer, present, [](std::size_t) {});
+}
+
+template <typename T>
+constexpr std::size_t serialize(const T &obj, std::span<std::byte> buffer) {
+    return serialize(obj, buffer, presence(obj));
+}
+
+template <typename T> std::vector<std::byte> serialize(const T &obj) {
+    const auto present = presence(obj);
+    std::vector<std::byte> buffer(serialized_size(obj, present));
+    serialize(obj, std::span<std::byte>{buffer}, present);
+    return buffer;
+}
 
+// Serialize into a buffer recycled from `pool`, typically
+// BufferPool::local(). The buffer returns to the pool when the handle dies.
+template <typename T> PooledBuffer serialize(const T &obj, BufferPool &pool) {
+    const auto present = presence(obj);
+    auto buffer = pool.acquire(serialized_size(obj, present));
+    serialize(obj, buffer.span(), present);
     return buffer;
 }
 
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "Deserialize.h"
+#include "Framing.h"
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+#include <version>
+
+#if defined(__cpp_lib_generator)
+#include <generator>
+#endif
+
+namespace proto {
+
+// Reads length-delimited frames (see Framing.h) from a file descriptor. A
+// background thread reads ahead into one of two chunk buffers while frames
+// are parsed out of the other. Frames are returned as views into the chunk;
+// frames that straddle chunks are assembled in a reused carry-over buffer, so
+// no allocation happens per frame once the buffers have grown.
+//
+// For checksummed frames, the read-ahead thread also verifies the checksums of
+// the frames that lie entirely within the chunk it has just read, overlapping
+// integrity checks with parsing; only frames that straddle chunks are
+// verified on the consuming thread.
+//
+// Frames larger than `max_frame_size` bytes, header included, are rejected
+// as soon as their length is read, bounding the memory a corrupt or hostile
+// length prefix can make the reader allocate.
+//
+// The file descriptor is not owned and must stay open for the reader's
+// lifetime.
+class FrameReader {
+  public:
+    static constexpr std::size_t k_default_chunk_size = 64 * 1024;
+    static constexpr std::size_t k_default_max_frame_size = 64 * 1024 * 1024;
+
+    explicit FrameReader(
+        int fd, std::size_t chunk_size = k_default_chunk_size,
+        FrameFormat format = FrameFormat::Delimited,
+        std::size_t max_frame_size = k_default_max_frame_size);
+
+    FrameReader(const FrameReader &) = delete;
+    FrameReader &operator=(const FrameReader &) = delete;
+    ~FrameReader();
+
+    // The payload of the next frame, valid until the next call, or
+    // std::nullopt at end of stream. Throws std::runtime_error on read
+    // errors, malformed frames, checksum mismatches and streams that end in
+    // a partial frame or in a frame larger than the maximum frame size,
+    // after which the reader must not be used any more.
+    [[nodiscard]] std::optional<std::span<const std::byte>> next();
+
+  private:
+    struct Chunk {
+        std::vector<std::byte> data;
+        std::size_t size{};
+        bool filled{};
+        bool eof{};
+        int error{};
+        // Frames within [verified_begin, verified_end) passed their checksum
+        std::size_t verified_begin{};
+        std::size_t verified_end{};
+    };
+
+    void read_ahead();
+    void verify_ahead(Chunk &chunk);
+    bool fetch_chunk();
+    [[nodiscard]] std::span<const std::byte> front_remaining() const noexcept;
+    void check_frame_size(std::uint64_t size) const;
+
+    int m_fd;
+    FrameFormat m_format;
+    std::size_t m_max_frame_size;
+    std::array<int, 2> m_wake_pipe{-1, -1};
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::array<Chunk, 2> m_chunks;
+    bool m_stop{};
+
+    // Consumer state
+    Chunk *m_front{};
+    std::size_t m_front_pos{};
+    std::size_t m_next_slot{};
+    std::vector<std::byte> m_carry;
+
+    // Read-ahead state: the bytes of a frame that straddles chunks still to
+    // come, and the start of its header if the header itself straddles
+    bool m_verify_ahead{};
+    std::uint64_t m_ahead_skip{};
+    std::array<std::byte, Varint::k_max_size> m_ahead_header{};
+    std::size_t m_ahead_header_size{};
+
+    std::thread m_thread;
+};
+
+// Input range over the messages in a stream of length-delimited frames,
+// decoding each frame into a single reused object:
+//
+//     for (const auto &msg : proto::read_messages<Foo>(fd)) { ... }
+template <typename T> class MessageReader {
+  public:
+    explicit MessageReader(
+        int fd, std::size_t chunk_size = FrameReader::k_default_chunk_size,
+        FrameFormat format = FrameFormat::Delimited,
+        std::size_t max_frame_size = FrameReader::k_default_max_frame_size)
+        : m_frames(fd, chunk_size, format, max_frame_size) {}
+
+    class iterator {
+      public:
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+        explicit iterator(MessageReader *reader) : m_reader(reader) {}
+
+        const T &operator*() const { return m_reader->m_message; }
+        const T *operator->() const { return &m_reader->m_message; }
+
+        iterator &operator++() {
+            if (!m_reader->advance()) {
+                m_reader = nullptr;
+            }
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+
+        friend bool operator==(const iterator &it, std::default_sentinel_t) {
+            return it.m_reader == nullptr;
+        }
+
+      private:
+        MessageReader *m_reader{};
+    };
+
+    iterator begin() {
+        iterator it{this};
+        return advance() ? it : iterator{};
+    }
+    std::default_sentinel_t end() const noexcept { return {}; }
+
+  private:
+    bool advance() {
+        auto frame = m_frames.next();
+        if (!frame.has_value()) {
+            return false;
+        }
+        m_message = T{};
+        merge(*frame, m_message);
+        return true;
+    }
+
+    FrameReader m_frames;
+    T m_message{};
+};
+
+template <typename T>
+MessageReader<T> read_messages(
+    int fd, std::size_t chunk_size = FrameReader::k_default_chunk_size,
+    FrameFormat format = FrameFormat::Delimited,
+    std::size_t max_frame_size = FrameReader::k_default_max_frame_size) {
+    return MessageReader<T>{fd, chunk_size, format, max_frame_size};
+}
+
+#if defined(__cpp_lib_generator)
+template <typename T>
+std::generator<const T &> generate_messages(
+    int fd, std::size_t chunk_size = FrameReader::k_default_chunk_size,
+    FrameFormat format = FrameFormat::Delimited,
+    std::size_t max_frame_size = FrameReader::k_default_max_frame_size) {
+    MessageReader<T> reader{fd, chunk_size, format, max_frame_size};
+    for (const auto &message : reader) {
+        co_yield message;
+    }
+}
+#endif
+
+} // namespace proto
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "Deserialized.h"
+#include "Encoding.h"
+#include "Field.h"
+#include "Fixint.h"
+#include "Key.h"
+#include "Utf8.h"
+#include "Varint.h"
+#include "Varlen.h"
+#include "WireType.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace proto {
+
+// One field as it appears on the wire, without interpreting the value
+struct WireField {
+    Key key{Field{}, WireType{}};
+    // The whole field, key included
+    std::span<const std::byte> bytes;
+    // The value: varint bytes, fixed-width bytes, or the LEN contents without
+    // the length prefix
+    std::span<const std::byte> payload;
+    // Decoded value of a VARINT field
+    std::uint64_t varint{};
+
+    [[nodiscard]] constexpr Field field_number() const noexcept {
+        return key.field_number();
+    }
+    [[nodiscard]] constexpr WireType wire_type() const noexcept {
+        return key.wire_type();
+    }
+};
+
+// Like Varint::deserialize, but fails (num_bytes_read == 0) unless the varint
+// terminates within the data and within Varint::k_max_size bytes
+[[nodiscard]] constexpr Deserialized<Varint>
+read_varint(std::span<const std::byte> data) noexcept {
+    constexpr std::byte continue_mask{0b1000'0000};
+
+    auto limited = data.first(std::min(data.size(), Varint::k_max_size));
+    auto deserialized = Varint::deserialize(limited);
+    if (deserialized.num_bytes_read == 0 ||
+        bool(limited[deserialized.num_bytes_read - 1] & continue_mask)) {
+        return Deserialized<Varint>{Varint{}, 0};
+    }
+    return deserialized;
+}
+
+// Read the next field off the wire. num_bytes_read is 0 if the data does not
+// start with a well-formed field.
+[[nodiscard]] constexpr Deserialized<WireField>
+read_field(std::span<const std::byte> data) noexcept {
+    constexpr Deserialized<WireField> error{WireField{}, 0};
+
+    auto deserialized_key = read_varint(data);
+    if (deserialized_key.num_bytes_read == 0) {
+        return error;
+    }
+    WireField field{Key{deserialized_key.value}, {}, {}, 0};
+    if (std::to_underlying(field.field_number()) == 0) {
+        return error;
+    }
+
+    auto remaining = data.subspan(deserialized_key.num_bytes_read);
+    std::size_t payload_offset = 0;
+    std::size_t payload_size = 0;
+
+    switch (field.wire_type()) {
+    case WireType::VARINT: {
+        auto deserialized_value = read_varint(remaining);
+        if (deserialized_value.num_bytes_read == 0) {
+            return error;
+        }
+        field.varint = deserialized_value.value.value();
+        payload_size = deserialized_value.num_bytes_read;
+        break;
+    }
+    case WireType::FIXED64:
+        payload_size = sizeof(std::uint64_t);
+        break;
+    case WireType::FIXED32:
+        payload_size = sizeof(std::uint32_t);
+        break;
+    case WireType::LEN: {
+        auto deserialized_length = read_varint(remaining);
+        if (deserialized_length.num_bytes_read == 0) {
+            return error;
+        }
+        payload_offset = deserialized_length.num_bytes_read;
+        const auto length = deserialized_length.value.value();
+        if (length > remaining.size() - payload_offset) {
+            return error;
+        }
+        payload_size = static_cast<std::size_t>(length);
+        break;
+    }
+    default:
+        return error;
+    }
+
+    if (payload_offset + payload_size > remaining.size()) {
+        return error;
+    }
+
+    const auto total_size =
+        deserialized_key.num_bytes_read + payload_offset + payload_size;
+    field.bytes = data.first(total_size);
+    field.payload = remaining.subspan(payload_offset, payload_size);
+    return Deserialized<WireField>{field, total_size};
+}
+
+// Interpret a field read off the wire as `Type` using `Encoding`. Integral
+// varints may be no longer than Type needs, and text types must hold valid
+// UTF-8 unless `ValidateText` is false; std::string_view and std::span
+// results reference the payload.
+template <typename Type, typename Encoding, bool ValidateText = true>
+constexpr Type decode_value(const WireField &field) {
+    if (field.wire_type() != Encoding::k_wire_type) {
+        throw std::runtime_error("Attempted to deserialize the wrong type!");
+    }
+
+    if constexpr (std::is_same_v<Encoding, Varint> &&
+                  std::is_integral_v<Type>) {
+        // Bounded by the width of Type, as deserialize decodes it
+        auto deserialized = Varint::deserialize_as<Type>(field.payload);
+        if (deserialized.num_bytes_read == 0) {
+            throw std::runtime_error("Varint is too long for the member type");
+        }
+        return deserialized.value;
+    } else if constexpr (std::is_same_v<Encoding, Varint>) {
+        return Varint{field.varint}.template as<Type>();
+    } else if constexpr (std::is_same_v<Encoding, Varlen>) {
+        if constexpr (TextSequence<Type>) {
+            if constexpr (ValidateText) {
+                if (!is_valid_utf8(field.payload)) {
+                    throw std::runtime_error(
+                        "String field is not valid UTF-8");
+                }
+            }
+            return Type(reinterpret_cast<const char *>(field.payload.data()),
+                        field.payload.size());
+        } else if constexpr (std::is_constructible_v<Type,
+                                              std::span<const std::byte>>) {
+            return Type(field.payload);
+        } else {
+            return Type(field.payload.begin(), field.payload.end());
+        }
+    } else {
+        return Encoding::deserialize(field.payload).value.template as<Type>();
+    }
+}
+
+} // namespace proto
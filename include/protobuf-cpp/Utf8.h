@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+
+namespace proto {
+
+// True if `data` is well-formed UTF-8: no overlong encodings, surrogates,
+// code points above U+10FFFF or truncated sequences. Uses AVX2 when the CPU
+// supports it and otherwise skips ASCII runs 16 bytes at a time before
+// validating the rest one sequence at a time.
+[[nodiscard]] bool is_valid_utf8(std::span<const std::byte> data) noexcept;
+
+// Byte-at-a-time reference implementation of is_valid_utf8
+[[nodiscard]] bool
+is_valid_utf8_scalar(std::span<const std::byte> data) noexcept;
+
+// Length of the longest well-formed UTF-8 prefix of `data`, which is
+// data.size() if all of it is valid
+[[nodiscard]] std::size_t
+valid_utf8_prefix_length(std::span<const std::byte> data) noexcept;
+
+} // namespace proto
@@ -0,0 +1,294 @@
+#pragma once
+
+#include "Encoding.h"
+#include "Field.h"
+#include "Key.h"
+#include "Map.h"
+#include "Utf8.h"
+#include "Varint.h"
+#include "WireType.h"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+namespace proto {
+
+// Structural validation of untrusted messages, cheap enough to run on every
+// message at ingress. A message that passes validate<T> decodes into T
+// without throwing. Validation never allocates nor throws.
+
+enum class ValidationError : std::uint8_t {
+    None,
+    // A varint does not end within the message or within 10 bytes
+    MalformedVarint,
+    // Field number 0, or a wire type other than VARINT, I64, LEN and I32
+    InvalidKey,
+    // A fixed-width or LEN value runs past the end of its message
+    Truncated,
+    // A known field whose wire type differs from its member's encoding
+    WireTypeMismatch,
+    // A varint longer than the integer type of its member allows
+    VarintTooLong,
+    // A text member that is not valid UTF-8
+    InvalidUtf8,
+};
+
+struct Validation {
+    ValidationError error;
+    // Offset of the offending field, or the size of the message if it is
+    // valid
+    std::size_t offset;
+
+    [[nodiscard]] constexpr explicit operator bool() const noexcept {
+        return error == ValidationError::None;
+    }
+};
+
+// Bit i of the result is set if data[i] ends a varint, i.e. has its
+// continuation bit clear. `data` must hold 64 bytes.
+[[nodiscard]] std::uint64_t varint_end_mask(const std::byte *data) noexcept;
+
+// Finds varint boundaries in a message from the continuation bits of 64
+// bytes at a time, rather than testing the bytes of each varint one by one.
+// The mask of the block being read is kept, so all the keys and values in a
+// block cost one scan.
+class VarintBoundaries {
+  public:
+    explicit VarintBoundaries(std::span<const std::byte> data) noexcept
+        : m_data(data) {}
+
+    [[nodiscard]] std::span<const std::byte> data() const noexcept {
+        return m_data;
+    }
+
+    // Size of the varint at `offset`, or 0 if it runs past the data or past
+    // Varint::k_max_size bytes
+    [[nodiscard]] std::size_t varint_size(std::size_t offset) noexcept {
+        const auto end = varint_end(offset);
+        return end < m_data.size() && end - offset < Varint::k_max_size
+                   ? end - offset + 1
+                   : 0;
+    }
+
+    // Value of the varint of `size` bytes at `offset`
+    [[nodiscard]] std::uint64_t value(std::size_t offset,
+                                      std::size_t size) const noexcept {
+        std::uint64_t value = 0;
+        for (std::size_t i = 0; i < size; i++) {
+            value |= (std::to_integer<std::uint64_t>(m_data[offset + i]) & 0x7f)
+                     << (7 * i);
+        }
+        return value;
+    }
+
+  private:
+    static constexpr std::size_t k_block_size = 64;
+
+    // Offset of the first byte at or after `offset` that ends a varint,
+    // looking at most into the next block, or the size of the data
+    [[nodiscard]] std::size_t varint_end(std::size_t offset) noexcept {
+        auto block = offset & ~(k_block_size - 1);
+        auto mask = block_mask(block) >> (offset - block);
+        if (mask != 0) {
+            return offset + static_cast<std::size_t>(std::countr_zero(mask));
+        }
+        // A varint is shorter than a block, so it ends in the next one
+        block += k_block_size;
+        if (block >= m_data.size()) {
+            return m_data.size();
+        }
+        mask = block_mask(block);
+        return mask != 0
+                   ? block + static_cast<std::size_t>(std::countr_zero(mask))
+                   : m_data.size();
+    }
+
+    [[nodiscard]] std::uint64_t block_mask(std::size_t block) noexcept {
+        if (block != m_block) {
+            m_block = block;
+            if (m_data.size() - block >= k_block_size) {
+                m_mask = varint_end_mask(m_data.data() + block);
+            } else {
+                m_mask = 0;
+                for (auto i = block; i < m_data.size(); i++) {
+                    if ((m_data[i] & std::byte{0x80}) == std::byte{0}) {
+                        m_mask |= std::uint64_t{1} << (i - block);
+                    }
+                }
+            }
+        }
+        return m_mask;
+    }
+
+    std::span<const std::byte> m_data;
+    std::size_t m_block{std::numeric_limits<std::size_t>::max()};
+    std::uint64_t m_mask{};
+};
+
+// A field located by validate_fields. Offsets are into the data of the
+// VarintBoundaries.
+struct ValidatedField {
+    Key key{Field{}, WireType{}};
+    // Offset of the field key
+    std::size_t offset;
+    // Offset and size of the value, without the length prefix of LEN fields
+    std::size_t value_offset;
+    std::size_t value_size;
+};
+
+// Check that [begin, end) of the data of `boundaries` is a sequence of
+// well-formed fields, passing each to check_field, which returns a
+// Validation for the field
+template <typename F>
+Validation validate_fields(VarintBoundaries &boundaries, std::size_t begin,
+                           std::size_t end, F &&check_field) noexcept {
+    auto offset = begin;
+    while (offset < end) {
+        const auto key_size = boundaries.varint_size(offset);
+        if (key_size == 0 || key_size > end - offset) {
+            return {ValidationError::MalformedVarint, offset};
+        }
+        ValidatedField field{Key{Varint{boundaries.value(offset, key_size)}},
+                             offset, offset + key_size, 0};
+        if (std::to_underlying(field.key.field_number()) == 0) {
+            return {ValidationError::InvalidKey, offset};
+        }
+
+        const auto available = end - field.value_offset;
+        switch (field.key.wire_type()) {
+        case WireType::VARINT:
+            field.value_size = boundaries.varint_size(field.value_offset);
+            if (field.value_size == 0 || field.value_size > available) {
+                return {ValidationError::MalformedVarint, offset};
+            }
+            break;
+        case WireType::FIXED64:
+        case WireType::FIXED32:
+            field.value_size = field.key.wire_type() == WireType::FIXED64
+                                   ? sizeof(std::uint64_t)
+                                   : sizeof(std::uint32_t);
+            if (field.value_size > available) {
+                return {ValidationError::Truncated, offset};
+            }
+            break;
+        case WireType::LEN: {
+            const auto length_size = boundaries.varint_size(field.value_offset);
+            if (length_size == 0 || length_size > available) {
+                return {ValidationError::MalformedVarint, offset};
+            }
+            const auto length =
+                boundaries.value(field.value_offset, length_size);
+            field.value_offset += length_size;
+            if (length > available - length_size) {
+                return {ValidationError::Truncated, offset};
+            }
+            field.value_size = static_cast<std::size_t>(length);
+            break;
+        }
+        default:
+            return {ValidationError::InvalidKey, offset};
+        }
+
+        if (auto checked = check_field(field); !checked) {
+            return checked;
+        }
+        offset = field.value_offset + field.value_size;
+    }
+    return {ValidationError::None, end};
+}
+
+// Check a field against the encoding of the value type V it decodes into
+template <typename Encoding, typename V>
+ValidationError validate_value(const VarintBoundaries &boundaries,
+                               const ValidatedField &field,
+                               bool validate_utf8) noexcept {
+    if (field.key.wire_type() != Encoding::k_wire_type) {
+        return ValidationError::WireTypeMismatch;
+    }
+    if constexpr (std::is_integral_v<V> && std::is_same_v<Encoding, Varint>) {
+        if (field.value_size > Varint::k_max_size_of<V>) {
+            return ValidationError::VarintTooLong;
+        }
+    } else if constexpr (TextSequence<V>) {
+        if (validate_utf8 &&
+            !is_valid_utf8(boundaries.data().subspan(field.value_offset,
+                                                     field.value_size))) {
+            return ValidationError::InvalidUtf8;
+        }
+    }
+    return ValidationError::None;
+}
+
+// Map entries are nested messages holding the key as field 1 and the value
+// as field 2. Text keys and values are checked for UTF-8 if `ValidateText`.
+template <typename Encoding, MapContainer M, bool ValidateText>
+Validation validate_map_entry(VarintBoundaries &boundaries,
+                              const ValidatedField &entry) noexcept {
+    return validate_fields(
+        boundaries, entry.value_offset, entry.value_offset + entry.value_size,
+        [&](const ValidatedField &field) -> Validation {
+            auto error = ValidationError::None;
+            if (field.key.field_number() == k_map_key_field) {
+                error = validate_value<typename Encoding::key_encoding,
+                                       typename M::key_type>(
+                    boundaries, field, ValidateText);
+            } else if (field.key.field_number() == k_map_value_field) {
+                error = validate_value<typename Encoding::mapped_encoding,
+                                       typename M::mapped_type>(
+                    boundaries, field, ValidateText);
+            }
+            return {error, field.offset};
+        });
+}
+
+// Check one field of a message of type T. Unknown fields are only checked
+// for structure, as decoding skips them.
+template <typename T>
+Validation validate_member_field(VarintBoundaries &boundaries,
+                                 const ValidatedField &field) noexcept {
+    Validation result{ValidationError::None, field.offset};
+    const auto field_number = std::to_underlying(field.key.field_number());
+    for_each_member<T>([&]<auto MemberPtr, std::size_t Index>() {
+        if (field_number != Index + 1) {
+            return;
+        }
+        using M = optional_value_t<
+            typename MemberPointerTraits<decltype(MemberPtr)>::member_type>;
+        using Encoding = typename MemberEncoding<MemberPtr>::type;
+        if constexpr (MapContainer<M>) {
+            if (field.key.wire_type() != WireType::LEN) {
+                result.error = ValidationError::WireTypeMismatch;
+            } else {
+                result = validate_map_entry<Encoding, M,
+                                            ValidateUtf8<MemberPtr>::value>(
+                    boundaries, field);
+            }
+        } else {
+            result.error = validate_value<Encoding, M>(
+                boundaries, field, ValidateUtf8<MemberPtr>::value);
+        }
+    });
+    return result;
+}
+
+// Check that `data` is a well-formed message of type T: every varint ends
+// within 10 bytes, every value stays within its message, known fields have
+// the wire type of their member's encoding and fit its type, text members
+// hold UTF-8 unless exempted by ValidateUtf8, and map entries are
+// well-formed nested messages
+template <typename T>
+[[nodiscard]] Validation validate(std::span<const std::byte> data) noexcept {
+    VarintBoundaries boundaries{data};
+    return validate_fields(boundaries, 0, data.size(),
+                           [&](const ValidatedField &field) {
+                               return validate_member_field<T>(boundaries,
+                                                               field);
+                           });
+}
+
+} // namespace proto
@@ -9,6 +9,7 @@
 #include <cstdint>
 #include <span>
 #include <stdexcept>
+#include <type_traits>
 #include <vector>
 
 namespace proto {
@@ -16,16 +17,55 @@ namespace proto {
 class Varint {
   public:
     static constexpr WireType k_wire_type = WireType::VARINT;
+    // Maximum encoded size of a 64-bit value
+    static constexpr std::size_t k_max_size = 10;
+
+    // Maximum encoded size of a T: 2, 3, 5 or 10 bytes for 8, 16, 32 and 64
+    // bit types
+    template <typename T>
+    static constexpr std::size_t k_max_size_of = (sizeof(T) * 8 + 6) / 7;
+
+    // Unsigned integer holding the bits put on the wire for a T
+    template <typename T>
+    using bits_type = std::conditional_t<sizeof(T) <= sizeof(std::uint32_t),
+                                         std::uint32_t, std::uint64_t>;
 
     constexpr Varint() = default;
 
     template <typename T>
         requires std::is_integral_v<T>
-    constexpr explicit Varint(T value) noexcept
-        : m_value(std::is_signed_v<T>
-                      // Zigzag encode
-                      ? (value << 1) ^ (value >> ((sizeof(T) * 8) - 1))
-                      : value) {}
+    constexpr explicit Varint(T value) noexcept : m_value(to_bits(value)) {}
+
+    // Bits put on the wire for `value`. Signed integers are zigzag encoded
+    // within their own width, so that e.g. INT32_MIN takes 5 bytes, not 10.
+    template <typename T>
+        requires std::is_integral_v<T>
+    [[nodiscard]] static constexpr bits_type<T> to_bits(T value) noexcept {
+        if constexpr (std::is_same_v<T, bool>) {
+            return value ? 1 : 0;
+        } else if constexpr (std::is_signed_v<T>) {
+            using Unsigned = std::make_unsigned_t<T>;
+            constexpr auto sign_shift = sizeof(T) * 8 - 1;
+            return static_cast<Unsigned>(static_cast<Unsigned>(value) << 1) ^
+                   static_cast<Unsigned>(value >> sign_shift);
+        } else {
+            return value;
+        }
+    }
+
+    // Inverse of to_bits. Bits beyond the width of T are dropped, as in as().
+    template <typename T>
+        requires std::is_integral_v<T>
+    [[nodiscard]] static constexpr T from_bits(bits_type<T> bits) noexcept {
+        if constexpr (std::is_same_v<T, bool>) {
+            return bits != 0;
+        } else if constexpr (std::is_signed_v<T>) {
+            // Zigzag decode
+            return static_cast<T>((bits >> 1) ^ (~(bits & 1) + 1));
+        } else {
+            return static_cast<T>(bits);
+        }
+    }
 
     template <typename T>
         requires std::is_integral_v<T>
@@ -58,6 +98,51 @@ class Varint {
         return Deserialized{Varint{result}, num_bytes_read};
     }
 
+    // Decode a varint straight into a T. Only the first k_max_size_of<T>
+    // bytes are examined, in the integer width of T, so the loop has a
+    // compile-time bound and unrolls. num_bytes_read is 0 if the data ends
+    // early or the encoding is longer than any T needs.
+    template <typename T>
+        requires std::is_integral_v<T>
+    [[nodiscard]] constexpr static Deserialized<T>
+    deserialize_as(std::span<const std::byte> data) noexcept {
+        using Bits = bits_type<T>;
+        Bits bits = 0;
+        for (std::size_t i = 0; i < k_max_size_of<T>; i++) {
+            if (i == data.size()) {
+                break;
+            }
+            const auto byte = std::to_integer<Bits>(data[i]);
+            bits |= static_cast<Bits>(byte & 0x7f) << (7 * i);
+            if ((byte & 0x80) == 0) {
+                return Deserialized<T>{from_bits<T>(bits), i + 1};
+            }
+        }
+        return Deserialized<T>{T{}, 0};
+    }
+
+    // Encode `value` without going through a 64-bit Varint
+    template <typename T>
+        requires std::is_integral_v<T>
+    static constexpr std::size_t serialize_as(T value,
+                                              std::span<std::byte> buffer) {
+        auto bits = to_bits(value);
+        if (buffer.size() < Varint{bits}.size()) {
+            throw std::runtime_error("Not enough space in provided span");
+        }
+
+        for (std::size_t i = 0; i < k_max_size_of<T>; i++) {
+            const auto byte = static_cast<std::byte>(bits & 0x7f);
+            bits >>= 7;
+            if (bits == 0) {
+                buffer[i] = byte;
+                return i + 1;
+            }
+            buffer[i] = byte | std::byte{0x80};
+        }
+        return k_max_size_of<T>;
+    }
+
     [[nodiscard]] constexpr std::uint64_t value() const noexcept {
         return m_value;
     }
@@ -3,10 +3,12 @@
 #include "WireType.h"
 #include "protobuf-cpp/Varint.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <ranges>
 #include <span>
 #include <stdexcept>
+#include <string_view>
 #include <type_traits>
 #include <vector>
 
@@ -28,22 +30,28 @@ class Varlen {
     constexpr explicit Varlen(std::span<T> value) noexcept
         : m_value(value.begin(), value.end()) {}
 
+    constexpr explicit Varlen(std::string_view value) : m_value(value.size()) {
+        std::ranges::transform(value, m_value.begin(), [](char c) {
+            return static_cast<std::byte>(c);
+        });
+    }
+
     [[nodiscard]] constexpr static Deserialized<Varlen>
     deserialize(std::span<const std::byte> data) {
         const auto deserialized_length = Varint::deserialize(data);
         const auto length = deserialized_length.value.value();
 
         auto remaining_data =
-            data | std::views::drop(deserialized_length.num_bytes_read);
+            data.subspan(deserialized_length.num_bytes_read);
 
-        if (remaining_data.size() < length) {
+        if (deserialized_length.num_bytes_read == 0 ||
+            remaining_data.size() < length) {
             // Not enough data
             return Deserialized<Varlen>{Varlen{std::vector<std::byte>{}}, 0};
         }
 
-        return Deserialized(Varlen{remaining_data},
-                            deserialized_length.num_bytes_read +
-                                remaining_data.size());
+        return Deserialized(Varlen{remaining_data.first(length)},
+                            deserialized_length.num_bytes_read + length);
     }
 
     constexpr std::size_t serialize(std::span<std::byte> buffer) const {
@@ -61,6 +69,21 @@ class Varlen {
                std::distance(remaining_buffer.begin(), end_iter);
     }
 
+    // Copy the value into an owning container. Views are rejected since they
+    // would dangle once the Varlen is gone.
+    template <typename T>
+        requires(!std::ranges::view<T> &&
+                 std::is_constructible_v<T, const std::byte *,
+                                         const std::byte *>)
+    [[nodiscard]] constexpr T as() const {
+        if constexpr (std::is_same_v<std::ranges::range_value_t<T>, char>) {
+            return T(reinterpret_cast<const char *>(m_value.data()),
+                     m_value.size());
+        } else {
+            return T(m_value.data(), m_value.data() + m_value.size());
+        }
+    }
+
     [[nodiscard]] constexpr std::span<const std::byte> value() const noexcept {
         return m_value;
     }
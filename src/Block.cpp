@@ -0,0 +1,372 @@
+#include <protobuf-cpp/Block.h>
+#include <protobuf-cpp/Crc32c.h>
+#include <protobuf-cpp/Deserialize.h>
+#include <protobuf-cpp/Fixint.h>
+#include <protobuf-cpp/Framing.h>
+#include <protobuf-cpp/Serialize.h>
+#include <protobuf-cpp/Validate.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <unistd.h>
+
+#if defined(PROTO_HAVE_LZ4)
+#include <lz4.h>
+#endif
+#if defined(PROTO_HAVE_ZSTD)
+#include <zstd.h>
+#endif
+
+namespace proto {
+
+namespace {
+
+#if defined(PROTO_HAVE_ZSTD)
+// Favours speed: archives are written once but must keep up with producers
+constexpr int k_zstd_level = 3;
+#endif
+
+struct BlockHeader {
+    BlockCodec codec;
+    std::uint32_t uncompressed_size;
+    std::uint32_t compressed_size;
+    std::uint32_t checksum;
+};
+
+BlockHeader read_block_header(std::span<const std::byte> data) {
+    if (data.size() < k_block_header_size) {
+        throw std::runtime_error("Error parsing block header");
+    }
+    BlockHeader header{};
+    header.codec = static_cast<BlockCodec>(data[0]);
+    header.uncompressed_size =
+        Fixint32::deserialize(data.subspan(1)).value.value();
+    header.compressed_size =
+        Fixint32::deserialize(data.subspan(5)).value.value();
+    header.checksum = Fixint32::deserialize(data.subspan(9)).value.value();
+    if (data.size() - k_block_header_size < header.compressed_size) {
+        throw std::runtime_error("Block exceeds data");
+    }
+    // Checked before anything is allocated for the uncompressed data
+    if (header.uncompressed_size > k_max_block_size ||
+        (header.codec == BlockCodec::Stored &&
+         header.compressed_size != header.uncompressed_size)) {
+        throw std::runtime_error("Invalid block size");
+    }
+    return header;
+}
+
+void write_block_header(const BlockHeader &header, std::span<std::byte> out) {
+    out[0] = static_cast<std::byte>(header.codec);
+    Fixint32{header.uncompressed_size}.serialize(out.subspan(1));
+    Fixint32{header.compressed_size}.serialize(out.subspan(5));
+    Fixint32{header.checksum}.serialize(out.subspan(9));
+}
+
+// Upper bound of the compressed size of `size` bytes, and never less than
+// `size` so that the block can still be stored instead
+std::size_t compress_bound(BlockCodec codec, std::size_t size) {
+    switch (codec) {
+#if defined(PROTO_HAVE_LZ4)
+    case BlockCodec::Lz4:
+        if (size > LZ4_MAX_INPUT_SIZE) {
+            return size;
+        }
+        return std::max(size, static_cast<std::size_t>(LZ4_compressBound(
+                                  static_cast<int>(size))));
+#endif
+#if defined(PROTO_HAVE_ZSTD)
+    case BlockCodec::Zstd:
+        return ZSTD_compressBound(size);
+#endif
+    default:
+        return size;
+    }
+}
+
+// Compress `data` into `out`, which holds compress_bound bytes. Returns the
+// compressed size, or 0 if compression failed.
+std::size_t compress(BlockCodec codec,
+                     [[maybe_unused]] std::span<const std::byte> data,
+                     [[maybe_unused]] std::span<std::byte> out) {
+    switch (codec) {
+#if defined(PROTO_HAVE_LZ4)
+    case BlockCodec::Lz4: {
+        if (data.size() > LZ4_MAX_INPUT_SIZE) {
+            return 0;
+        }
+        const auto size = LZ4_compress_default(
+            reinterpret_cast<const char *>(data.data()),
+            reinterpret_cast<char *>(out.data()), static_cast<int>(data.size()),
+            static_cast<int>(out.size()));
+        return size > 0 ? static_cast<std::size_t>(size) : 0;
+    }
+#endif
+#if defined(PROTO_HAVE_ZSTD)
+    case BlockCodec::Zstd: {
+        const auto size = ZSTD_compress(out.data(), out.size(), data.data(),
+                                        data.size(), k_zstd_level);
+        return ZSTD_isError(size) != 0 ? 0 : size;
+    }
+#endif
+    default:
+        return 0;
+    }
+}
+
+// Decompress `data` into `out`, which holds exactly the uncompressed size.
+// Returns false if the data is corrupt.
+bool decompress(BlockCodec codec, std::span<const std::byte> data,
+                std::span<std::byte> out) {
+    switch (codec) {
+    case BlockCodec::Stored:
+        if (data.size() != out.size()) {
+            return false;
+        }
+        if (!data.empty()) {
+            std::memcpy(out.data(), data.data(), data.size());
+        }
+        return true;
+#if defined(PROTO_HAVE_LZ4)
+    case BlockCodec::Lz4: {
+        const auto size = LZ4_decompress_safe(
+            reinterpret_cast<const char *>(data.data()),
+            reinterpret_cast<char *>(out.data()), static_cast<int>(data.size()),
+            static_cast<int>(out.size()));
+        return size >= 0 && static_cast<std::size_t>(size) == out.size();
+    }
+#endif
+#if defined(PROTO_HAVE_ZSTD)
+    case BlockCodec::Zstd: {
+        const auto size =
+            ZSTD_decompress(out.data(), out.size(), data.data(), data.size());
+        return ZSTD_isError(size) == 0 && size == out.size();
+    }
+#endif
+    default:
+        throw std::runtime_error("Block codec not available");
+    }
+}
+
+void write_all(int fd, std::span<const std::byte> data) {
+    while (!data.empty()) {
+        const auto n = ::write(fd, data.data(), data.size());
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(),
+                                    "Error writing block file");
+        }
+        data = data.subspan(static_cast<std::size_t>(n));
+    }
+}
+
+} // namespace
+
+bool is_available(BlockCodec codec) noexcept {
+    switch (codec) {
+    case BlockCodec::Stored:
+        return true;
+    case BlockCodec::Lz4:
+#if defined(PROTO_HAVE_LZ4)
+        return true;
+#else
+        return false;
+#endif
+    case BlockCodec::Zstd:
+#if defined(PROTO_HAVE_ZSTD)
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+BlockCodec default_block_codec() noexcept {
+    for (auto codec : {BlockCodec::Zstd, BlockCodec::Lz4}) {
+        if (is_available(codec)) {
+            return codec;
+        }
+    }
+    return BlockCodec::Stored;
+}
+
+void append_block(std::span<const std::byte> data, BlockCodec codec,
+                  std::vector<std::byte> &out) {
+    if (!is_available(codec)) {
+        throw std::logic_error("Block codec not available");
+    }
+    if (data.size() > k_max_block_size) {
+        throw std::runtime_error("Block too large");
+    }
+
+    const auto offset = out.size();
+    out.resize(offset + k_block_header_size +
+               compress_bound(codec, data.size()));
+    auto payload = std::span{out}.subspan(offset + k_block_header_size);
+
+    auto compressed_size = codec == BlockCodec::Stored
+                               ? std::size_t{0}
+                               : compress(codec, data, payload);
+    // Incompressible data is stored rather than made larger
+    if (compressed_size == 0 || compressed_size >= data.size()) {
+        codec = BlockCodec::Stored;
+        compressed_size = data.size();
+        if (!data.empty()) {
+            std::memcpy(payload.data(), data.data(), data.size());
+        }
+    }
+    payload = payload.first(compressed_size);
+
+    write_block_header(
+        BlockHeader{codec, static_cast<std::uint32_t>(data.size()),
+                    static_cast<std::uint32_t>(compressed_size),
+                    crc32c(payload)},
+        std::span{out}.subspan(offset, k_block_header_size));
+    out.resize(offset + k_block_header_size + compressed_size);
+}
+
+std::size_t block_size(std::span<const std::byte> data) {
+    return k_block_header_size + read_block_header(data).compressed_size;
+}
+
+std::span<const std::byte> decompress_block(std::span<const std::byte> block,
+                                            std::vector<std::byte> &out) {
+    const auto header = read_block_header(block);
+    const auto payload =
+        block.subspan(k_block_header_size, header.compressed_size);
+    if (crc32c(payload) != header.checksum) {
+        throw std::runtime_error("Block checksum mismatch");
+    }
+    out.resize(header.uncompressed_size);
+    if (!decompress(header.codec, payload, out)) {
+        throw std::runtime_error("Error decompressing block");
+    }
+    return out;
+}
+
+BlockWriter::BlockWriter(int fd, BlockCodec codec, std::size_t block_size)
+    : m_fd(fd), m_codec(codec), m_block_size(std::max<std::size_t>(
+                                    block_size, 1)) {
+    if (!is_available(codec)) {
+        throw std::logic_error("Block codec not available");
+    }
+    if (block_size > k_max_block_size) {
+        throw std::logic_error("Block size too large");
+    }
+}
+
+void BlockWriter::flush_block() {
+    if (m_num_frames == 0) {
+        return;
+    }
+    m_block.clear();
+    append_block(m_frames, m_codec, m_block);
+    write_all(m_fd, m_block);
+
+    m_index.push_back(
+        BlockInfo{m_offset, m_block.size(), m_num_messages, m_num_frames});
+    m_offset += m_block.size();
+    m_num_messages += m_num_frames;
+    m_frames.clear();
+    m_num_frames = 0;
+}
+
+void BlockWriter::finish() {
+    flush_block();
+
+    std::vector<std::byte> index;
+    for (const auto &info : m_index) {
+        serialize_delimited(info, index);
+    }
+    const auto index_size = index.size();
+    index.resize(index_size + k_block_trailer_size);
+    auto trailer = std::span{index}.subspan(index_size);
+    Fixint64{m_offset}.serialize(trailer);
+    Fixint32{k_block_file_magic}.serialize(trailer.subspan(8));
+    write_all(m_fd, index);
+}
+
+BlockFile::BlockFile(std::span<const std::byte> file) : m_file(file) {
+    if (file.size() < k_block_trailer_size) {
+        throw std::runtime_error("Block file too small");
+    }
+    const auto trailer = file.last(k_block_trailer_size);
+    if (Fixint32::deserialize(trailer.subspan(8)).value.value() !=
+        k_block_file_magic) {
+        throw std::runtime_error("Not a block file");
+    }
+    const auto index_offset = Fixint64::deserialize(trailer).value.value();
+    const auto index_end = file.size() - k_block_trailer_size;
+    if (index_offset > index_end) {
+        throw std::runtime_error("Block index exceeds file");
+    }
+
+    // Blocks must tile the file up to the index and number the messages
+    // consecutively, so that decoders can trust the index
+    std::uint64_t offset = 0;
+    std::uint64_t first_message = 0;
+    for (auto frame : split_frames(file.subspan(
+             static_cast<std::size_t>(index_offset),
+             index_end - static_cast<std::size_t>(index_offset)))) {
+        // deserialize reports some malformed fields as std::logic_error
+        if (!validate<BlockInfo>(frame)) {
+            throw std::runtime_error("Malformed block index");
+        }
+        const auto info = deserialize<BlockInfo>(frame);
+        if (info.offset != offset || info.size > index_offset - offset ||
+            info.first_message != first_message) {
+            throw std::runtime_error("Malformed block index");
+        }
+        // Every frame takes at least one byte, which bounds the messages
+        // decoders allocate up front
+        const auto header = read_block_header(
+            file.subspan(static_cast<std::size_t>(info.offset),
+                         static_cast<std::size_t>(info.size)));
+        if (info.num_messages > header.uncompressed_size) {
+            throw std::runtime_error("Malformed block index");
+        }
+        offset += info.size;
+        first_message += info.num_messages;
+        m_index.push_back(info);
+    }
+    if (offset != index_offset) {
+        throw std::runtime_error("Malformed block index");
+    }
+}
+
+std::uint64_t BlockFile::num_messages() const noexcept {
+    return m_index.empty()
+               ? 0
+               : m_index.back().first_message + m_index.back().num_messages;
+}
+
+std::size_t BlockFile::find_block(std::uint64_t message) const {
+    if (message >= num_messages()) {
+        throw std::out_of_range("Message number out of range");
+    }
+    const auto it = std::ranges::upper_bound(m_index, message, {},
+                                             &BlockInfo::first_message);
+    return static_cast<std::size_t>(it - m_index.begin()) - 1;
+}
+
+std::span<const std::byte>
+BlockFile::read_block(std::size_t index, std::vector<std::byte> &out) const {
+    const auto &info = block(index);
+    const auto block = m_file.subspan(static_cast<std::size_t>(info.offset),
+                                      static_cast<std::size_t>(info.size));
+    if (block_size(block) != block.size()) {
+        throw std::runtime_error("Block size does not match index");
+    }
+    return decompress_block(block, out);
+}
+
+} // namespace proto
@@ -0,0 +1,171 @@
+#include <protobuf-cpp/BufferPool.h>
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <new>
+
+namespace proto {
+
+struct BufferPool::Block {
+    Block *next{};
+    Cache *owner{}; // nullptr for oversized blocks that are never cached
+    std::size_t size_class{};
+    std::size_t capacity{};
+
+    [[nodiscard]] std::byte *data() noexcept {
+        return reinterpret_cast<std::byte *>(this + 1);
+    }
+};
+
+struct BufferPool::Cache {
+    std::array<Block *, k_num_size_classes> free_lists{};
+    std::array<std::size_t, k_num_size_classes> free_counts{};
+    // Blocks released by other threads, pushed lock-free and drained by the
+    // owning thread with a single exchange
+    std::atomic<Block *> remote_free{nullptr};
+    // One reference for the owning thread plus one per outstanding buffer, so
+    // a buffer may outlive the thread that acquired it
+    std::atomic<std::size_t> refs{1};
+};
+
+namespace {
+
+thread_local BufferPool::Cache *t_cache = nullptr;
+
+std::size_t size_class_index(std::size_t size) noexcept {
+    if (size <= BufferPool::k_min_size_class) {
+        return 0;
+    }
+    return std::bit_width(size - 1) -
+           std::bit_width(BufferPool::k_min_size_class - 1);
+}
+
+BufferPool::Block *allocate_block(BufferPool::Cache *owner,
+                                  std::size_t size_class,
+                                  std::size_t capacity) {
+    void *memory = ::operator new(sizeof(BufferPool::Block) + capacity);
+    return ::new (memory) BufferPool::Block{nullptr, owner, size_class,
+                                            capacity};
+}
+
+void free_block(BufferPool::Block *block) noexcept {
+    block->~Block();
+    ::operator delete(block);
+}
+
+void free_list(BufferPool::Block *block) noexcept {
+    while (block != nullptr) {
+        auto *next = block->next;
+        free_block(block);
+        block = next;
+    }
+}
+
+// Put a block back on the owning thread's free list, or free it if the list
+// for its size class is already full
+void cache_locally(BufferPool::Cache &cache,
+                   BufferPool::Block *block) noexcept {
+    auto cls = block->size_class;
+    if (cache.free_counts[cls] >= BufferPool::k_max_cached_per_class) {
+        free_block(block);
+        return;
+    }
+    block->next = cache.free_lists[cls];
+    cache.free_lists[cls] = block;
+    cache.free_counts[cls]++;
+}
+
+void drain_remote(BufferPool::Cache &cache) noexcept {
+    auto *block =
+        cache.remote_free.exchange(nullptr, std::memory_order_acquire);
+    while (block != nullptr) {
+        auto *next = block->next;
+        cache_locally(cache, block);
+        block = next;
+    }
+}
+
+void unref(BufferPool::Cache *cache) noexcept {
+    if (cache->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // Owning thread has exited and this was the last outstanding buffer
+        free_list(
+            cache->remote_free.exchange(nullptr, std::memory_order_acquire));
+        delete cache;
+    }
+}
+
+} // namespace
+
+BufferPool &BufferPool::local() {
+    thread_local BufferPool pool;
+    return pool;
+}
+
+BufferPool::BufferPool() : m_cache(new Cache) { t_cache = m_cache; }
+
+BufferPool::~BufferPool() {
+    t_cache = nullptr;
+    for (auto *&list : m_cache->free_lists) {
+        free_list(list);
+        list = nullptr;
+    }
+    m_cache->free_counts = {};
+    free_list(
+        m_cache->remote_free.exchange(nullptr, std::memory_order_acquire));
+    unref(m_cache);
+}
+
+PooledBuffer BufferPool::acquire(std::size_t size) {
+    if (size > k_max_pooled_size) {
+        auto *block = allocate_block(nullptr, 0, size);
+        return PooledBuffer{block, block->data(), size};
+    }
+
+    auto cls = size_class_index(size);
+    if (m_cache->free_lists[cls] == nullptr) {
+        drain_remote(*m_cache);
+    }
+
+    Block *block = m_cache->free_lists[cls];
+    if (block != nullptr) {
+        m_cache->free_lists[cls] = block->next;
+        m_cache->free_counts[cls]--;
+        block->next = nullptr;
+    } else {
+        block = allocate_block(m_cache, cls, k_min_size_class << cls);
+    }
+
+    m_cache->refs.fetch_add(1, std::memory_order_relaxed);
+    return PooledBuffer{block, block->data(), size};
+}
+
+std::size_t BufferPool::cached_buffers() const noexcept {
+    std::size_t count = 0;
+    for (auto n : m_cache->free_counts) {
+        count += n;
+    }
+    return count;
+}
+
+void BufferPool::release(Block *block) noexcept {
+    auto *owner = block->owner;
+    if (owner == nullptr) {
+        free_block(block);
+        return;
+    }
+
+    if (owner == t_cache) {
+        cache_locally(*owner, block);
+    } else {
+        auto *head = owner->remote_free.load(std::memory_order_relaxed);
+        do {
+            block->next = head;
+        } while (!owner->remote_free.compare_exchange_weak(
+            head, block, std::memory_order_release, std::memory_order_relaxed));
+    }
+    unref(owner);
+}
+
+} // namespace proto
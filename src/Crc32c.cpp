@@ -0,0 +1,194 @@
+#include <protobuf-cpp/Crc32c.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define PROTO_CRC32C_X86
+#include <immintrin.h>
+#endif
+
+namespace proto {
+
+namespace {
+
+// Castagnoli polynomial, bit-reflected: x^0 is the most significant bit
+constexpr std::uint32_t k_polynomial = 0x82f63b78;
+
+using Tables = std::array<std::array<std::uint32_t, 256>, 8>;
+
+// tables[k][b] is the CRC of byte b followed by k zero bytes
+constexpr Tables make_tables() {
+    Tables tables{};
+    for (std::uint32_t byte = 0; byte < 256; byte++) {
+        auto crc = byte;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) != 0 ? (crc >> 1) ^ k_polynomial : crc >> 1;
+        }
+        tables[0][byte] = crc;
+    }
+    for (std::size_t k = 1; k < tables.size(); k++) {
+        for (std::size_t byte = 0; byte < 256; byte++) {
+            const auto previous = tables[k - 1][byte];
+            tables[k][byte] = (previous >> 8) ^ tables[0][previous & 0xff];
+        }
+    }
+    return tables;
+}
+
+constexpr Tables k_tables = make_tables();
+
+std::uint64_t load_u64(const std::uint8_t *data) noexcept {
+    std::uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+// The update functions work on the raw CRC register, without the initial
+// and final inversion
+std::uint32_t update_portable(std::uint32_t crc, const std::uint8_t *data,
+                              std::size_t size) noexcept {
+    const auto &t = k_tables;
+    for (; size >= 8; data += 8, size -= 8) {
+        const auto word = load_u64(data) ^ crc;
+        crc = t[7][word & 0xff] ^ t[6][(word >> 8) & 0xff] ^
+              t[5][(word >> 16) & 0xff] ^ t[4][(word >> 24) & 0xff] ^
+              t[3][(word >> 32) & 0xff] ^ t[2][(word >> 40) & 0xff] ^
+              t[1][(word >> 48) & 0xff] ^ t[0][word >> 56];
+    }
+    for (; size > 0; data++, size--) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *data) & 0xff];
+    }
+    return crc;
+}
+
+#if defined(PROTO_CRC32C_X86)
+
+// a * b mod P for bit-reflected polynomials
+constexpr std::uint32_t multiply_mod_p(std::uint32_t a,
+                                       std::uint32_t b) noexcept {
+    std::uint32_t product = 0;
+    for (std::uint32_t mask = 1U << 31; mask != 0; mask >>= 1) {
+        if ((a & mask) != 0) {
+            product ^= b;
+        }
+        b = (b & 1) != 0 ? (b >> 1) ^ k_polynomial : b >> 1;
+    }
+    return product;
+}
+
+// x^(8 * size) mod P: multiplying a CRC register by this advances it over
+// `size` zero bytes
+constexpr std::uint32_t zeros_operator(std::size_t size) noexcept {
+    std::uint32_t result = 1U << 31; // x^0
+    std::uint32_t power = 1U << 23;  // x^8
+    for (; size != 0; size >>= 1) {
+        if ((size & 1) != 0) {
+            result = multiply_mod_p(result, power);
+        }
+        power = multiply_mod_p(power, power);
+    }
+    return result;
+}
+
+// Large inputs are processed as three interleaved streams of this many bytes,
+// which hides the latency of the crc32 instruction
+constexpr std::size_t k_stream_size = 1024;
+constexpr std::uint32_t k_shift_one_stream = zeros_operator(k_stream_size);
+constexpr std::uint32_t k_shift_two_streams =
+    zeros_operator(2 * k_stream_size);
+
+[[gnu::target("sse4.2")]] std::uint32_t
+update_sse42(std::uint32_t crc, const std::uint8_t *data,
+             std::size_t size) noexcept {
+    std::uint64_t crc64 = crc;
+    for (; size >= 8; data += 8, size -= 8) {
+        crc64 = _mm_crc32_u64(crc64, load_u64(data));
+    }
+    crc = static_cast<std::uint32_t>(crc64);
+    for (; size > 0; data++, size--) {
+        crc = _mm_crc32_u8(crc, *data);
+    }
+    return crc;
+}
+
+// crc * op mod P with a carry-less multiply. The 64-bit product is shifted
+// into place and its low half reduced with the crc32 instruction.
+[[gnu::target("sse4.2,pclmul")]] std::uint32_t
+multiply_pclmul(std::uint32_t crc, std::uint32_t op) noexcept {
+    __m128i product =
+        _mm_clmulepi64_si128(_mm_cvtsi32_si128(static_cast<int>(crc)),
+                             _mm_cvtsi32_si128(static_cast<int>(op)), 0x00);
+    product = _mm_add_epi64(product, product);
+    return static_cast<std::uint32_t>(_mm_extract_epi32(product, 1)) ^
+           _mm_crc32_u32(0, static_cast<std::uint32_t>(
+                                _mm_cvtsi128_si32(product)));
+}
+
+[[gnu::target("sse4.2,pclmul")]] std::uint32_t
+update_hardware(std::uint32_t crc, const std::uint8_t *data,
+                std::size_t size) noexcept {
+    for (; size >= 3 * k_stream_size;
+         data += 3 * k_stream_size, size -= 3 * k_stream_size) {
+        std::uint64_t a = crc;
+        std::uint64_t b = 0;
+        std::uint64_t c = 0;
+        for (std::size_t i = 0; i < k_stream_size; i += 8) {
+            a = _mm_crc32_u64(a, load_u64(data + i));
+            b = _mm_crc32_u64(b, load_u64(data + k_stream_size + i));
+            c = _mm_crc32_u64(c, load_u64(data + 2 * k_stream_size + i));
+        }
+        // crc(A + B + C) = shift(crc(A), |B| + |C|) ^ shift(crc(B), |C|)
+        //                  ^ crc(C)
+        crc = multiply_pclmul(static_cast<std::uint32_t>(a),
+                              k_shift_two_streams) ^
+              multiply_pclmul(static_cast<std::uint32_t>(b),
+                              k_shift_one_stream) ^
+              static_cast<std::uint32_t>(c);
+    }
+    return update_sse42(crc, data, size);
+}
+
+enum class Implementation { Portable, Sse42, Pclmul };
+
+Implementation detect() noexcept {
+    if (!__builtin_cpu_supports("sse4.2")) {
+        return Implementation::Portable;
+    }
+    return __builtin_cpu_supports("pclmul") ? Implementation::Pclmul
+                                            : Implementation::Sse42;
+}
+
+#endif
+
+const std::uint8_t *as_bytes(std::span<const std::byte> data) noexcept {
+    return reinterpret_cast<const std::uint8_t *>(data.data());
+}
+
+} // namespace
+
+std::uint32_t crc32c(std::span<const std::byte> data,
+                     std::uint32_t crc) noexcept {
+#if defined(PROTO_CRC32C_X86)
+    static const Implementation s_implementation = detect();
+    switch (s_implementation) {
+    case Implementation::Pclmul:
+        return ~update_hardware(~crc, as_bytes(data), data.size());
+    case Implementation::Sse42:
+        return ~update_sse42(~crc, as_bytes(data), data.size());
+    case Implementation::Portable:
+        break;
+    }
+#endif
+    return crc32c_portable(data, crc);
+}
+
+std::uint32_t crc32c_portable(std::span<const std::byte> data,
+                              std::uint32_t crc) noexcept {
+    return ~update_portable(~crc, as_bytes(data), data.size());
+}
+
+} // namespace proto
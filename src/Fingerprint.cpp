@@ -0,0 +1,157 @@
+#include <protobuf-cpp/Fingerprint.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace proto {
+
+namespace {
+
+constexpr std::uint64_t k_prime_1 = 0x9e3779b185ebca87ULL;
+constexpr std::uint64_t k_prime_2 = 0xc2b2ae3d27d4eb4fULL;
+constexpr std::uint64_t k_prime_3 = 0x165667b19e3779f9ULL;
+constexpr std::uint64_t k_prime_4 = 0x85ebca77c2b2ae63ULL;
+constexpr std::uint64_t k_prime_5 = 0x27d4eb2f165667c5ULL;
+
+std::uint64_t load_u64(const std::byte *data) noexcept {
+    std::uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    if constexpr (std::endian::native == std::endian::big) {
+        value = __builtin_bswap64(value);
+    }
+    return value;
+}
+
+std::uint32_t load_u32(const std::byte *data) noexcept {
+    std::uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    if constexpr (std::endian::native == std::endian::big) {
+        value = __builtin_bswap32(value);
+    }
+    return value;
+}
+
+constexpr std::uint64_t accumulate(std::uint64_t accumulator,
+                                  std::uint64_t input) noexcept {
+    accumulator += input * k_prime_2;
+    return std::rotl(accumulator, 31) * k_prime_1;
+}
+
+constexpr std::uint64_t merge_round(std::uint64_t hash,
+                                    std::uint64_t accumulator) noexcept {
+    hash ^= accumulate(0, accumulator);
+    return hash * k_prime_1 + k_prime_4;
+}
+
+// Consume all whole 32-byte stripes of `data`, returning the number of bytes
+// consumed
+std::size_t consume_stripes(std::array<std::uint64_t, 4> &accumulators,
+                            const std::byte *data, std::size_t size) noexcept {
+    auto [a, b, c, d] = accumulators;
+    std::size_t offset = 0;
+    for (; offset + 32 <= size; offset += 32) {
+        a = accumulate(a, load_u64(data + offset));
+        b = accumulate(b, load_u64(data + offset + 8));
+        c = accumulate(c, load_u64(data + offset + 16));
+        d = accumulate(d, load_u64(data + offset + 24));
+    }
+    accumulators = {a, b, c, d};
+    return offset;
+}
+
+// Mix in the final (fewer than 32) bytes and avalanche
+std::uint64_t finish(std::uint64_t hash, const std::byte *data,
+                     std::size_t size) noexcept {
+    for (; size >= 8; data += 8, size -= 8) {
+        hash ^= accumulate(0, load_u64(data));
+        hash = std::rotl(hash, 27) * k_prime_1 + k_prime_4;
+    }
+    if (size >= 4) {
+        hash ^= std::uint64_t{load_u32(data)} * k_prime_1;
+        hash = std::rotl(hash, 23) * k_prime_2 + k_prime_3;
+        data += 4;
+        size -= 4;
+    }
+    for (; size > 0; data++, size--) {
+        hash ^= std::to_integer<std::uint64_t>(*data) * k_prime_5;
+        hash = std::rotl(hash, 11) * k_prime_1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= k_prime_2;
+    hash ^= hash >> 29;
+    hash *= k_prime_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+std::array<std::uint64_t, 4> initial_accumulators(std::uint64_t seed) noexcept {
+    return {seed + k_prime_1 + k_prime_2, seed + k_prime_2, seed,
+            seed - k_prime_1};
+}
+
+std::uint64_t converge(const std::array<std::uint64_t, 4> &accumulators,
+                       std::uint64_t seed, std::uint64_t total_size) noexcept {
+    std::uint64_t hash;
+    if (total_size >= 32) {
+        const auto [a, b, c, d] = accumulators;
+        hash = std::rotl(a, 1) + std::rotl(b, 7) + std::rotl(c, 12) +
+               std::rotl(d, 18);
+        hash = merge_round(hash, a);
+        hash = merge_round(hash, b);
+        hash = merge_round(hash, c);
+        hash = merge_round(hash, d);
+    } else {
+        hash = seed + k_prime_5;
+    }
+    return hash + total_size;
+}
+
+} // namespace
+
+std::uint64_t fingerprint(std::span<const std::byte> data,
+                          std::uint64_t seed) noexcept {
+    auto accumulators = initial_accumulators(seed);
+    const auto consumed =
+        consume_stripes(accumulators, data.data(), data.size());
+    return finish(converge(accumulators, seed, data.size()),
+                  data.data() + consumed, data.size() - consumed);
+}
+
+Fingerprinter::Fingerprinter(std::uint64_t seed) noexcept
+    : m_seed(seed), m_accumulators(initial_accumulators(seed)) {}
+
+void Fingerprinter::update(std::span<const std::byte> data) noexcept {
+    m_total_size += data.size();
+
+    if (m_pending_size != 0) {
+        const auto fill = std::min(k_stripe_size - m_pending_size, data.size());
+        std::memcpy(m_pending.data() + m_pending_size, data.data(), fill);
+        m_pending_size += fill;
+        data = data.subspan(fill);
+        if (m_pending_size < k_stripe_size) {
+            return;
+        }
+        consume_stripes(m_accumulators, m_pending.data(), k_stripe_size);
+        m_pending_size = 0;
+    }
+
+    const auto consumed =
+        consume_stripes(m_accumulators, data.data(), data.size());
+    m_pending_size = data.size() - consumed;
+    if (m_pending_size != 0) {
+        std::memcpy(m_pending.data(), data.data() + consumed, m_pending_size);
+    }
+}
+
+std::uint64_t Fingerprinter::digest() const noexcept {
+    return finish(converge(m_accumulators, m_seed, m_total_size),
+                  m_pending.data(), m_pending_size);
+}
+
+} // namespace proto
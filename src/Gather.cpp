@@ -0,0 +1,43 @@
+#include <protobuf-cpp/Gather.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <system_error>
+#include <vector>
+
+#include <sys/uio.h>
+
+namespace proto {
+
+void write_segments(int fd, std::span<const iovec> segments) {
+    // writev may stop part-way through a segment, so work on a copy that can
+    // be advanced
+    std::vector<iovec> pending(segments.begin(), segments.end());
+    std::span<iovec> remaining{pending};
+
+    while (!remaining.empty()) {
+        const auto count = std::min<std::size_t>(remaining.size(), IOV_MAX);
+        const auto n = ::writev(fd, remaining.data(), static_cast<int>(count));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(),
+                                    "Failed to write segments");
+        }
+
+        auto written = static_cast<std::size_t>(n);
+        while (!remaining.empty() && written >= remaining.front().iov_len) {
+            written -= remaining.front().iov_len;
+            remaining = remaining.subspan(1);
+        }
+        if (written != 0) {
+            auto &front = remaining.front();
+            front.iov_base = static_cast<std::byte *>(front.iov_base) + written;
+            front.iov_len -= written;
+        }
+    }
+}
+
+} // namespace proto
@@ -0,0 +1,45 @@
+#include <protobuf-cpp/Intern.h>
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+namespace proto {
+
+std::string_view InternTable::intern(std::string_view value) {
+    if (auto it = m_values.find(value); it != m_values.end()) {
+        return *it;
+    }
+    if (value.empty()) {
+        // Nothing to copy: every empty payload maps to the same empty view
+        return *m_values.insert(std::string_view{}).first;
+    }
+    auto *copy = allocate(value.size());
+    std::memcpy(copy, value.data(), value.size());
+    m_bytes_stored += value.size();
+    return *m_values.insert(std::string_view{copy, value.size()}).first;
+}
+
+char *InternTable::allocate(std::size_t size) {
+    // Large payloads get a chunk of their own so as not to waste the rest of
+    // the current one
+    if (size > k_chunk_size / 4) {
+        return m_chunks
+            .emplace_back(std::make_unique_for_overwrite<char[]>(size))
+            .get();
+    }
+    if (size > m_free_size) {
+        m_free = m_chunks
+                     .emplace_back(
+                         std::make_unique_for_overwrite<char[]>(k_chunk_size))
+                     .get();
+        m_free_size = k_chunk_size;
+    }
+    auto *data = m_free;
+    m_free += size;
+    m_free_size -= size;
+    return data;
+}
+
+} // namespace proto
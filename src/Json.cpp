@@ -0,0 +1,157 @@
+#include <protobuf-cpp/Json.h>
+#include <protobuf-cpp/Utf8.h>
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace proto {
+
+namespace {
+
+constexpr bool needs_escape(char c) noexcept {
+    return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+}
+
+void append_escaped(std::string &out, char c) {
+    switch (c) {
+    case '"':
+        out += "\\\"";
+        break;
+    case '\\':
+        out += "\\\\";
+        break;
+    case '\b':
+        out += "\\b";
+        break;
+    case '\f':
+        out += "\\f";
+        break;
+    case '\n':
+        out += "\\n";
+        break;
+    case '\r':
+        out += "\\r";
+        break;
+    case '\t':
+        out += "\\t";
+        break;
+    default: {
+        constexpr std::string_view hex = "0123456789abcdef";
+        const auto byte = static_cast<unsigned char>(c);
+        out += "\\u00";
+        out += hex[byte >> 4];
+        out += hex[byte & 0x0f];
+        break;
+    }
+    }
+}
+
+// Length of the prefix of `value` that can be copied without escaping
+std::size_t clean_prefix_length(std::string_view value) noexcept {
+    std::size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i max_control = _mm_set1_epi8(0x1f);
+    for (; i + 16 <= value.size(); i += 16) {
+        const __m128i chunk = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(value.data() + i));
+        // Unsigned c <= 0x1f is equivalent to max(c, 0x1f) == 0x1f
+        const __m128i control =
+            _mm_cmpeq_epi8(_mm_max_epu8(chunk, max_control), max_control);
+        const __m128i special =
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                      _mm_cmpeq_epi8(chunk, backslash)),
+                         control);
+        const auto mask =
+            static_cast<std::uint32_t>(_mm_movemask_epi8(special));
+        if (mask != 0) {
+            return i + std::countr_zero(mask);
+        }
+    }
+#endif
+    for (; i < value.size(); i++) {
+        if (needs_escape(value[i])) {
+            break;
+        }
+    }
+    return i;
+}
+
+// Append `value` to `out` escaped, without the quotes
+void append_json_chars(std::string &out, std::string_view value) {
+    while (!value.empty()) {
+        const auto clean = clean_prefix_length(value);
+        out.append(value.data(), clean);
+        if (clean == value.size()) {
+            break;
+        }
+        append_escaped(out, value[clean]);
+        value.remove_prefix(clean + 1);
+    }
+}
+
+} // namespace
+
+void append_json_string(std::string &out, std::string_view value) {
+    out += '"';
+    append_json_chars(out, value);
+    out += '"';
+}
+
+void append_json_string_lossy(std::string &out, std::string_view value) {
+    // U+FFFD REPLACEMENT CHARACTER
+    constexpr std::string_view replacement = "\xef\xbf\xbd";
+
+    out += '"';
+    while (!value.empty()) {
+        const auto valid = valid_utf8_prefix_length(std::as_bytes(
+            std::span{value.data(), value.size()}));
+        append_json_chars(out, value.substr(0, valid));
+        if (valid == value.size()) {
+            break;
+        }
+        out += replacement;
+        value.remove_prefix(valid + 1);
+    }
+    out += '"';
+}
+
+void append_json_base64(std::string &out, std::span<const std::byte> value) {
+    constexpr std::string_view alphabet =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    out += '"';
+    std::size_t i = 0;
+    for (; i + 3 <= value.size(); i += 3) {
+        const auto bits = std::to_integer<std::uint32_t>(value[i]) << 16 |
+                          std::to_integer<std::uint32_t>(value[i + 1]) << 8 |
+                          std::to_integer<std::uint32_t>(value[i + 2]);
+        out += alphabet[(bits >> 18) & 0x3f];
+        out += alphabet[(bits >> 12) & 0x3f];
+        out += alphabet[(bits >> 6) & 0x3f];
+        out += alphabet[bits & 0x3f];
+    }
+    if (const auto remaining = value.size() - i; remaining > 0) {
+        auto bits = std::to_integer<std::uint32_t>(value[i]) << 16;
+        if (remaining == 2) {
+            bits |= std::to_integer<std::uint32_t>(value[i + 1]) << 8;
+        }
+        out += alphabet[(bits >> 18) & 0x3f];
+        out += alphabet[(bits >> 12) & 0x3f];
+        out += remaining == 2 ? alphabet[(bits >> 6) & 0x3f] : '=';
+        out += '=';
+    }
+    out += '"';
+}
+
+} // namespace proto
@@ -0,0 +1,297 @@
+#include <protobuf-cpp/Profile.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include <cxxabi.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace proto {
+
+namespace {
+
+#if defined(__linux__)
+// The calling thread's hardware counters, opened as one perf event group so
+// that all of them are read with a single system call
+class PerfCounters {
+  public:
+    PerfCounters() {
+        constexpr std::array<std::uint64_t, k_num_counters> configs{
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES};
+        for (std::size_t i = 0; i < configs.size(); i++) {
+            perf_event_attr attr{};
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = configs[i];
+            attr.read_format = PERF_FORMAT_GROUP |
+                               PERF_FORMAT_TOTAL_TIME_ENABLED |
+                               PERF_FORMAT_TOTAL_TIME_RUNNING;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            // Counts the calling thread on any CPU
+            const auto fd = static_cast<int>(
+                ::syscall(SYS_perf_event_open, &attr, 0, -1, m_leader,
+                          PERF_FLAG_FD_CLOEXEC));
+            if (fd < 0) {
+                // Without cycles there is no group to add the others to
+                if (i == 0) {
+                    return;
+                }
+                continue;
+            }
+            if (m_leader < 0) {
+                m_leader = fd;
+            }
+            m_fds[m_num_open] = fd;
+            m_counters[m_num_open] = i;
+            m_num_open++;
+        }
+    }
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    ~PerfCounters() {
+        for (std::size_t i = 0; i < m_num_open; i++) {
+            ::close(m_fds[i]);
+        }
+    }
+
+    [[nodiscard]] bool available() const noexcept { return m_leader >= 0; }
+
+    void read(CounterReading &reading) const noexcept {
+        if (!available()) {
+            return;
+        }
+        // The number of counters, the times enabled and running, then the
+        // counter values
+        std::array<std::uint64_t, 3 + k_num_counters> values{};
+        const auto size = ::read(m_leader, values.data(), sizeof(values));
+        if (size < static_cast<ssize_t>((3 + m_num_open) *
+                                        sizeof(std::uint64_t)) ||
+            values[0] != m_num_open) {
+            return;
+        }
+        reading.time_enabled = values[1];
+        reading.time_running = values[2];
+        for (std::size_t i = 0; i < m_num_open; i++) {
+            reading.counters[m_counters[i]] = values[3 + i];
+            reading.counted[m_counters[i]] = true;
+        }
+    }
+
+  private:
+    int m_leader{-1};
+    std::array<int, k_num_counters> m_fds{};
+    std::array<std::size_t, k_num_counters> m_counters{};
+    std::size_t m_num_open{};
+};
+#else
+class PerfCounters {
+  public:
+    [[nodiscard]] bool available() const noexcept { return false; }
+    void read(CounterReading &) const noexcept {}
+};
+#endif
+
+PerfCounters &thread_counters() {
+    thread_local PerfCounters counters;
+    return counters;
+}
+
+std::string demangle(const char *name) {
+    int status = 0;
+    std::unique_ptr<char, decltype(&std::free)> demangled{
+        abi::__cxa_demangle(name, nullptr, nullptr, &status), &std::free};
+    return status == 0 && demangled ? std::string{demangled.get()}
+                                    : std::string{name};
+}
+
+const char *operation_name(CodecOperation operation) noexcept {
+    return operation == CodecOperation::Serialize ? "serialize"
+                                                  : "deserialize";
+}
+
+double ratio(std::uint64_t numerator, std::uint64_t denominator) noexcept {
+    return denominator == 0 ? 0.0
+                            : static_cast<double>(numerator) /
+                                  static_cast<double>(denominator);
+}
+
+} // namespace
+
+thread_local std::uint32_t CodecProfiler::s_calls_until_sample = 0;
+
+std::uint32_t CodecProfiler::next_sample_gap(std::uint32_t period) noexcept {
+    if (period <= 1) {
+        return 1;
+    }
+    // xorshift64: cheap, and good enough to spread samples. Seeded per
+    // thread so that threads do not all sample the same calls.
+    thread_local std::uint64_t state =
+        (0x9e3779b97f4a7c15 ^
+         std::hash<std::thread::id>{}(std::this_thread::get_id())) |
+        1;
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    const auto range = 2 * static_cast<std::uint64_t>(period) - 1;
+    return static_cast<std::uint32_t>(1 + state % range);
+}
+
+double CodecProfile::nanoseconds_per_byte() const noexcept {
+    return ratio(nanoseconds, num_bytes);
+}
+
+double CodecProfile::cycles_per_byte() const noexcept {
+    return ratio(counter(Counter::Cycles), num_bytes);
+}
+
+double CodecProfile::instructions_per_cycle() const noexcept {
+    return ratio(counter(Counter::Instructions), counter(Counter::Cycles));
+}
+
+CodecProfiler &CodecProfiler::global() {
+    static CodecProfiler profiler;
+    return profiler;
+}
+
+bool CodecProfiler::hardware_counters_available() {
+    return thread_counters().available();
+}
+
+CounterReading CodecProfiler::read_counters() {
+    CounterReading reading;
+    thread_counters().read(reading);
+    reading.nanoseconds = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+    return reading;
+}
+
+void CodecProfiler::finish_sample(const std::type_info &type,
+                                  CodecOperation operation,
+                                  std::size_t num_bytes,
+                                  const CounterReading &start) {
+    const auto end = read_counters();
+    const Key key{std::type_index{type}, operation};
+
+    // The group is scheduled as a whole, so one pair of times covers every
+    // counter. If it was multiplexed for part of the sample, the counts are
+    // scaled up to the whole sample as perf does; if it never ran, the
+    // sample is dropped.
+    const auto enabled = end.time_enabled - start.time_enabled;
+    const auto running = end.time_running - start.time_running;
+    if (enabled != 0 && running == 0) {
+        return;
+    }
+    const auto scaled = [&](std::uint64_t delta) {
+        if (running == enabled) {
+            return delta;
+        }
+        return static_cast<std::uint64_t>(static_cast<double>(delta) *
+                                          static_cast<double>(enabled) /
+                                          static_cast<double>(running));
+    };
+
+    const std::scoped_lock lock{m_mutex};
+    auto it = std::ranges::find(m_profiles, key,
+                                &std::pair<Key, CodecProfile>::first);
+    if (it == m_profiles.end()) {
+        CodecProfile profile{demangle(type.name()), operation};
+        profile.counted.fill(true);
+        m_profiles.emplace_back(key, std::move(profile));
+        it = m_profiles.end() - 1;
+    }
+    auto &profile = it->second;
+    profile.num_samples++;
+    profile.num_bytes += num_bytes;
+    profile.nanoseconds += end.nanoseconds - start.nanoseconds;
+    for (std::size_t i = 0; i < k_num_counters; i++) {
+        const bool counted = start.counted[i] && end.counted[i];
+        profile.counted[i] = profile.counted[i] && counted;
+        if (counted) {
+            profile.counters[i] +=
+                scaled(end.counters[i] - start.counters[i]);
+        }
+    }
+}
+
+std::vector<CodecProfile> CodecProfiler::profiles() const {
+    std::vector<CodecProfile> profiles;
+    {
+        const std::scoped_lock lock{m_mutex};
+        for (const auto &[key, profile] : m_profiles) {
+            profiles.push_back(profile);
+        }
+    }
+    std::ranges::sort(profiles, [](const auto &a, const auto &b) {
+        return std::tie(a.message_type, a.operation) <
+               std::tie(b.message_type, b.operation);
+    });
+    return profiles;
+}
+
+std::string CodecProfiler::report() const {
+    std::string report;
+    std::array<char, 256> line{};
+    std::snprintf(line.data(), line.size(),
+                  "%-32s %-11s %9s %10s %8s %11s %6s %13s %13s\n",
+                  "message type", "operation", "samples", "bytes/call",
+                  "ns/byte", "cycles/byte", "IPC", "branch-miss/c",
+                  "cache-miss/c");
+    report += line.data();
+
+    for (const auto &profile : profiles()) {
+        const auto per_sample = [&](Counter counter) {
+            return profile.has(counter)
+                       ? ratio(profile.counter(counter), profile.num_samples)
+                       : -1.0;
+        };
+        const bool cycles = profile.has(Counter::Cycles);
+        const bool ipc = cycles && profile.has(Counter::Instructions);
+        // Counters that could not be read are printed as -1
+        std::snprintf(
+            line.data(), line.size(),
+            "%-32s %-11s %9llu %10.1f %8.3f %11.3f %6.2f %13.2f %13.2f\n",
+            profile.message_type.c_str(), operation_name(profile.operation),
+            static_cast<unsigned long long>(profile.num_samples),
+            ratio(profile.num_bytes, profile.num_samples),
+            profile.nanoseconds_per_byte(),
+            cycles ? profile.cycles_per_byte() : -1.0,
+            ipc ? profile.instructions_per_cycle() : -1.0,
+            per_sample(Counter::BranchMisses),
+            per_sample(Counter::CacheMisses));
+        report += line.data();
+    }
+    return report;
+}
+
+void CodecProfiler::reset() {
+    const std::scoped_lock lock{m_mutex};
+    m_profiles.clear();
+}
+
+} // namespace proto
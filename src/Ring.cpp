@@ -0,0 +1,136 @@
+#include <protobuf-cpp/Ring.h>
+
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace proto {
+
+namespace {
+
+// Smallest ring that can hold a non-empty message
+constexpr std::size_t k_min_ring_capacity = 16;
+
+[[noreturn]] void throw_errno(const char *what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+// Map `size` bytes of the shared memory object open as `fd`, closing `fd`
+std::byte *map_shared(int fd, std::size_t size) {
+    void *data =
+        ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const auto error = errno;
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        errno = error;
+        throw_errno("Error mapping shared memory");
+    }
+    return static_cast<std::byte *>(data);
+}
+
+} // namespace
+
+void initialize_ring(std::span<std::byte> memory) {
+    if (memory.size() < ring_memory_size(k_min_ring_capacity)) {
+        throw std::runtime_error("Memory too small for a ring");
+    }
+    auto *header = reinterpret_cast<RingHeader *>(memory.data());
+    header->magic = RingHeader::k_magic;
+    header->capacity = std::bit_floor(memory.size() - k_ring_data_offset);
+    std::construct_at(&header->head, 0);
+    std::construct_at(&header->tail, 0);
+}
+
+RingEnd::RingEnd(std::span<std::byte> memory) {
+    if (memory.size() < k_ring_data_offset) {
+        throw std::runtime_error("Memory too small for a ring");
+    }
+    m_header = reinterpret_cast<RingHeader *>(memory.data());
+    m_data = memory.data() + k_ring_data_offset;
+    m_capacity = static_cast<std::size_t>(m_header->capacity);
+    if (m_header->magic != RingHeader::k_magic ||
+        !std::has_single_bit(m_capacity) ||
+        m_capacity < k_min_ring_capacity ||
+        m_capacity > memory.size() - k_ring_data_offset) {
+        throw std::runtime_error("Memory holds no ring");
+    }
+}
+
+RingProducer::RingProducer(std::span<std::byte> memory)
+    : RingEnd(memory),
+      m_head(m_header->head.load(std::memory_order_relaxed)),
+      m_cached_tail(m_header->tail.load(std::memory_order_acquire)) {}
+
+RingConsumer::RingConsumer(std::span<std::byte> memory)
+    : RingEnd(memory),
+      m_tail(m_header->tail.load(std::memory_order_relaxed)),
+      m_cached_head(m_tail) {}
+
+SharedMemory SharedMemory::create(const std::string &name, std::size_t size) {
+    const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        throw_errno("Error creating shared memory");
+    }
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        const auto error = errno;
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        errno = error;
+        throw_errno("Error sizing shared memory");
+    }
+    return SharedMemory{map_shared(fd, size), size};
+}
+
+SharedMemory SharedMemory::open(const std::string &name) {
+    const int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        throw_errno("Error opening shared memory");
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0) {
+        const auto error = errno;
+        ::close(fd);
+        errno = error;
+        throw_errno("Error opening shared memory");
+    }
+    const auto size = static_cast<std::size_t>(info.st_size);
+    return SharedMemory{map_shared(fd, size), size};
+}
+
+void SharedMemory::unlink(const std::string &name) noexcept {
+    ::shm_unlink(name.c_str());
+}
+
+SharedMemory::SharedMemory(SharedMemory &&other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr)),
+      m_size(std::exchange(other.m_size, 0)) {}
+
+SharedMemory &SharedMemory::operator=(SharedMemory &&other) noexcept {
+    if (this != &other) {
+        if (m_data != nullptr) {
+            ::munmap(m_data, m_size);
+        }
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+    }
+    return *this;
+}
+
+SharedMemory::~SharedMemory() {
+    if (m_data != nullptr) {
+        ::munmap(m_data, m_size);
+    }
+}
+
+} // namespace proto
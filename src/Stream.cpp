@@ -0,0 +1,301 @@
+#include <protobuf-cpp/Crc32c.h>
+#include <protobuf-cpp/Framing.h>
+#include <protobuf-cpp/Stream.h>
+#include <protobuf-cpp/Tokenizer.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <system_error>
+
+#include <poll.h>
+#include <unistd.h>
+
+namespace proto {
+
+namespace {
+
+struct ReadResult {
+    std::size_t size{};
+    bool eof{};
+    bool stopped{};
+    int error{};
+};
+
+// Read whatever is available from `fd`, unless `wake_fd` becomes readable
+// first
+ReadResult read_some(int fd, int wake_fd, std::span<std::byte> buffer) {
+    while (true) {
+        std::array<pollfd, 2> fds{pollfd{fd, POLLIN, 0},
+                                  pollfd{wake_fd, POLLIN, 0}};
+        if (::poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return ReadResult{0, false, false, errno};
+        }
+        if (fds[1].revents != 0) {
+            return ReadResult{0, false, true, 0};
+        }
+        if (fds[0].revents == 0) {
+            continue;
+        }
+
+        const auto n = ::read(fd, buffer.data(), buffer.size());
+        if (n > 0) {
+            return ReadResult{static_cast<std::size_t>(n), false, false, 0};
+        }
+        if (n == 0) {
+            return ReadResult{0, true, false, 0};
+        }
+        if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
+            return ReadResult{0, false, false, errno};
+        }
+    }
+}
+
+// Size of the frame starting with `partial`, or 0 if its length is
+// incomplete or malformed
+std::uint64_t frame_size(std::span<const std::byte> partial,
+                         FrameFormat format) noexcept {
+    auto length = read_varint(partial);
+    if (length.num_bytes_read == 0) {
+        return 0;
+    }
+    const std::size_t checksum_size =
+        format == FrameFormat::Checksummed ? sizeof(std::uint32_t) : 0;
+    return length.num_bytes_read + checksum_size + length.value.value();
+}
+
+// A length that has not terminated within Varint::k_max_size bytes never will
+bool is_malformed(std::span<const std::byte> partial) noexcept {
+    return partial.size() >= Varint::k_max_size &&
+           read_varint(partial).num_bytes_read == 0;
+}
+
+// Bytes still missing from a partial frame
+std::size_t bytes_needed(std::span<const std::byte> partial,
+                         FrameFormat format) {
+    if (is_malformed(partial)) {
+        throw std::runtime_error("Error parsing frame length");
+    }
+    const auto size = frame_size(partial, format);
+    return size == 0 ? 1 : static_cast<std::size_t>(size - partial.size());
+}
+
+} // namespace
+
+FrameReader::FrameReader(int fd, std::size_t chunk_size, FrameFormat format,
+                         std::size_t max_frame_size)
+    : m_fd(fd), m_format(format), m_max_frame_size(max_frame_size),
+      m_verify_ahead(format == FrameFormat::Checksummed) {
+    if (::pipe(m_wake_pipe.data()) != 0) {
+        throw std::system_error(errno, std::generic_category(),
+                                "Failed to create wake-up pipe");
+    }
+    for (auto &chunk : m_chunks) {
+        chunk.data.resize(std::max<std::size_t>(chunk_size, 1));
+    }
+    m_thread = std::thread([this] { read_ahead(); });
+}
+
+FrameReader::~FrameReader() {
+    {
+        std::scoped_lock lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    const std::byte wake{1};
+    [[maybe_unused]] auto written = ::write(m_wake_pipe[1], &wake, 1);
+    m_thread.join();
+    ::close(m_wake_pipe[0]);
+    ::close(m_wake_pipe[1]);
+}
+
+void FrameReader::read_ahead() {
+    std::size_t slot = 0;
+    while (true) {
+        Chunk &chunk = m_chunks[slot];
+        {
+            std::unique_lock lock(m_mutex);
+            m_cv.wait(lock, [&] { return m_stop || !chunk.filled; });
+            if (m_stop) {
+                return;
+            }
+        }
+
+        // The consumer does not touch an unfilled chunk, so read unlocked
+        const auto result = read_some(m_fd, m_wake_pipe[0], chunk.data);
+        if (result.stopped) {
+            return;
+        }
+        chunk.size = result.size;
+        chunk.verified_begin = 0;
+        chunk.verified_end = 0;
+        if (m_verify_ahead) {
+            verify_ahead(chunk);
+        }
+        {
+            std::scoped_lock lock(m_mutex);
+            chunk.eof = result.eof;
+            chunk.error = result.error;
+            chunk.filled = true;
+        }
+        m_cv.notify_all();
+        if (result.eof || result.error != 0) {
+            return;
+        }
+        slot ^= 1;
+    }
+}
+
+// Runs on the read-ahead thread, tracking frame boundaries across chunks on
+// its own. Stops verifying ahead at the first frame that is malformed or fails
+// its checksum; the consumer then verifies and reports it.
+void FrameReader::verify_ahead(Chunk &chunk) {
+    std::span<const std::byte> data{chunk.data.data(), chunk.size};
+
+    if (m_ahead_header_size != 0) {
+        // Complete the length of a frame whose header straddles chunks
+        const auto take =
+            std::min(m_ahead_header.size() - m_ahead_header_size, data.size());
+        std::copy_n(data.begin(), take,
+                    m_ahead_header.begin() + m_ahead_header_size);
+        const std::span<const std::byte> header{m_ahead_header.data(),
+                                                m_ahead_header_size + take};
+        const auto size = frame_size(header, m_format);
+        if (size == 0) {
+            if (is_malformed(header)) {
+                m_verify_ahead = false;
+                return;
+            }
+            m_ahead_header_size += take;
+            return;
+        }
+        m_ahead_skip = size - m_ahead_header_size;
+        m_ahead_header_size = 0;
+    }
+
+    const auto skip = static_cast<std::size_t>(
+        std::min<std::uint64_t>(m_ahead_skip, data.size()));
+    m_ahead_skip -= skip;
+    std::size_t pos = skip;
+    chunk.verified_begin = pos;
+
+    while (pos < data.size()) {
+        const auto remaining = data.subspan(pos);
+        const auto frame = locate_frame(remaining, m_format);
+        if (frame.num_bytes_read == 0) {
+            // The frame continues in the next chunk
+            const auto size = frame_size(remaining, m_format);
+            if (size != 0) {
+                m_ahead_skip = size - remaining.size();
+            } else if (is_malformed(remaining)) {
+                m_verify_ahead = false;
+            } else {
+                std::ranges::copy(remaining, m_ahead_header.begin());
+                m_ahead_header_size = remaining.size();
+            }
+            break;
+        }
+        if (crc32c(frame.value.payload) != frame.value.checksum) {
+            m_verify_ahead = false;
+            break;
+        }
+        pos += frame.num_bytes_read;
+    }
+    chunk.verified_end = pos;
+}
+
+// Hand the current chunk back to the read-ahead thread and wait for the next.
+// Returns false at end of stream.
+bool FrameReader::fetch_chunk() {
+    std::unique_lock lock(m_mutex);
+    if (m_front != nullptr) {
+        if (m_front->eof || m_front->error != 0) {
+            return false;
+        }
+        m_front->filled = false;
+        m_cv.notify_all();
+    }
+
+    Chunk &next = m_chunks[m_next_slot];
+    m_cv.wait(lock, [&] { return next.filled; });
+    m_front = &next;
+    m_front_pos = 0;
+    m_next_slot ^= 1;
+
+    if (next.error != 0) {
+        throw std::system_error(next.error, std::generic_category(),
+                                "Failed to read frames");
+    }
+    return next.size != 0 || !next.eof;
+}
+
+std::span<const std::byte> FrameReader::front_remaining() const noexcept {
+    if (m_front == nullptr) {
+        return {};
+    }
+    return std::span<const std::byte>{m_front->data}.subspan(
+        m_front_pos, m_front->size - m_front_pos);
+}
+
+void FrameReader::check_frame_size(std::uint64_t size) const {
+    if (size > m_max_frame_size) {
+        throw std::runtime_error("Frame exceeds the maximum frame size");
+    }
+}
+
+std::optional<std::span<const std::byte>> FrameReader::next() {
+    m_carry.clear();
+    while (true) {
+        auto available = front_remaining();
+        if (m_carry.empty()) {
+            auto frame = locate_frame(available, m_format);
+            if (frame.num_bytes_read != 0) {
+                check_frame_size(frame.num_bytes_read);
+                const bool verified = m_front_pos >= m_front->verified_begin &&
+                                      m_front_pos + frame.num_bytes_read <=
+                                          m_front->verified_end;
+                if (m_format == FrameFormat::Checksummed && !verified) {
+                    verify_checksum(frame.value);
+                }
+                m_front_pos += frame.num_bytes_read;
+                return frame.value.payload;
+            }
+            // The frame continues in the next chunk
+            m_carry.assign(available.begin(), available.end());
+            m_front_pos += available.size();
+        } else {
+            // Known once the length is complete, and before the carry-over
+            // buffer grows to hold the frame
+            check_frame_size(frame_size(m_carry, m_format));
+            const auto take =
+                std::min(bytes_needed(m_carry, m_format), available.size());
+            m_carry.insert(m_carry.end(), available.begin(),
+                           available.begin() + take);
+            m_front_pos += take;
+
+            auto frame = locate_frame(m_carry, m_format);
+            if (frame.num_bytes_read != 0) {
+                if (m_format == FrameFormat::Checksummed) {
+                    verify_checksum(frame.value);
+                }
+                return frame.value.payload;
+            }
+        }
+
+        if (!front_remaining().empty()) {
+            continue;
+        }
+        if (!fetch_chunk()) {
+            if (m_carry.empty()) {
+                return std::nullopt;
+            }
+            throw std::runtime_error("Stream ended in a partial frame");
+        }
+    }
+}
+
+} // namespace proto
@@ -0,0 +1,315 @@
+#include <protobuf-cpp/Utf8.h>
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define PROTO_UTF8_AVX2
+#include <immintrin.h>
+#endif
+
+namespace proto {
+
+namespace {
+
+constexpr bool is_continuation(std::uint8_t byte) noexcept {
+    return (byte & 0xc0) == 0x80;
+}
+
+// Length of the well-formed sequence at the start of `data`, or 0 if there is
+// none. Follows table 3-7 of the Unicode standard.
+constexpr std::size_t sequence_length(const std::uint8_t *data,
+                                      std::size_t size) noexcept {
+    const auto lead = data[0];
+    if (lead < 0x80) {
+        return 1;
+    }
+    if (lead < 0xc2) {
+        // Continuation byte, or overlong two-byte sequence
+        return 0;
+    }
+    if (lead < 0xe0) {
+        return size >= 2 && is_continuation(data[1]) ? 2 : 0;
+    }
+    if (lead < 0xf0) {
+        // Exclude overlong sequences and surrogates
+        const std::uint8_t low = lead == 0xe0 ? 0xa0 : 0x80;
+        const std::uint8_t high = lead == 0xed ? 0x9f : 0xbf;
+        return size >= 3 && data[1] >= low && data[1] <= high &&
+                       is_continuation(data[2])
+                   ? 3
+                   : 0;
+    }
+    if (lead < 0xf5) {
+        // Exclude overlong sequences and code points above U+10FFFF
+        const std::uint8_t low = lead == 0xf0 ? 0x90 : 0x80;
+        const std::uint8_t high = lead == 0xf4 ? 0x8f : 0xbf;
+        return size >= 4 && data[1] >= low && data[1] <= high &&
+                       is_continuation(data[2]) && is_continuation(data[3])
+                   ? 4
+                   : 0;
+    }
+    return 0;
+}
+
+// Length of the ASCII prefix of `data`; at least 1 if data[0] is ASCII
+std::size_t ascii_prefix_length(const std::uint8_t *data,
+                                std::size_t size) noexcept {
+    std::size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 16 <= size; i += 16) {
+        const __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(chunk));
+        if (mask != 0) {
+            return i + std::countr_zero(mask);
+        }
+    }
+#endif
+    while (i < size && data[i] < 0x80) {
+        i++;
+    }
+    return i;
+}
+
+// Length of the longest well-formed prefix of `data`
+template <bool SkipAscii>
+std::size_t valid_prefix_length(const std::uint8_t *data,
+                                std::size_t size) noexcept {
+    std::size_t i = 0;
+    while (i < size) {
+        if (SkipAscii && data[i] < 0x80) {
+            i += ascii_prefix_length(data + i, size - i);
+            continue;
+        }
+        const auto length = sequence_length(data + i, size - i);
+        if (length == 0) {
+            break;
+        }
+        i += length;
+    }
+    return i;
+}
+
+template <bool SkipAscii>
+bool validate(const std::uint8_t *data, std::size_t size) noexcept {
+    return valid_prefix_length<SkipAscii>(data, size) == size;
+}
+
+#if defined(PROTO_UTF8_AVX2)
+
+// Keiser and Lemire, "Validating UTF-8 In Less Than One Instruction Per
+// Byte" (2021). Each byte is classified by the high nibble of its
+// predecessor, the low nibble of its predecessor and its own high nibble;
+// the three lookups are ANDed so that a bit survives only for an invalid
+// pair. Sequences of three and four bytes are then checked by requiring a
+// continuation byte exactly where a lead two or three bytes back expects one.
+
+constexpr std::uint8_t k_too_short = 1 << 0;
+constexpr std::uint8_t k_too_long = 1 << 1;
+constexpr std::uint8_t k_overlong_3 = 1 << 2;
+constexpr std::uint8_t k_too_large = 1 << 3;
+constexpr std::uint8_t k_surrogate = 1 << 4;
+constexpr std::uint8_t k_overlong_2 = 1 << 5;
+constexpr std::uint8_t k_too_large_1000 = 1 << 6;
+constexpr std::uint8_t k_overlong_4 = 1 << 6;
+constexpr std::uint8_t k_two_continuations = 1 << 7;
+constexpr std::uint8_t k_carry =
+    k_too_short | k_too_long | k_two_continuations;
+
+// Indexed by the high nibble of the previous byte
+constexpr std::array<std::uint8_t, 16> k_byte_1_high{
+    k_too_long,
+    k_too_long,
+    k_too_long,
+    k_too_long,
+    k_too_long,
+    k_too_long,
+    k_too_long,
+    k_too_long,
+    k_two_continuations,
+    k_two_continuations,
+    k_two_continuations,
+    k_two_continuations,
+    k_too_short | k_overlong_2,
+    k_too_short,
+    k_too_short | k_overlong_3 | k_surrogate,
+    k_too_short | k_too_large | k_too_large_1000 | k_overlong_4,
+};
+
+// Indexed by the low nibble of the previous byte
+constexpr std::array<std::uint8_t, 16> k_byte_1_low{
+    k_carry | k_overlong_3 | k_overlong_2 | k_overlong_4,
+    k_carry | k_overlong_2,
+    k_carry,
+    k_carry,
+    k_carry | k_too_large,
+    k_carry | k_too_large | k_too_large_1000,
+    k_carry | k_too_large | k_too_large_1000,
+    k_carry | k_too_large | k_too_large_1000,
+    k_carry | k_too_large | k_too_large_1000,
+    k_carry | k_too_large | k_too_large_1000,
+    k_carry | k_too_large | k_too_large_1000,
+    k_carry | k_too_large | k_too_large_1000,
+    k_carry | k_too_large | k_too_large_1000,
+    k_carry | k_too_large | k_too_large_1000 | k_surrogate,
+    k_carry | k_too_large | k_too_large_1000,
+    k_carry | k_too_large | k_too_large_1000,
+};
+
+// Indexed by the high nibble of the current byte
+constexpr std::array<std::uint8_t, 16> k_byte_2_high{
+    k_too_short,
+    k_too_short,
+    k_too_short,
+    k_too_short,
+    k_too_short,
+    k_too_short,
+    k_too_short,
+    k_too_short,
+    k_too_long | k_overlong_2 | k_two_continuations | k_overlong_3 |
+        k_too_large_1000 | k_overlong_4,
+    k_too_long | k_overlong_2 | k_two_continuations | k_overlong_3 |
+        k_too_large,
+    k_too_long | k_overlong_2 | k_two_continuations | k_surrogate |
+        k_too_large,
+    k_too_long | k_overlong_2 | k_two_continuations | k_surrogate |
+        k_too_large,
+    k_too_short,
+    k_too_short,
+    k_too_short,
+    k_too_short,
+};
+
+struct Avx2State {
+    __m256i error;
+    __m256i prev_input;
+    __m256i prev_incomplete;
+};
+
+[[gnu::target("avx2")]] __m256i
+broadcast_table(const std::array<std::uint8_t, 16> &table) noexcept {
+    return _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(table.data())));
+}
+
+[[gnu::target("avx2")]] __m256i high_nibbles(__m256i bytes) noexcept {
+    return _mm256_and_si256(_mm256_srli_epi16(bytes, 4),
+                            _mm256_set1_epi8(0x0f));
+}
+
+// The 32 bytes ending N bytes before the end of `input`
+template <int N>
+[[gnu::target("avx2")]] __m256i previous(__m256i input,
+                                         __m256i prev_input) noexcept {
+    return _mm256_alignr_epi8(
+        input, _mm256_permute2x128_si256(prev_input, input, 0x21), 16 - N);
+}
+
+[[gnu::target("avx2")]] void check_block(Avx2State &state,
+                                         __m256i input) noexcept {
+    if (_mm256_movemask_epi8(input) == 0) {
+        // All ASCII: only a sequence left open by the previous block can fail
+        state.error = _mm256_or_si256(state.error, state.prev_incomplete);
+        state.prev_incomplete = _mm256_setzero_si256();
+        state.prev_input = input;
+        return;
+    }
+
+    const __m256i prev1 = previous<1>(input, state.prev_input);
+    const __m256i special_cases = _mm256_and_si256(
+        _mm256_and_si256(
+            _mm256_shuffle_epi8(broadcast_table(k_byte_1_high),
+                                high_nibbles(prev1)),
+            _mm256_shuffle_epi8(
+                broadcast_table(k_byte_1_low),
+                _mm256_and_si256(prev1, _mm256_set1_epi8(0x0f)))),
+        _mm256_shuffle_epi8(broadcast_table(k_byte_2_high),
+                            high_nibbles(input)));
+
+    // 0x80 where the byte must be the 2nd or 3rd continuation of a sequence
+    const __m256i prev2 = previous<2>(input, state.prev_input);
+    const __m256i prev3 = previous<3>(input, state.prev_input);
+    const __m256i third_byte = _mm256_subs_epu8(
+        prev2, _mm256_set1_epi8(static_cast<char>(0xe0 - 0x80)));
+    const __m256i fourth_byte = _mm256_subs_epu8(
+        prev3, _mm256_set1_epi8(static_cast<char>(0xf0 - 0x80)));
+    const __m256i must_be_continuation =
+        _mm256_and_si256(_mm256_or_si256(third_byte, fourth_byte),
+                         _mm256_set1_epi8(static_cast<char>(0x80)));
+
+    state.error = _mm256_or_si256(
+        state.error, _mm256_xor_si256(must_be_continuation, special_cases));
+
+    // Non-zero if the block ends in a lead byte that expects more bytes
+    const __m256i max_complete = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        static_cast<char>(0xf0 - 1), static_cast<char>(0xe0 - 1),
+        static_cast<char>(0xc0 - 1));
+    state.prev_incomplete = _mm256_subs_epu8(input, max_complete);
+    state.prev_input = input;
+}
+
+[[gnu::target("avx2")]] bool validate_avx2(const std::uint8_t *data,
+                                           std::size_t size) noexcept {
+    Avx2State state{_mm256_setzero_si256(), _mm256_setzero_si256(),
+                    _mm256_setzero_si256()};
+
+    std::size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        check_block(state, _mm256_loadu_si256(
+                               reinterpret_cast<const __m256i *>(data + i)));
+    }
+    if (i < size) {
+        // Pad with ASCII, which terminates any sequence left open
+        std::array<std::uint8_t, 32> tail{};
+        std::memcpy(tail.data(), data + i, size - i);
+        check_block(state, _mm256_loadu_si256(
+                               reinterpret_cast<const __m256i *>(tail.data())));
+    }
+
+    const __m256i error =
+        _mm256_or_si256(state.error, state.prev_incomplete);
+    return _mm256_testz_si256(error, error) != 0;
+}
+
+bool has_avx2() noexcept {
+    static const bool s_has_avx2 = __builtin_cpu_supports("avx2");
+    return s_has_avx2;
+}
+
+#endif
+
+const std::uint8_t *as_bytes(std::span<const std::byte> data) noexcept {
+    return reinterpret_cast<const std::uint8_t *>(data.data());
+}
+
+} // namespace
+
+bool is_valid_utf8(std::span<const std::byte> data) noexcept {
+#if defined(PROTO_UTF8_AVX2)
+    if (has_avx2()) {
+        return validate_avx2(as_bytes(data), data.size());
+    }
+#endif
+    return validate<true>(as_bytes(data), data.size());
+}
+
+bool is_valid_utf8_scalar(std::span<const std::byte> data) noexcept {
+    return validate<false>(as_bytes(data), data.size());
+}
+
+std::size_t valid_utf8_prefix_length(std::span<const std::byte> data) noexcept {
+    return valid_prefix_length<true>(as_bytes(data), data.size());
+}
+
+} // namespace proto
@@ -0,0 +1,41 @@
+#include <protobuf-cpp/Validate.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace proto {
+
+std::uint64_t varint_end_mask(const std::byte *data) noexcept {
+#if defined(__SSE2__)
+    // movemask collects the continuation bits of 16 bytes at once
+    std::uint64_t continuation = 0;
+    for (int i = 0; i < 4; i++) {
+        const __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 16 * i));
+        continuation |=
+            static_cast<std::uint64_t>(static_cast<std::uint32_t>(
+                _mm_movemask_epi8(chunk)))
+            << (16 * i);
+    }
+    return ~continuation;
+#else
+    // Gather the top bit of each byte of a word into one byte by multiplying
+    constexpr std::uint64_t k_high_bits = 0x8080808080808080;
+    constexpr std::uint64_t k_gather = 0x0102040810204080;
+    std::uint64_t mask = 0;
+    for (int i = 0; i < 8; i++) {
+        std::uint64_t word;
+        std::memcpy(&word, data + 8 * i, sizeof(word));
+        const auto ends = (~word & k_high_bits) >> 7;
+        mask |= ((ends * k_gather) >> 56) << (8 * i);
+    }
+    return mask;
+#endif
+}
+
+} // namespace proto
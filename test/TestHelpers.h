@@ -0,0 +1,21 @@
+#pragma once
+
+#include <protobuf-cpp/Utils.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+namespace test {
+
+// Serialize each of `records` back to back
+template <typename... Records>
+std::vector<std::byte> concat(const Records &...records) {
+    std::vector<std::byte> buffer;
+    (std::ranges::copy(proto::serialize(records), std::back_inserter(buffer)),
+     ...);
+    return buffer;
+}
+
+} // namespace test
@@ -2,8 +2,21 @@
 
 #include <protobuf-cpp/Encoding.h>
 #include <protobuf-cpp/Fixint.h>
+#include <protobuf-cpp/Fused.h>
+#include <protobuf-cpp/Map.h>
 
+#include <array>
+#include <bitset>
+#include <cstddef>
 #include <cstdint>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 namespace test {
 
@@ -19,6 +32,7 @@ struct DoubleInt {
     std::int32_t value2;
 
     using members = proto::Members<&DoubleInt::value1, &DoubleInt::value2>;
+    static constexpr std::array member_names{"value1", "value2"};
 
     constexpr auto operator<=>(const DoubleInt &) const = default;
 };
@@ -37,10 +51,127 @@ struct IntAndFloat_asFixed {
 
     using members = proto::Members<&IntAndFloat_asFixed::value1,
                                    &IntAndFloat_asFixed::value2>;
+    static constexpr std::array member_names{"value1", "value2"};
 
     constexpr auto operator<=>(const IntAndFloat_asFixed &) const = default;
 };
 
+struct OptionalInt {
+    std::optional<std::int32_t> value1;
+    std::uint32_t value2;
+
+    using members = proto::Members<&OptionalInt::value1, &OptionalInt::value2>;
+
+    constexpr auto operator<=>(const OptionalInt &) const = default;
+};
+
+// Sparse message that maintains its own presence bitmap
+struct SparseStatus {
+    std::uint64_t id{};
+    std::uint32_t code{};
+    double load{};
+    std::int64_t delta{};
+
+    using members =
+        proto::Members<&SparseStatus::id, &SparseStatus::code,
+                       &SparseStatus::load, &SparseStatus::delta>;
+
+    void set_code(std::uint32_t value) {
+        code = value;
+        has_bits.set(1);
+    }
+
+    std::bitset<members::s_num_elems> presence() const { return has_bits; }
+
+    std::bitset<members::s_num_elems> has_bits;
+};
+
+// Message carrying a potentially large opaque payload
+struct Upload {
+    std::uint64_t id;
+    std::vector<std::byte> payload;
+    std::uint32_t checksum;
+
+    using members =
+        proto::Members<&Upload::id, &Upload::payload, &Upload::checksum>;
+
+    auto operator<=>(const Upload &) const = default;
+};
+
+// Text-heavy message
+struct Document {
+    std::uint32_t id;
+    std::string title;
+    std::string_view body;
+    std::string raw;
+
+    using members = proto::Members<&Document::id, &Document::title,
+                                   &Document::body, &Document::raw>;
+    static constexpr std::array member_names{"id", "title", "body", "raw"};
+
+    auto operator<=>(const Document &) const = default;
+};
+
+// Message with map fields in standard and flat containers
+struct RoutingTable {
+    std::uint32_t version;
+    std::map<std::string, std::uint32_t> routes;
+    std::unordered_map<std::uint64_t, std::string> names;
+    proto::FlatMap<std::int32_t, double> weights;
+
+    using members =
+        proto::Members<&RoutingTable::version, &RoutingTable::routes,
+                       &RoutingTable::names, &RoutingTable::weights>;
+
+    bool operator==(const RoutingTable &) const = default;
+};
+
+// Message with a run of fixed-width members between two varints
+struct Telemetry {
+    std::uint64_t id;
+    double latitude;
+    double longitude;
+    float altitude;
+    std::int32_t heading;
+    std::uint32_t flags;
+
+    using members = proto::Members<&Telemetry::id, &Telemetry::latitude,
+                                   &Telemetry::longitude, &Telemetry::altitude,
+                                   &Telemetry::heading, &Telemetry::flags>;
+
+    auto operator<=>(const Telemetry &) const = default;
+};
+
+// Telemetry with fused codecs disabled
+struct TelemetryPerMember {
+    std::uint64_t id;
+    double latitude;
+    double longitude;
+    float altitude;
+    std::int32_t heading;
+    std::uint32_t flags;
+
+    using members =
+        proto::Members<&TelemetryPerMember::id, &TelemetryPerMember::latitude,
+                       &TelemetryPerMember::longitude,
+                       &TelemetryPerMember::altitude,
+                       &TelemetryPerMember::heading,
+                       &TelemetryPerMember::flags>;
+
+    auto operator<=>(const TelemetryPerMember &) const = default;
+};
+
+// Event with short, often repeated text and bytes held as views
+struct Event {
+    std::string_view host;
+    std::string_view metric;
+    double value;
+    std::optional<std::span<const std::byte>> tag;
+
+    using members = proto::Members<&Event::host, &Event::metric,
+                                   &Event::value, &Event::tag>;
+};
+
 } // namespace test
 
 namespace proto {
@@ -54,4 +185,20 @@ template <> struct MemberEncoding<&test::IntAndFloat_asFixed::value2> {
     using type = Fixint32;
 };
 
+// Skip UTF-8 validation for Document::raw
+template <> struct ValidateUtf8<&test::Document::raw> : std::false_type {};
+
+template <> struct MemberEncoding<&test::Telemetry::heading> {
+    using type = Fixint32;
+};
+template <> struct MemberEncoding<&test::TelemetryPerMember::heading> {
+    using type = Fixint32;
+};
+template <>
+struct FuseFixedWidthMembers<test::TelemetryPerMember> : std::false_type {};
+
+// Write RoutingTable::names in key order
+template <>
+struct DeterministicMap<&test::RoutingTable::names> : std::true_type {};
+
 } // namespace proto
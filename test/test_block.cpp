@@ -0,0 +1,241 @@
+#include "TestTypes.h"
+
+#include <protobuf-cpp/Block.h>
+#include <protobuf-cpp/Crc32c.h>
+#include <protobuf-cpp/Fixint.h>
+#include <protobuf-cpp/Framing.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+std::vector<test::DoubleInt> make_messages(std::size_t count) {
+    std::vector<test::DoubleInt> messages;
+    for (std::size_t i = 0; i < count; i++) {
+        messages.push_back(test::DoubleInt{static_cast<std::uint32_t>(i),
+                                           static_cast<std::int32_t>(i % 7)});
+    }
+    return messages;
+}
+
+// Read the whole of `file` back and close it
+std::vector<std::byte> read_and_close(std::FILE *file) {
+    std::vector<std::byte> contents(
+        static_cast<std::size_t>(std::ftell(file)));
+    std::rewind(file);
+    if (std::fread(contents.data(), 1, contents.size(), file) !=
+        contents.size()) {
+        throw std::runtime_error("fread failed");
+    }
+    std::fclose(file);
+    return contents;
+}
+
+// Write `messages` as a block file and read the whole file back
+std::vector<std::byte>
+write_block_file(const std::vector<test::DoubleInt> &messages,
+                 proto::BlockCodec codec, std::size_t block_size) {
+    std::FILE *file = std::tmpfile();
+    if (file == nullptr) {
+        throw std::runtime_error("tmpfile failed");
+    }
+    proto::BlockWriter writer(::fileno(file), codec, block_size);
+    for (const auto &message : messages) {
+        writer.write(message);
+    }
+    writer.finish();
+    return read_and_close(file);
+}
+
+// Append an index of `blocks` and the trailer to the blocks in `file`
+void append_block_index(std::vector<std::byte> &file,
+                        const std::vector<proto::BlockInfo> &blocks) {
+    const auto index_offset = file.size();
+    for (const auto &info : blocks) {
+        proto::serialize_delimited(info, file);
+    }
+    file.resize(file.size() + proto::k_block_trailer_size);
+    auto trailer = std::span{file}.last(proto::k_block_trailer_size);
+    proto::Fixint64{index_offset}.serialize(trailer);
+    proto::Fixint32{proto::k_block_file_magic}.serialize(trailer.subspan(8));
+}
+} // namespace
+
+// decode_blocks rejects views into its decompression buffers
+static_assert(!proto::has_view_members<test::DoubleInt>());
+static_assert(proto::has_view_members<test::Event>());
+
+TEST(Block, roundtrip_across_blocks) {
+    const auto messages = make_messages(10'000);
+    for (auto codec : {proto::BlockCodec::Stored, proto::BlockCodec::Lz4,
+                       proto::BlockCodec::Zstd}) {
+        if (!proto::is_available(codec)) {
+            continue;
+        }
+        const auto contents = write_block_file(messages, codec, 1024);
+        const proto::BlockFile file{contents};
+        ASSERT_GT(file.num_blocks(), 1);
+        ASSERT_EQ(file.num_messages(), messages.size());
+
+        ASSERT_EQ(proto::decode_blocks<test::DoubleInt>(file, 1), messages);
+        ASSERT_EQ(proto::decode_blocks<test::DoubleInt>(file, 4), messages);
+    }
+}
+
+TEST(Block, compressible_blocks_shrink) {
+    if (proto::default_block_codec() == proto::BlockCodec::Stored) {
+        GTEST_SKIP() << "Built without a compression codec";
+    }
+    const auto messages = make_messages(10'000);
+    const auto compressed = write_block_file(
+        messages, proto::default_block_codec(),
+        proto::BlockWriter::k_default_block_size);
+    const auto stored =
+        write_block_file(messages, proto::BlockCodec::Stored,
+                         proto::BlockWriter::k_default_block_size);
+    ASSERT_LT(compressed.size(), stored.size());
+}
+
+TEST(Block, seek_to_message) {
+    const auto messages = make_messages(5000);
+    const auto contents =
+        write_block_file(messages, proto::default_block_codec(), 512);
+    const proto::BlockFile file{contents};
+
+    const auto index = file.find_block(4321);
+    const auto &info = file.block(index);
+    ASSERT_LE(info.first_message, 4321);
+    ASSERT_GT(info.first_message + info.num_messages, 4321);
+
+    std::vector<test::DoubleInt> block(info.num_messages);
+    std::vector<std::byte> scratch;
+    proto::decode_block(file, index, std::span{block}, scratch);
+    ASSERT_EQ(block[4321 - info.first_message], messages[4321]);
+
+    ASSERT_EQ(file.find_block(0), 0);
+    ASSERT_EQ(file.find_block(4999), file.num_blocks() - 1);
+    ASSERT_THROW((void)file.find_block(5000), std::out_of_range);
+}
+
+TEST(Block, empty_file) {
+    const auto contents =
+        write_block_file({}, proto::BlockCodec::Stored, 1024);
+    ASSERT_EQ(contents.size(), proto::k_block_trailer_size);
+    const proto::BlockFile file{contents};
+    ASSERT_EQ(file.num_blocks(), 0);
+    ASSERT_TRUE(proto::decode_blocks<test::DoubleInt>(file).empty());
+}
+
+TEST(Block, corruption_is_detected) {
+    auto contents =
+        write_block_file(make_messages(1000), proto::BlockCodec::Stored, 256);
+
+    auto corrupt_block = contents;
+    corrupt_block[proto::k_block_header_size + 3] ^= std::byte{0x01};
+    const proto::BlockFile file{corrupt_block};
+    ASSERT_THROW((void)proto::decode_blocks<test::DoubleInt>(file),
+                 std::runtime_error);
+
+    auto bad_magic = contents;
+    bad_magic.back() ^= std::byte{0x01};
+    ASSERT_THROW(proto::BlockFile{bad_magic}, std::runtime_error);
+
+    auto truncated = std::span{contents}.subspan(1);
+    ASSERT_THROW(proto::BlockFile{truncated}, std::runtime_error);
+}
+
+TEST(Block, untrusted_sizes_are_rejected) {
+    const std::vector<std::byte> frames(10, std::byte{0});
+    std::vector<std::byte> block;
+    proto::append_block(frames, proto::BlockCodec::Stored, block);
+
+    // A stored block announcing 4 GiB of data fails without allocating it
+    auto oversized = block;
+    std::fill_n(oversized.begin() + 1, 4, std::byte{0xff});
+    std::vector<std::byte> out;
+    ASSERT_THROW((void)proto::decompress_block(oversized, out),
+                 std::runtime_error);
+    ASSERT_EQ(out.capacity(), 0);
+
+    // An index claiming more messages than the block has bytes
+    auto file = block;
+    append_block_index(file, {{0, block.size(), 0, 1'000'000'000}});
+    ASSERT_THROW(proto::BlockFile{file}, std::runtime_error);
+
+    // An index entry whose offset is sent as an empty LEN field
+    file = block;
+    const auto index_offset = file.size();
+    file.insert(file.end(), {std::byte{2}, std::byte{0x0a}, std::byte{0}});
+    file.resize(file.size() + proto::k_block_trailer_size);
+    auto trailer = std::span{file}.last(proto::k_block_trailer_size);
+    proto::Fixint64{index_offset}.serialize(trailer);
+    proto::Fixint32{proto::k_block_file_magic}.serialize(trailer.subspan(8));
+    ASSERT_THROW(proto::BlockFile{file}, std::runtime_error);
+}
+
+TEST(Block, crafted_index_does_not_size_the_output) {
+    // Empty compressed blocks claiming the largest uncompressed size, and
+    // as many messages as that would allow
+    std::vector<std::byte> header(proto::k_block_header_size);
+    header[0] = static_cast<std::byte>(proto::BlockCodec::Zstd);
+    proto::Fixint32{static_cast<std::uint32_t>(proto::k_max_block_size)}
+        .serialize(std::span{header}.subspan(1));
+    proto::Fixint32{0}.serialize(std::span{header}.subspan(5));
+    proto::Fixint32{proto::crc32c({})}.serialize(std::span{header}.subspan(9));
+
+    std::vector<std::byte> file;
+    std::vector<proto::BlockInfo> blocks;
+    for (std::uint64_t i = 0; i < 20; i++) {
+        blocks.push_back({file.size(), header.size(),
+                          i * proto::k_max_block_size,
+                          static_cast<std::uint32_t>(proto::k_max_block_size)});
+        file.insert(file.end(), header.begin(), header.end());
+    }
+    append_block_index(file, blocks);
+
+    const proto::BlockFile block_file{file};
+    ASSERT_EQ(block_file.num_messages(), 20 * proto::k_max_block_size);
+    ASSERT_THROW((void)proto::decode_blocks<test::DoubleInt>(block_file, 1),
+                 std::runtime_error);
+}
+
+TEST(Block, oversized_message_leaves_writer_usable) {
+    std::FILE *file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    proto::BlockWriter writer(::fileno(file), proto::BlockCodec::Stored, 1024);
+    writer.write(test::Upload{1, {}, 0});
+
+    const test::Upload oversized{
+        2, std::vector<std::byte>(proto::k_max_block_size), 0};
+    ASSERT_THROW(writer.write(oversized), std::runtime_error);
+    ASSERT_EQ(writer.num_messages(), 1);
+
+    writer.write(test::Upload{3, {}, 0});
+    writer.finish();
+    const auto contents = read_and_close(file);
+    const std::vector<test::Upload> expected{{1, {}, 0}, {3, {}, 0}};
+    ASSERT_EQ(proto::decode_blocks<test::Upload>(proto::BlockFile{contents}),
+              expected);
+
+    ASSERT_THROW(proto::BlockWriter(STDOUT_FILENO, proto::BlockCodec::Stored,
+                                    proto::k_max_block_size + 1),
+                 std::logic_error);
+}
+
+TEST(Block, unavailable_codec_throws) {
+    for (auto codec : {proto::BlockCodec::Lz4, proto::BlockCodec::Zstd}) {
+        if (!proto::is_available(codec)) {
+            ASSERT_THROW(proto::BlockWriter(STDOUT_FILENO, codec),
+                         std::logic_error);
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#include "TestTypes.h"
+
+#include <protobuf-cpp/BufferPool.h>
+#include <protobuf-cpp/Deserialize.h>
+#include <protobuf-cpp/Serialize.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <utility>
+
+TEST(BufferPool, acquire_returns_requested_size) {
+    auto &pool = proto::BufferPool::local();
+    auto buffer = pool.acquire(100);
+    ASSERT_EQ(buffer.size(), 100);
+    ASSERT_NE(buffer.data(), nullptr);
+    std::ranges::fill(buffer, std::byte{0xab});
+}
+
+TEST(BufferPool, released_buffer_is_reused_on_same_thread) {
+    auto &pool = proto::BufferPool::local();
+    const std::byte *first_data = nullptr;
+    {
+        auto buffer = pool.acquire(100);
+        first_data = buffer.data();
+    }
+    const auto cached = pool.cached_buffers();
+    ASSERT_GE(cached, 1);
+
+    // Same size class (65..128 bytes) should hand back the same block
+    auto buffer = pool.acquire(128);
+    ASSERT_EQ(buffer.data(), first_data);
+    ASSERT_EQ(pool.cached_buffers(), cached - 1);
+}
+
+TEST(BufferPool, oversized_buffers_are_not_cached) {
+    auto &pool = proto::BufferPool::local();
+    const auto cached = pool.cached_buffers();
+    {
+        auto buffer = pool.acquire(proto::BufferPool::k_max_pooled_size + 1);
+        ASSERT_EQ(buffer.size(), proto::BufferPool::k_max_pooled_size + 1);
+    }
+    ASSERT_EQ(pool.cached_buffers(), cached);
+}
+
+TEST(BufferPool, moved_from_handle_is_empty) {
+    auto buffer = proto::BufferPool::local().acquire(10);
+    auto moved = std::move(buffer);
+    ASSERT_TRUE(buffer.empty());
+    ASSERT_EQ(buffer.data(), nullptr);
+    ASSERT_EQ(moved.size(), 10);
+}
+
+TEST(BufferPool, buffer_released_on_other_thread_returns_to_owner) {
+    auto &pool = proto::BufferPool::local();
+    auto buffer = pool.acquire(3000);
+    const std::byte *data = buffer.data();
+
+    std::thread([b = std::move(buffer)]() mutable { b.reset(); }).join();
+
+    // The block sits on the owner's remote list until the next miss
+    auto reacquired = pool.acquire(3000);
+    ASSERT_EQ(reacquired.data(), data);
+}
+
+TEST(BufferPool, buffer_may_outlive_owning_thread) {
+    proto::PooledBuffer buffer;
+    std::thread([&buffer] {
+        buffer = proto::BufferPool::local().acquire(42);
+        std::ranges::fill(buffer, std::byte{1});
+    }).join();
+
+    ASSERT_EQ(buffer.size(), 42);
+    ASSERT_TRUE(std::ranges::all_of(
+        buffer, [](std::byte b) { return b == std::byte{1}; }));
+    buffer.reset();
+}
+
+TEST(BufferPool, serialize_into_pooled_buffer) {
+    constexpr test::DoubleInt original{42, -150};
+
+    auto pooled = proto::serialize(original, proto::BufferPool::local());
+    ASSERT_TRUE(std::ranges::equal(pooled, proto::serialize(original)));
+    ASSERT_EQ(proto::deserialize<test::DoubleInt>(pooled.span()), original);
+}
@@ -0,0 +1,181 @@
+#include "TestTypes.h"
+
+#include <protobuf-cpp/Columnar.h>
+#include <protobuf-cpp/Deserialize.h>
+#include <protobuf-cpp/Packed.h>
+#include <protobuf-cpp/Tokenizer.h>
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+namespace {
+std::vector<test::IntAndFloat_asFixed> make_records(std::size_t count) {
+    std::vector<test::IntAndFloat_asFixed> records;
+    for (std::size_t i = 0; i < count; i++) {
+        records.push_back({static_cast<std::int32_t>(i) - 50,
+                           static_cast<float>(i) * 0.25f});
+    }
+    return records;
+}
+} // namespace
+
+TEST(Columnar, packed_varint_layout) {
+    const std::vector<std::uint32_t> values = {3, 270, 86942};
+    std::vector<std::byte> buffer(16);
+    auto num_bytes_written = proto::serialize_packed<proto::Varint>(
+        proto::Field{4}, values, buffer);
+
+    // Example from the protobuf encoding guide
+    const std::vector<std::byte> expected = {
+        std::byte{0x22}, std::byte{0x06}, std::byte{0x03}, std::byte{0x8e},
+        std::byte{0x02}, std::byte{0x9e}, std::byte{0xa7}, std::byte{0x05}};
+    ASSERT_EQ(num_bytes_written, expected.size());
+    buffer.resize(num_bytes_written);
+    ASSERT_EQ(buffer, expected);
+    ASSERT_EQ(proto::packed_size<proto::Varint>(proto::Field{4}, values),
+              expected.size());
+    ASSERT_EQ(proto::packed_count<proto::Varint>(
+                  std::span{expected}.subspan(2)),
+              3);
+}
+
+TEST(Columnar, roundtrip_array_of_structs) {
+    const auto records = make_records(1000);
+
+    auto serialized = proto::serialize_columnar(std::span{records});
+    ASSERT_EQ(serialized.size(),
+              proto::serialized_columnar_size(std::span{records}));
+
+    auto decoded = proto::deserialize_columnar<test::IntAndFloat_asFixed>(
+        serialized);
+    ASSERT_EQ(decoded, records);
+}
+
+TEST(Columnar, roundtrip_struct_of_arrays) {
+    const auto records = make_records(100);
+    auto serialized = proto::serialize_columnar(std::span{records});
+
+    auto columns =
+        proto::deserialize_columns<test::IntAndFloat_asFixed>(serialized);
+    const auto &ints = std::get<0>(columns);
+    const auto &floats = std::get<1>(columns);
+    ASSERT_EQ(ints.size(), records.size());
+    ASSERT_EQ(floats.size(), records.size());
+    for (std::size_t i = 0; i < records.size(); i++) {
+        ASSERT_EQ(ints[i], records[i].value1);
+        ASSERT_EQ(floats[i], records[i].value2);
+    }
+}
+
+TEST(Columnar, columns_are_repeated_fields) {
+    const std::vector<test::DoubleInt> records = {{1, -1}, {2, -2}};
+    auto serialized = proto::serialize_columnar(std::span{records});
+
+    // Splitting a column across two fields is equivalent, as repeated
+    // fields concatenate
+    std::vector<std::byte> split(64);
+    std::size_t size = 0;
+    const std::vector<std::uint32_t> first = {1};
+    const std::vector<std::uint32_t> second = {2};
+    const std::vector<std::int32_t> column2 = {-1, -2};
+    size += proto::serialize_packed<proto::Varint>(
+        proto::Field{1}, first, std::span{split}.subspan(size));
+    size += proto::serialize_packed<proto::Varint>(
+        proto::Field{2}, column2, std::span{split}.subspan(size));
+    size += proto::serialize_packed<proto::Varint>(
+        proto::Field{1}, second, std::span{split}.subspan(size));
+    split.resize(size);
+
+    ASSERT_EQ(proto::deserialize_columnar<test::DoubleInt>(split), records);
+    ASSERT_EQ(proto::deserialize_columnar<test::DoubleInt>(serialized),
+              records);
+}
+
+TEST(Columnar, empty_batch) {
+    const std::vector<test::DoubleInt> records;
+    auto serialized = proto::serialize_columnar(std::span{records});
+    ASSERT_TRUE(serialized.empty());
+    ASSERT_TRUE(proto::deserialize_columnar<test::DoubleInt>(serialized)
+                    .empty());
+}
+
+TEST(Columnar, mismatched_column_lengths) {
+    std::vector<std::byte> buffer(64);
+    std::size_t size = 0;
+    const std::vector<std::uint32_t> two = {1, 2};
+    const std::vector<std::int32_t> one = {1};
+    size += proto::serialize_packed<proto::Varint>(
+        proto::Field{1}, two, std::span{buffer}.subspan(size));
+    size += proto::serialize_packed<proto::Varint>(
+        proto::Field{2}, one, std::span{buffer}.subspan(size));
+    buffer.resize(size);
+
+    ASSERT_THROW(proto::deserialize_columnar<test::DoubleInt>(buffer),
+                 std::runtime_error);
+}
+
+TEST(Columnar, parallel_packed_matches_sequential) {
+    std::vector<std::int64_t> values;
+    for (std::int64_t i = 0; i < 200'000; i++) {
+        values.push_back((i % 7 == 0 ? -i : i) * (i % 1000));
+    }
+
+    const auto expected_size =
+        proto::packed_size<proto::Varint>(proto::Field{3}, values);
+    std::vector<std::byte> expected(expected_size);
+    proto::serialize_packed<proto::Varint>(proto::Field{3}, values,
+                                           std::span{expected});
+
+    for (std::size_t num_threads : {1, 3, 8}) {
+        auto serialized = proto::serialize_packed_parallel<proto::Varint>(
+            proto::Field{3}, values, num_threads);
+        ASSERT_EQ(serialized, expected) << num_threads;
+
+        std::vector<std::byte> buffer(expected_size);
+        ASSERT_EQ(proto::serialize_packed_parallel<proto::Varint>(
+                      proto::Field{3}, values, std::span{buffer}, num_threads),
+                  expected_size);
+        ASSERT_EQ(buffer, expected);
+
+        const auto payload = proto::read_field(expected).value.payload;
+        ASSERT_EQ((proto::decode_packed_parallel<proto::Varint, std::int64_t>(
+                      payload, num_threads)),
+                  values);
+    }
+
+    std::vector<std::byte> too_small(expected_size - 1);
+    ASSERT_THROW(proto::serialize_packed_parallel<proto::Varint>(
+                     proto::Field{3}, values, std::span{too_small}, 4),
+                 std::runtime_error);
+}
+
+TEST(Columnar, parallel_packed_fixed_width) {
+    std::vector<float> values;
+    for (int i = 0; i < 100'000; i++) {
+        values.push_back(static_cast<float>(i) * 0.5f);
+    }
+    auto serialized = proto::serialize_packed_parallel<proto::Fixint32>(
+        proto::Field{1}, values, 4);
+    ASSERT_EQ(serialized.size(),
+              proto::packed_size<proto::Fixint32>(proto::Field{1}, values));
+
+    const auto payload = proto::read_field(serialized).value.payload;
+    std::vector<float> decoded(values.size());
+    proto::decode_packed_parallel<proto::Fixint32>(payload,
+                                                   std::span{decoded}, 4);
+    ASSERT_EQ(decoded, values);
+
+    std::vector<float> wrong_size(values.size() - 1);
+    ASSERT_THROW(proto::decode_packed_parallel<proto::Fixint32>(
+                     payload, std::span{wrong_size}, 4),
+                 std::runtime_error);
+    ASSERT_THROW((proto::decode_packed_parallel<proto::Fixint32, float>(
+                     payload.first(payload.size() - 1), 4)),
+                 std::runtime_error);
+}
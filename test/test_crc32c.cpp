@@ -0,0 +1,70 @@
+#include <protobuf-cpp/Crc32c.h>
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+std::span<const std::byte> bytes(std::string_view text) {
+    return std::as_bytes(std::span{text.data(), text.size()});
+}
+
+std::vector<std::byte> random_bytes(std::size_t size, unsigned seed) {
+    std::mt19937 rng{seed};
+    std::vector<std::byte> data(size);
+    for (auto &byte : data) {
+        byte = static_cast<std::byte>(rng());
+    }
+    return data;
+}
+
+} // namespace
+
+TEST(Crc32c, known_values) {
+    // Check values from RFC 3720 (iSCSI), appendix B.4
+    const std::vector<std::byte> zeros(32, std::byte{0});
+    const std::vector<std::byte> ones(32, std::byte{0xff});
+    std::vector<std::byte> incrementing(32);
+    for (std::size_t i = 0; i < incrementing.size(); i++) {
+        incrementing[i] = static_cast<std::byte>(i);
+    }
+
+    for (auto crc : {proto::crc32c, proto::crc32c_portable}) {
+        EXPECT_EQ(crc(bytes("123456789"), 0), 0xe3069283);
+        EXPECT_EQ(crc(zeros, 0), 0x8a9136aa);
+        EXPECT_EQ(crc(ones, 0), 0x62a8ab43);
+        EXPECT_EQ(crc(incrementing, 0), 0x46dd794e);
+        EXPECT_EQ(crc({}, 0), 0);
+    }
+}
+
+TEST(Crc32c, hardware_matches_portable) {
+    // Cover the three-stream path, its remainder and unaligned starts
+    for (std::size_t size : {1, 7, 8, 63, 3071, 3072, 3073, 10'000, 100'003}) {
+        const auto data = random_bytes(size + 3, static_cast<unsigned>(size));
+        for (std::size_t offset = 0; offset < 3; offset++) {
+            auto piece = std::span{data}.subspan(offset, size);
+            ASSERT_EQ(proto::crc32c(piece), proto::crc32c_portable(piece))
+                << size << " " << offset;
+        }
+    }
+}
+
+TEST(Crc32c, incremental) {
+    const auto data = random_bytes(20'000, 7);
+    const auto whole = proto::crc32c(data);
+    for (std::size_t split : {0, 1, 100, 3072, 9999, 20'000}) {
+        auto first = std::span{data}.first(split);
+        auto second = std::span{data}.subspan(split);
+        ASSERT_EQ(proto::crc32c(second, proto::crc32c(first)), whole);
+        ASSERT_EQ(proto::crc32c_portable(second,
+                                         proto::crc32c_portable(first)),
+                  whole);
+    }
+}
@@ -0,0 +1,97 @@
+#include "TestTypes.h"
+
+#include <protobuf-cpp/Delta.h>
+#include <protobuf-cpp/Deserialize.h>
+#include <protobuf-cpp/Serialize.h>
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+
+namespace {
+struct OptionalRoutes {
+    std::optional<std::map<std::uint32_t, std::uint32_t>> routes;
+    using members = proto::Members<&OptionalRoutes::routes>;
+};
+} // namespace
+
+// Removed map entries and optionals reset to std::nullopt cannot be
+// expressed by a merge
+static_assert(proto::DeltaEncodable<test::DoubleInt>);
+static_assert(!proto::DeltaEncodable<test::RoutingTable>);
+static_assert(!proto::DeltaEncodable<test::OptionalInt>);
+static_assert(proto::has_map_members<OptionalRoutes>());
+static_assert(!proto::DeltaEncodable<OptionalRoutes>);
+
+TEST(Delta, merge_overwrites_only_present_fields) {
+    test::DoubleInt obj{1, 2};
+    proto::merge(proto::serialize(test::DoubleInt{0, 5}), obj);
+    ASSERT_EQ(obj, (test::DoubleInt{1, 5}));
+}
+
+TEST(Delta, changed_members) {
+    auto changed = proto::changed_members(test::DoubleInt{1, 2},
+                                          test::DoubleInt{1, 3});
+    ASSERT_FALSE(changed[0]);
+    ASSERT_TRUE(changed[1]);
+}
+
+TEST(Delta, delta_contains_only_changes) {
+    const test::IntAndFloat_asFixed before{7, 1.5f};
+    const test::IntAndFloat_asFixed after{7, 2.5f};
+
+    auto delta = proto::serialize_delta(before, after);
+    // Key plus four byte float
+    ASSERT_EQ(delta.size(), 5);
+
+    auto state = before;
+    proto::apply_delta(delta, state);
+    ASSERT_EQ(state, after);
+}
+
+TEST(Delta, change_to_default_is_sent) {
+    const test::DoubleInt before{42, -3};
+    const test::DoubleInt after{0, -3};
+
+    auto delta = proto::serialize_delta(before, after);
+    ASSERT_EQ(delta.size(), 2);
+
+    auto state = before;
+    proto::apply_delta(delta, state);
+    ASSERT_EQ(state, after);
+}
+
+TEST(Delta, unchanged_object_has_empty_delta) {
+    const test::DoubleInt obj{42, -3};
+    ASSERT_TRUE(proto::serialize_delta(obj, obj).empty());
+}
+
+TEST(Delta, tracked_object_sends_dirty_members) {
+    proto::Tracked<test::DoubleInt> tracked{test::DoubleInt{1, 2}};
+    test::DoubleInt replica{1, 2};
+
+    tracked.set<&test::DoubleInt::value2>(0);
+    ASSERT_TRUE(tracked.dirty()[1]);
+    ASSERT_FALSE(tracked.dirty()[0]);
+
+    auto delta = tracked.take_delta();
+    ASSERT_EQ(delta.size(), 2);
+    ASSERT_TRUE(tracked.dirty().none());
+    proto::apply_delta(delta, replica);
+    ASSERT_EQ(replica, tracked.get());
+
+    tracked.mutate<&test::DoubleInt::value1>() += 10;
+    proto::apply_delta(tracked.take_delta(), replica);
+    ASSERT_EQ(replica, (test::DoubleInt{11, 0}));
+
+    // Nothing changed since the last delta
+    ASSERT_TRUE(tracked.take_delta().empty());
+
+    tracked.mark_all_dirty();
+    test::DoubleInt fresh{};
+    proto::apply_delta(tracked.take_delta(), fresh);
+    ASSERT_EQ(fresh, tracked.get());
+}
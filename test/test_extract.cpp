@@ -0,0 +1,120 @@
+#include "TestTypes.h"
+
+#include <protobuf-cpp/Extract.h>
+#include <protobuf-cpp/Framing.h>
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+std::vector<std::byte> make_batch(std::size_t count) {
+    std::vector<std::byte> frames;
+    for (std::size_t i = 0; i < count; i++) {
+        proto::serialize_delimited(
+            test::IntAndFloat_asFixed{-static_cast<std::int32_t>(i),
+                                      static_cast<float>(i) / 2},
+            frames);
+    }
+    return frames;
+}
+} // namespace
+
+TEST(Extract, extract_field_by_number) {
+    auto frames = make_batch(1000);
+
+    auto ints = proto::extract_field<proto::Field{1}, std::int32_t>(frames);
+    auto floats = proto::extract_field<proto::Field{2}, float>(frames);
+
+    ASSERT_EQ(ints.size(), 1000);
+    ASSERT_EQ(floats.size(), 1000);
+    for (std::size_t i = 0; i < ints.size(); i++) {
+        ASSERT_EQ(ints[i], -static_cast<std::int32_t>(i));
+        ASSERT_EQ(floats[i], static_cast<float>(i) / 2);
+    }
+}
+
+TEST(Extract, extract_member_uses_member_encoding) {
+    std::vector<std::byte> frames;
+    for (std::uint32_t i = 0; i < 10; i++) {
+        proto::serialize_delimited(test::SingleInt_asFixed{i * 3}, frames);
+    }
+
+    auto values =
+        proto::extract_member<&test::SingleInt_asFixed::value>(frames);
+    ASSERT_EQ(values.size(), 10);
+    for (std::uint32_t i = 0; i < 10; i++) {
+        ASSERT_EQ(values[i], i * 3);
+    }
+}
+
+TEST(Extract, parallel_matches_sequential) {
+    auto frames = make_batch(10'007);
+
+    auto sequential =
+        proto::extract_member<&test::IntAndFloat_asFixed::value1>(frames);
+    auto parallel =
+        proto::extract_member<&test::IntAndFloat_asFixed::value1>(frames, 4);
+    ASSERT_EQ(parallel, sequential);
+}
+
+TEST(Extract, absent_field_is_default) {
+    auto frames = make_batch(3);
+    auto missing = proto::extract_field<proto::Field{7}, std::uint64_t>(frames);
+    ASSERT_EQ(missing, (std::vector<std::uint64_t>{0, 0, 0}));
+}
+
+TEST(Extract, errors) {
+    auto frames = make_batch(4);
+
+    // Field 2 is FIXED32 on the wire
+    ASSERT_THROW((proto::extract_field<proto::Field{2}, std::int32_t>(frames)),
+                 std::runtime_error);
+    ASSERT_THROW(
+        (proto::extract_field<proto::Field{2}, std::int32_t>(frames, 2)),
+        std::runtime_error);
+
+    frames.pop_back();
+    ASSERT_THROW((proto::extract_field<proto::Field{1}, std::int32_t>(frames)),
+                 std::runtime_error);
+}
+
+TEST(Extract, extract_member_honours_utf8_validation) {
+    std::vector<std::byte> frames;
+    proto::serialize_delimited(test::Document{1, "ok", "", "a\xff"}, frames);
+    proto::serialize_delimited(test::Document{2, "\xc0\x80", "", "b"}, frames);
+
+    // raw skips UTF-8 checks, as deserialize<test::Document> does
+    auto raw = proto::extract_member<&test::Document::raw>(frames);
+    ASSERT_EQ(raw, (std::vector<std::string>{"a\xff", "b"}));
+
+    ASSERT_THROW((void)proto::extract_member<&test::Document::title>(frames),
+                 std::runtime_error);
+}
+
+TEST(Extract, extract_optional_member) {
+    std::vector<std::byte> frames;
+    proto::serialize_delimited(test::OptionalInt{-4, 1}, frames);
+    proto::serialize_delimited(test::OptionalInt{std::nullopt, 2}, frames);
+
+    // Absent values extract as the value type's default
+    auto values = proto::extract_member<&test::OptionalInt::value1>(frames);
+    ASSERT_EQ(values, (std::vector<std::int32_t>{-4, 0}));
+}
+
+TEST(Extract, varints_are_bounded_by_type) {
+    // Six-byte varint for a 32-bit field, which deserialize rejects
+    const std::vector<std::byte> too_long{
+        std::byte{0x07}, std::byte{0x08}, std::byte{0x80}, std::byte{0x80},
+        std::byte{0x80}, std::byte{0x80}, std::byte{0x80}, std::byte{0x01}};
+    ASSERT_THROW(
+        (void)proto::extract_member<&test::DoubleInt::value1>(too_long),
+        std::runtime_error);
+    ASSERT_EQ((proto::extract_field<proto::Field{1}, std::uint64_t>(too_long)),
+              (std::vector<std::uint64_t>{std::uint64_t{1} << 35}));
+}
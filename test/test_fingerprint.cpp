@@ -0,0 +1,71 @@
+#include "TestTypes.h"
+
+#include <protobuf-cpp/Fingerprint.h>
+#include <protobuf-cpp/Serialize.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+std::span<const std::byte> bytes(std::string_view text) {
+    return std::as_bytes(std::span{text.data(), text.size()});
+}
+} // namespace
+
+TEST(Fingerprint, matches_xxh64) {
+    ASSERT_EQ(proto::fingerprint(bytes("")), 0xef46db3751d8e999ULL);
+    ASSERT_EQ(proto::fingerprint(bytes("a")), 0xd24ec4f1a98c6e5bULL);
+    ASSERT_EQ(proto::fingerprint(bytes("abc")), 0x44bc2cf5ad770999ULL);
+    ASSERT_EQ(proto::fingerprint(
+                  bytes("Nobody inspects the spammish repetition")),
+              0xfbcea83c8a378bf1ULL);
+    ASSERT_NE(proto::fingerprint(bytes("abc"), 1),
+              proto::fingerprint(bytes("abc")));
+}
+
+TEST(Fingerprint, incremental_matches_one_shot) {
+    std::mt19937 rng{42};
+    std::vector<std::byte> data(1000);
+    for (auto &byte : data) {
+        byte = static_cast<std::byte>(rng());
+    }
+
+    for (std::size_t piece_size : {1, 7, 31, 32, 33, 100, 1000}) {
+        proto::Fingerprinter fingerprinter{5};
+        for (std::size_t offset = 0; offset < data.size();
+             offset += piece_size) {
+            fingerprinter.update(std::span{data}.subspan(
+                offset, std::min(piece_size, data.size() - offset)));
+        }
+        ASSERT_EQ(fingerprinter.digest(), proto::fingerprint(data, 5))
+            << piece_size;
+    }
+}
+
+TEST(Fingerprint, fused_with_serialization) {
+    const test::Document small{1, "title", "body", ""};
+    const test::Document large{2, std::string(20'000, 't'), "body",
+                               std::string(5'000, 'r')};
+
+    for (const auto &document : {small, large}) {
+        std::vector<std::byte> buffer;
+        const auto fingerprint =
+            proto::serialize_fingerprinted(document, buffer, 9);
+        ASSERT_EQ(buffer, proto::serialize(document));
+        ASSERT_EQ(fingerprint, proto::fingerprint(buffer, 9));
+    }
+
+    std::vector<std::byte> too_small(4);
+    ASSERT_THROW((void)proto::serialize_fingerprinted(
+                     large, std::span<std::byte>{too_small}),
+                 std::runtime_error);
+}
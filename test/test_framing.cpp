@@ -0,0 +1,105 @@
+#include "TestTypes.h"
+
+#include <protobuf-cpp/Deserialize.h>
+#include <protobuf-cpp/Framing.h>
+#include <protobuf-cpp/Serialize.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+TEST(Framing, serialize_delimited_prefixes_length) {
+    constexpr test::DoubleInt original{42, -150};
+    const auto message = proto::serialize(original);
+
+    std::vector<std::byte> buffer;
+    proto::serialize_delimited(original, buffer);
+    ASSERT_EQ(buffer.size(), proto::serialized_delimited_size(original));
+    ASSERT_EQ(buffer[0], std::byte(message.size()));
+    ASSERT_TRUE(std::ranges::equal(std::span{buffer}.subspan(1), message));
+
+    auto frame = proto::read_frame(buffer);
+    ASSERT_EQ(frame.num_bytes_read, buffer.size());
+    ASSERT_EQ(proto::deserialize<test::DoubleInt>(frame.value), original);
+}
+
+TEST(Framing, split_back_to_back_frames) {
+    std::vector<std::byte> buffer;
+    for (std::uint32_t i = 0; i < 200; i++) {
+        proto::serialize_delimited(test::SingleInt{i}, buffer);
+    }
+    // An empty message is a valid, zero-length frame
+    std::vector<std::byte> empty_frame(1);
+    ASSERT_EQ(proto::write_frame({}, empty_frame), 1);
+    buffer.insert(buffer.end(), empty_frame.begin(), empty_frame.end());
+
+    auto frames = proto::split_frames(buffer);
+    ASSERT_EQ(frames.size(), 201);
+    for (std::uint32_t i = 0; i < 200; i++) {
+        ASSERT_EQ(proto::deserialize<test::SingleInt>(frames[i]).value, i);
+    }
+    ASSERT_TRUE(frames.back().empty());
+}
+
+TEST(Framing, partial_frame) {
+    std::vector<std::byte> buffer;
+    proto::serialize_delimited(test::DoubleInt{1, 2}, buffer);
+    buffer.pop_back();
+
+    ASSERT_EQ(proto::read_frame(buffer).num_bytes_read, 0);
+    ASSERT_THROW((void)proto::split_frames(buffer), std::runtime_error);
+
+    std::vector<std::byte> too_small(2);
+    ASSERT_THROW(proto::serialize_delimited(test::DoubleInt{1, 2},
+                                            std::span{too_small}),
+                 std::runtime_error);
+}
+
+TEST(Framing, checksummed_frames_roundtrip) {
+    constexpr test::DoubleInt original{42, -150};
+    const auto message = proto::serialize(original);
+
+    std::vector<std::byte> buffer;
+    proto::serialize_delimited(original, buffer,
+                               proto::FrameFormat::Checksummed);
+    ASSERT_EQ(buffer.size(),
+              proto::serialized_delimited_size(
+                  original, proto::FrameFormat::Checksummed));
+    ASSERT_EQ(buffer.size(), 1 + 4 + message.size());
+
+    auto frame = proto::read_checksummed_frame(buffer);
+    ASSERT_EQ(frame.num_bytes_read, buffer.size());
+    ASSERT_EQ(proto::deserialize<test::DoubleInt>(frame.value), original);
+
+    // Writing an already serialized message gives the same bytes
+    std::vector<std::byte> written(buffer.size());
+    ASSERT_EQ(proto::write_frame(message, written,
+                                 proto::FrameFormat::Checksummed),
+              buffer.size());
+    ASSERT_EQ(written, buffer);
+}
+
+TEST(Framing, checksummed_frames_detect_corruption) {
+    std::vector<std::byte> buffer;
+    for (std::uint32_t i = 0; i < 10; i++) {
+        proto::serialize_delimited(test::DoubleInt{i, 1000}, buffer,
+                                   proto::FrameFormat::Checksummed);
+    }
+    ASSERT_EQ(proto::split_frames(buffer, proto::FrameFormat::Checksummed)
+                  .size(),
+              10);
+
+    // Flip one bit in the payload of the last frame
+    buffer.back() ^= std::byte{0x10};
+    ASSERT_THROW(
+        (void)proto::split_frames(buffer, proto::FrameFormat::Checksummed),
+        std::runtime_error);
+    ASSERT_NO_THROW((void)proto::read_checksummed_frame(buffer));
+
+    // A corrupt length that runs past the end is a partial frame
+    buffer[0] = std::byte{0x7f};
+    ASSERT_EQ(proto::read_checksummed_frame(buffer).num_bytes_read, 0);
+}
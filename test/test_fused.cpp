@@ -0,0 +1,64 @@
+#include "TestTypes.h"
+
+#include <protobuf-cpp/Deserialize.h>
+#include <protobuf-cpp/Fused.h>
+#include <protobuf-cpp/Serialize.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+// latitude, longitude, altitude and heading form one run
+static_assert(proto::fused_run_end<test::Telemetry, 0>() == 0);
+static_assert(proto::fused_run_end<test::Telemetry, 1>() == 5);
+static_assert(proto::fused_run_end<test::Telemetry, 2>() == 0);
+static_assert(proto::FusedRun<test::Telemetry, 1, 5>::k_size == 28);
+static_assert(!proto::has_fused_runs<test::TelemetryPerMember>());
+static_assert(!proto::has_fused_runs<test::DoubleInt>());
+
+namespace {
+test::TelemetryPerMember per_member(const test::Telemetry &t) {
+    return {t.id,       t.latitude, t.longitude,
+            t.altitude, t.heading,  t.flags};
+}
+} // namespace
+
+TEST(Fused, matches_per_member_encoding) {
+    const test::Telemetry telemetry{7, 52.5, 13.4, 34.0f, -90, 3};
+    auto serialized = proto::serialize(telemetry);
+    ASSERT_EQ(serialized, proto::serialize(per_member(telemetry)));
+    ASSERT_EQ(serialized.size(), proto::serialized_size(telemetry));
+    ASSERT_EQ(proto::deserialize<test::Telemetry>(serialized), telemetry);
+
+    std::array<std::byte, 64> buffer{};
+    auto size = proto::serialize(telemetry, buffer);
+    ASSERT_TRUE(std::ranges::equal(std::span{buffer}.first(size), serialized));
+}
+
+TEST(Fused, partially_present_run_uses_per_member_path) {
+    // A zero altitude is not serialized, which breaks the run
+    const test::Telemetry telemetry{7, 52.5, 13.4, 0.0f, -90, 0};
+    auto serialized = proto::serialize(telemetry);
+    ASSERT_EQ(serialized, proto::serialize(per_member(telemetry)));
+    ASSERT_EQ(proto::deserialize<test::Telemetry>(serialized), telemetry);
+}
+
+TEST(Fused, reordered_fields_are_decoded) {
+    const test::Telemetry telemetry{7, 52.5, 13.4, 34.0f, -90, 3};
+    auto serialized = proto::serialize(telemetry);
+
+    // Move the id (key and value 7) after the run
+    std::ranges::rotate(serialized, serialized.begin() + 2);
+    ASSERT_EQ(proto::deserialize<test::Telemetry>(serialized), telemetry);
+
+    // Cut the run short
+    std::vector<std::byte> truncated(serialized.begin(),
+                                     serialized.begin() + 27);
+    ASSERT_THROW((void)proto::deserialize<test::Telemetry>(truncated),
+                 std::runtime_error);
+}
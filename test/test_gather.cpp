@@ -0,0 +1,106 @@
+#include "TestTypes.h"
+
+#include <protobuf-cpp/Deserialize.h>
+#include <protobuf-cpp/Gather.h>
+#include <protobuf-cpp/Serialize.h>
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace {
+
+test::Upload make_upload(std::size_t payload_size) {
+    test::Upload upload{42, std::vector<std::byte>(payload_size), 0xbeef};
+    for (std::size_t i = 0; i < payload_size; i++) {
+        upload.payload[i] = static_cast<std::byte>(i * 7);
+    }
+    return upload;
+}
+
+std::vector<std::byte> flatten(std::span<const iovec> segments) {
+    std::vector<std::byte> bytes;
+    for (const auto &segment : segments) {
+        auto *data = static_cast<const std::byte *>(segment.iov_base);
+        bytes.insert(bytes.end(), data, data + segment.iov_len);
+    }
+    return bytes;
+}
+
+} // namespace
+
+TEST(Gather, byte_member_roundtrip) {
+    auto upload = make_upload(100);
+    auto serialized = proto::serialize(upload);
+    ASSERT_EQ(serialized.size(), proto::serialized_size(upload));
+    ASSERT_EQ(proto::deserialize<test::Upload>(serialized), upload);
+}
+
+TEST(Gather, large_payload_is_referenced) {
+    auto upload = make_upload(1 << 20);
+    proto::GatherBuffer out;
+    proto::serialize_gather(upload, out);
+
+    auto segments = out.segments();
+    // Key and length of `payload` follow `id` in scratch, then the payload
+    // itself, then `checksum` back in scratch
+    ASSERT_EQ(segments.size(), 3);
+    ASSERT_EQ(segments[1].iov_base, upload.payload.data());
+    ASSERT_EQ(segments[1].iov_len, upload.payload.size());
+    ASSERT_EQ(out.size(), proto::serialized_size(upload));
+    ASSERT_EQ(flatten(segments), proto::serialize(upload));
+}
+
+TEST(Gather, small_payload_is_copied) {
+    auto upload = make_upload(100);
+    proto::GatherBuffer out;
+    proto::serialize_gather(upload, out);
+
+    ASSERT_EQ(out.segments().size(), 1);
+    ASSERT_EQ(flatten(out.segments()), proto::serialize(upload));
+}
+
+TEST(Gather, threshold_is_configurable) {
+    auto upload = make_upload(100);
+    proto::GatherBuffer out(100);
+    proto::serialize_gather(upload, out);
+    ASSERT_EQ(out.segments().size(), 3);
+
+    // Reuse with a smaller message that fits entirely in scratch
+    upload.payload.resize(10);
+    proto::serialize_gather(upload, out);
+    ASSERT_EQ(out.segments().size(), 1);
+    ASSERT_EQ(flatten(out.segments()), proto::serialize(upload));
+}
+
+TEST(Gather, default_members_are_skipped) {
+    test::Upload upload{0, std::vector<std::byte>(8192), 0};
+    proto::GatherBuffer out;
+    proto::serialize_gather(upload, out);
+
+    ASSERT_EQ(out.segments().size(), 2);
+    ASSERT_EQ(flatten(out.segments()), proto::serialize(upload));
+}
+
+TEST(Gather, write_segments_to_file) {
+    auto upload = make_upload(300'000);
+    proto::GatherBuffer out;
+    proto::serialize_gather(upload, out);
+
+    std::FILE *file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    proto::write_segments(::fileno(file), out.segments());
+
+    std::vector<std::byte> written(out.size());
+    std::rewind(file);
+    ASSERT_EQ(std::fread(written.data(), 1, written.size(), file),
+              written.size());
+    std::fclose(file);
+
+    ASSERT_EQ(proto::deserialize<test::Upload>(written), upload);
+}
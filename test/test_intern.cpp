@@ -0,0 +1,120 @@
+#include "TestTypes.h"
+
+#include <protobuf-cpp/Framing.h>
+#include <protobuf-cpp/Intern.h>
+#include <protobuf-cpp/Serialize.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+struct Labels {
+    proto::FlatMap<std::string_view, std::uint32_t> counts;
+    std::optional<std::map<std::uint32_t, std::string_view>> names;
+    using members = proto::Members<&Labels::counts, &Labels::names>;
+};
+} // namespace
+
+TEST(Intern, equal_payloads_share_one_copy) {
+    proto::InternTable table;
+    const std::string first = "host-1";
+    const std::string second = "host-1";
+
+    const auto a = table.intern(std::string_view{first});
+    const auto b = table.intern(std::string_view{second});
+    ASSERT_EQ(a, "host-1");
+    ASSERT_EQ(a.data(), b.data());
+    ASSERT_NE(a.data(), first.data());
+    ASSERT_NE(table.intern(std::string_view{"host-2"}).data(), a.data());
+    ASSERT_EQ(table.size(), 2);
+    ASSERT_EQ(table.bytes_stored(), 12);
+
+    // Bytes and text with the same contents share storage too
+    const auto bytes = table.intern(std::as_bytes(std::span{first}));
+    ASSERT_EQ(static_cast<const void *>(bytes.data()),
+              static_cast<const void *>(a.data()));
+
+    ASSERT_TRUE(table.intern(std::string_view{}).empty());
+}
+
+TEST(Intern, large_payloads_outside_chunks) {
+    proto::InternTable table;
+    const std::string large(proto::InternTable::k_chunk_size, 'x');
+    const auto interned = table.intern(std::string_view{large});
+    ASSERT_EQ(interned, large);
+    ASSERT_EQ(table.intern(std::string_view{"small"}), "small");
+    ASSERT_EQ(table.intern(std::string_view{large}).data(), interned.data());
+}
+
+TEST(Intern, batch_decode_outlives_input) {
+    const std::array<std::string_view, 3> hosts{"alpha", "beta", "gamma"};
+    const std::array tag{std::byte{1}, std::byte{2}};
+
+    std::vector<std::byte> frames;
+    for (std::size_t i = 0; i < 1000; i++) {
+        test::Event event{hosts[i % hosts.size()], "cpu",
+                          static_cast<double>(i), std::nullopt};
+        if (i % 2 == 0) {
+            event.tag = std::span{tag};
+        }
+        proto::serialize_delimited(event, frames);
+    }
+
+    proto::InternTable table;
+    auto events = proto::deserialize_frames_interned<test::Event>(
+        std::span<const std::byte>{frames}, table);
+    // The views must not reference the input any more
+    frames.assign(frames.size(), std::byte{0});
+
+    ASSERT_EQ(events.size(), 1000);
+    ASSERT_EQ(table.size(), 5);
+    for (std::size_t i = 0; i < events.size(); i++) {
+        ASSERT_EQ(events[i].host, hosts[i % hosts.size()]);
+        ASSERT_EQ(events[i].host.data(),
+                  events[i % hosts.size()].host.data());
+        ASSERT_EQ(events[i].metric, "cpu");
+        ASSERT_EQ(events[i].value, static_cast<double>(i));
+        ASSERT_EQ(events[i].tag.has_value(), i % 2 == 0);
+        if (events[i].tag.has_value()) {
+            ASSERT_TRUE(std::ranges::equal(*events[i].tag, tag));
+        }
+    }
+}
+
+TEST(Intern, map_views_outlive_input) {
+    std::vector<std::byte> frames;
+    for (std::uint32_t i = 0; i < 100; i++) {
+        Labels labels{{{"alpha", i}, {"beta", i + 1}},
+                      std::map<std::uint32_t, std::string_view>{{i, "gamma"}}};
+        proto::serialize_delimited(labels, frames);
+    }
+
+    proto::InternTable table;
+    auto decoded = proto::deserialize_frames_interned<Labels>(
+        std::span<const std::byte>{frames}, table);
+    frames.assign(frames.size(), std::byte{0});
+
+    ASSERT_EQ(decoded.size(), 100);
+    ASSERT_EQ(table.size(), 3);
+    for (std::uint32_t i = 0; i < decoded.size(); i++) {
+        ASSERT_EQ(decoded[i].counts.size(), 2);
+        ASSERT_EQ(decoded[i].counts["alpha"], i);
+        ASSERT_EQ(decoded[i].counts["beta"], i + 1);
+        ASSERT_EQ(decoded[i].counts.begin()->first.data(),
+                  decoded[0].counts.begin()->first.data());
+        ASSERT_TRUE(decoded[i].names.has_value());
+        ASSERT_EQ(decoded[i].names->at(i), "gamma");
+        ASSERT_EQ(decoded[i].names->at(i).data(),
+                  decoded[0].names->at(0).data());
+    }
+}
@@ -0,0 +1,188 @@
+#include "TestTypes.h"
+
+#include <protobuf-cpp/Json.h>
+#include <protobuf-cpp/Record.h>
+#include <protobuf-cpp/Serialize.h>
+#include <protobuf-cpp/Utf8.h>
+#include <protobuf-cpp/Utils.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Sample {
+    std::uint64_t id;
+    double load;
+    bool healthy;
+    std::optional<std::int32_t> delta;
+    std::vector<std::byte> blob;
+
+    using members = proto::Members<&Sample::id, &Sample::load, &Sample::healthy,
+                                   &Sample::delta, &Sample::blob>;
+    static constexpr std::array member_names{"id", "load", "healthy",
+                                             "delta", "blob"};
+};
+
+struct RawLabels {
+    std::map<std::string, std::string> labels;
+    using members = proto::Members<&RawLabels::labels>;
+};
+
+} // namespace
+
+template <> struct proto::MemberEncoding<&Sample::blob> {
+    using type = proto::Varlen;
+};
+
+template <>
+struct proto::ValidateUtf8<&RawLabels::labels> : std::false_type {};
+
+TEST(Json, named_members) {
+    auto serialized = proto::serialize(test::DoubleInt{42, -150});
+    ASSERT_EQ(proto::to_json<test::DoubleInt>(serialized),
+              R"({"value1":42,"value2":-150})");
+
+    serialized = proto::serialize(test::IntAndFloat_asFixed{-1, 0.5f});
+    ASSERT_EQ(proto::to_json<test::IntAndFloat_asFixed>(serialized),
+              R"({"value1":-1,"value2":0.5})");
+}
+
+TEST(Json, unnamed_members_use_field_numbers) {
+    auto serialized = proto::serialize(test::SingleInt{7});
+    ASSERT_EQ(proto::to_json<test::SingleInt>(serialized), R"({"1":7})");
+}
+
+TEST(Json, absent_members_are_omitted) {
+    auto serialized = proto::serialize(test::DoubleInt{0, 3});
+    ASSERT_EQ(proto::to_json<test::DoubleInt>(serialized), R"({"value2":3})");
+    ASSERT_EQ(proto::to_json<test::DoubleInt>({}), "{}");
+}
+
+TEST(Json, proto3_json_mapping) {
+    const Sample sample{std::numeric_limits<std::uint64_t>::max(),
+                        std::numeric_limits<double>::infinity(),
+                        true,
+                        0,
+                        {std::byte{'a'}, std::byte{'b'}, std::byte{'c'},
+                         std::byte{'d'}}};
+    auto serialized = proto::serialize(sample);
+
+    ASSERT_EQ(proto::to_json<Sample>(serialized),
+              R"({"id":"18446744073709551615","load":"Infinity",)"
+              R"("healthy":true,"delta":0,"blob":"YWJjZA=="})");
+}
+
+TEST(Json, repeated_field_last_wins) {
+    auto serialized = proto::serialize(test::DoubleInt{1, 2});
+    auto again = proto::serialize(test::DoubleInt{5, 0});
+    serialized.insert(serialized.end(), again.begin(), again.end());
+
+    ASSERT_EQ(proto::to_json<test::DoubleInt>(serialized),
+              R"({"value1":5,"value2":2})");
+}
+
+TEST(Json, wire_type_mismatch_throws) {
+    auto serialized = proto::serialize(
+        proto::Record{proto::Field{1}, proto::Fixint32{1u}});
+    ASSERT_THROW((void)proto::to_json<test::DoubleInt>(serialized),
+                 std::runtime_error);
+}
+
+TEST(Json, escape_strings) {
+    std::string out;
+    proto::append_json_string(out, "plain");
+    ASSERT_EQ(out, R"("plain")");
+
+    // Long enough to exercise the vectorized scan on both sides of the escape
+    out.clear();
+    proto::append_json_string(
+        out, "a long prefix of clean text \"quoted\"\\ and\na tab\t\x01 end");
+    ASSERT_EQ(out, R"("a long prefix of clean text \"quoted\"\\ and\na tab\t)"
+                   R"(\u0001 end")");
+
+    // Bytes >= 0x80 (UTF-8) are copied as-is
+    out.clear();
+    proto::append_json_string(out, "caf\xc3\xa9 caf\xc3\xa9 caf\xc3\xa9 !");
+    ASSERT_EQ(out, "\"caf\xc3\xa9 caf\xc3\xa9 caf\xc3\xa9 !\"");
+}
+
+TEST(Json, base64) {
+    const std::array<std::byte, 5> bytes = {std::byte{'h'}, std::byte{'e'},
+                                            std::byte{'l'}, std::byte{'l'},
+                                            std::byte{'o'}};
+    std::string out;
+    proto::append_json_base64(out, std::span{bytes}.first(1));
+    out += ',';
+    proto::append_json_base64(out, std::span{bytes}.first(2));
+    out += ',';
+    proto::append_json_base64(out, bytes);
+    ASSERT_EQ(out, R"("aA==","aGU=","aGVsbG8=")");
+}
+
+TEST(Json, invalid_utf8_text) {
+    test::Document document{1, "\xff\xfe", "", ""};
+    ASSERT_THROW((void)proto::to_json<test::Document>(
+                     proto::serialize(document)),
+                 std::runtime_error);
+
+    // Members exempt from validation are made valid instead
+    document.title = "ok";
+    document.raw = "a\xff\xc3\xa9\xe2\x82";
+    ASSERT_EQ(proto::to_json<test::Document>(proto::serialize(document)),
+              "{\"id\":1,\"title\":\"ok\","
+              "\"raw\":\"a\xef\xbf\xbd\xc3\xa9\xef\xbf\xbd\xef\xbf\xbd\"}");
+}
+
+TEST(Json, map_members) {
+    const test::RoutingTable first{
+        1, {{"a", 1}, {"b", 2}}, {{7, "x"}}, {{-1, 0.5}}};
+    const test::RoutingTable second{2, {{"b", 3}}, {}, {}};
+    auto serialized = proto::serialize(first);
+    const auto again = proto::serialize(second);
+    serialized.insert(serialized.end(), again.begin(), again.end());
+
+    // Entries of every occurrence are merged, later keys replacing earlier
+    ASSERT_EQ(proto::to_json<test::RoutingTable>(serialized),
+              R"({"1":2,"2":{"a":1,"b":3},"3":{"7":"x"},"4":{"-1":0.5}})");
+
+    ASSERT_EQ(proto::to_json<test::RoutingTable>(
+                  proto::serialize(test::RoutingTable{})),
+              "{}");
+}
+
+TEST(Json, map_members_without_utf8_validation) {
+    const RawLabels raw{{{"\xff", "\xc0\x80"}, {"ok", "\xc3\xa9"}}};
+    const auto json = proto::to_json<RawLabels>(proto::serialize(raw));
+    ASSERT_TRUE(proto::is_valid_utf8(
+        std::as_bytes(std::span{json.data(), json.size()})));
+    ASSERT_EQ(json, "{\"1\":{\"ok\":\"\xc3\xa9\","
+                    "\"\xef\xbf\xbd\":\"\xef\xbf\xbd\xef\xbf\xbd\"}}");
+}
+
+TEST(Json, varints_are_bounded_by_type) {
+    // Six-byte varint for a 32-bit member, which deserialize rejects
+    const std::vector<std::byte> too_long{
+        std::byte{0x08}, std::byte{0x80}, std::byte{0x80}, std::byte{0x80},
+        std::byte{0x80}, std::byte{0x80}, std::byte{0x01}};
+    ASSERT_THROW((void)proto::to_json<test::DoubleInt>(too_long),
+                 std::runtime_error);
+
+    // Map keys and values too
+    const std::vector<std::byte> long_key{
+        std::byte{0x22}, std::byte{0x07}, std::byte{0x08}, std::byte{0x80},
+        std::byte{0x80}, std::byte{0x80}, std::byte{0x80}, std::byte{0x80},
+        std::byte{0x01}};
+    ASSERT_THROW((void)proto::to_json<test::RoutingTable>(long_key),
+                 std::runtime_error);
+}
@@ -0,0 +1,233 @@
+#include "TestTypes.h"
+
+#include <protobuf-cpp/Deserialize.h>
+#include <protobuf-cpp/Gather.h>
+#include <protobuf-cpp/Map.h>
+#include <protobuf-cpp/Serialize.h>
+#include <protobuf-cpp/Validate.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+// Message whose map member is optional
+struct OptionalRoutes {
+    std::optional<std::map<std::uint32_t, std::uint32_t>> routes;
+    using members = proto::Members<&OptionalRoutes::routes>;
+
+    bool operator==(const OptionalRoutes &) const = default;
+};
+
+// Optional map that can reserve room for its entries
+struct OptionalNames {
+    std::optional<std::unordered_map<std::uint64_t, std::string>> names;
+    using members = proto::Members<&OptionalNames::names>;
+};
+
+test::RoutingTable make_table(std::size_t count) {
+    test::RoutingTable table{};
+    table.version = 3;
+    for (std::size_t i = 0; i < count; i++) {
+        table.routes["10.0." + std::to_string(i)] =
+            static_cast<std::uint32_t>(i);
+        table.names[i * 7919] = "node-" + std::to_string(i);
+        table.weights[static_cast<std::int32_t>(i) - 50] =
+            static_cast<double>(i) * 0.25;
+    }
+    return table;
+}
+
+// Messages whose map keys and values are text, one exempt from UTF-8 checks
+struct Labels {
+    std::map<std::string, std::string> labels;
+    using members = proto::Members<&Labels::labels>;
+
+    bool operator==(const Labels &) const = default;
+};
+struct RawLabels {
+    std::map<std::string, std::string> labels;
+    using members = proto::Members<&RawLabels::labels>;
+
+    bool operator==(const RawLabels &) const = default;
+};
+} // namespace
+
+template <>
+struct proto::ValidateUtf8<&RawLabels::labels> : std::false_type {};
+
+TEST(Map, entry_layout) {
+    test::RoutingTable table{};
+    table.routes["a"] = 1;
+    auto serialized = proto::serialize(table);
+
+    // Field 2, LEN, 5 bytes: key "a" as field 1, value 1 as field 2
+    const std::vector<std::byte> expected = {
+        std::byte{0x12}, std::byte{0x05}, std::byte{0x0a}, std::byte{0x01},
+        std::byte{'a'},  std::byte{0x10}, std::byte{0x01}};
+    ASSERT_EQ(serialized, expected);
+}
+
+TEST(Map, roundtrip) {
+    const auto table = make_table(1000);
+    auto serialized = proto::serialize(table);
+    ASSERT_EQ(serialized.size(), proto::serialized_size(table));
+    ASSERT_EQ(proto::deserialize<test::RoutingTable>(serialized), table);
+
+    // Empty maps are not serialized
+    ASSERT_TRUE(proto::serialize(test::RoutingTable{}).empty());
+}
+
+TEST(Map, optional_map_roundtrip) {
+    OptionalRoutes routes{std::map<std::uint32_t, std::uint32_t>{{1, 2},
+                                                                 {3, 4}}};
+    auto serialized = proto::serialize(routes);
+    ASSERT_EQ(serialized.size(), proto::serialized_size(routes));
+    ASSERT_EQ(proto::deserialize<OptionalRoutes>(serialized), routes);
+    ASSERT_TRUE(proto::validate<OptionalRoutes>(serialized));
+
+    ASSERT_FALSE(proto::deserialize<OptionalRoutes>({}).routes.has_value());
+}
+
+TEST(Map, deterministic_encoding_of_unordered_map) {
+    test::RoutingTable forward{};
+    test::RoutingTable backward{};
+    backward.names.reserve(1000);
+    for (std::uint64_t i = 0; i < 500; i++) {
+        forward.names[i] = std::to_string(i);
+        backward.names[499 - i] = std::to_string(499 - i);
+    }
+    ASSERT_EQ(proto::serialize(forward), proto::serialize(backward));
+}
+
+TEST(Map, later_entries_replace_earlier_ones) {
+    test::RoutingTable first{};
+    first.routes["x"] = 1;
+    first.weights[4] = 1.0;
+    test::RoutingTable second{};
+    second.routes["x"] = 2;
+    second.weights[2] = 3.0;
+
+    auto serialized = proto::serialize(first);
+    auto more = proto::serialize(second);
+    serialized.insert(serialized.end(), more.begin(), more.end());
+
+    auto decoded = proto::deserialize<test::RoutingTable>(serialized);
+    ASSERT_EQ(decoded.routes.at("x"), 2);
+    ASSERT_EQ(decoded.weights.size(), 2);
+    ASSERT_EQ(decoded.weights.begin()->first, 2);
+    ASSERT_EQ(decoded.weights.at(4), 1.0);
+}
+
+TEST(Map, missing_and_unknown_entry_fields) {
+    // Field 2 entries: one without a value, one with only a value and an
+    // unknown field 3
+    const std::vector<std::byte> serialized = {
+        std::byte{0x12}, std::byte{0x03}, std::byte{0x0a}, std::byte{0x01},
+        std::byte{'k'},  std::byte{0x12}, std::byte{0x04}, std::byte{0x10},
+        std::byte{0x07}, std::byte{0x18}, std::byte{0x01}};
+
+    auto decoded = proto::deserialize<test::RoutingTable>(serialized);
+    ASSERT_EQ(decoded.routes.size(), 2);
+    ASSERT_EQ(decoded.routes.at("k"), 0);
+    ASSERT_EQ(decoded.routes.at(""), 7);
+}
+
+TEST(Map, malformed_entry_throws) {
+    const std::vector<std::byte> serialized = {
+        std::byte{0x12}, std::byte{0x02}, std::byte{0x0a}, std::byte{0x05}};
+    ASSERT_THROW((void)proto::deserialize<test::RoutingTable>(serialized),
+                 std::runtime_error);
+}
+
+TEST(Map, utf8_validation_follows_member) {
+    for (const auto &entry :
+         {std::pair<std::string, std::string>{"\xff", "ok"},
+          std::pair<std::string, std::string>{"ok", "\xc0\x80"}}) {
+        const RawLabels raw{{entry}};
+        const auto serialized = proto::serialize(raw);
+
+        ASSERT_THROW((void)proto::deserialize<Labels>(serialized),
+                     std::runtime_error);
+        ASSERT_EQ(proto::validate<Labels>(serialized).error,
+                  proto::ValidationError::InvalidUtf8);
+
+        ASSERT_EQ(proto::deserialize<RawLabels>(serialized), raw);
+        ASSERT_TRUE(proto::validate<RawLabels>(serialized));
+    }
+}
+
+TEST(Map, entries_are_reserved_up_front) {
+    auto serialized = proto::serialize(make_table(1000));
+
+    test::RoutingTable table{};
+    proto::reserve_map_entries(serialized, table);
+    ASSERT_GE(table.names.bucket_count() * table.names.max_load_factor(),
+              1000);
+    ASSERT_TRUE(table.names.empty());
+}
+
+TEST(Map, optional_entries_are_reserved_up_front) {
+    OptionalNames source{std::unordered_map<std::uint64_t, std::string>{}};
+    for (std::uint64_t i = 0; i < 1000; i++) {
+        (*source.names)[i] = std::to_string(i);
+    }
+    auto serialized = proto::serialize(source);
+
+    OptionalNames names{};
+    proto::reserve_map_entries(serialized, names);
+    ASSERT_TRUE(names.names.has_value());
+    ASSERT_GE(names.names->bucket_count() * names.names->max_load_factor(),
+              1000);
+
+    // Nothing to reserve leaves the member disengaged
+    OptionalNames empty{};
+    proto::reserve_map_entries({}, empty);
+    ASSERT_FALSE(empty.names.has_value());
+}
+
+TEST(Map, flat_map_stays_sorted) {
+    proto::FlatMap<int, std::string> map{{3, "c"}, {1, "a"}};
+    map.insert_or_assign(2, "b");
+    map.insert_or_assign(4, "d");
+    map[1] = "A";
+
+    std::vector<int> keys;
+    for (const auto &[key, value] : map) {
+        keys.push_back(key);
+    }
+    ASSERT_EQ(keys, (std::vector<int>{1, 2, 3, 4}));
+    ASSERT_EQ(map.at(1), "A");
+    ASSERT_TRUE(map.contains(3));
+    ASSERT_EQ(map.erase(3), 1);
+    ASSERT_FALSE(map.contains(3));
+    ASSERT_THROW((void)map.at(3), std::out_of_range);
+}
+
+TEST(Map, other_serialization_paths) {
+    const auto table = make_table(10);
+    const auto serialized = proto::serialize(table);
+
+    std::array<std::byte, 8> too_small{};
+    ASSERT_THROW(proto::serialize(table, too_small), std::runtime_error);
+
+    proto::GatherBuffer out;
+    proto::serialize_gather(table, out);
+    std::vector<std::byte> gathered;
+    for (const auto &segment : out.segments()) {
+        const auto *data = static_cast<const std::byte *>(segment.iov_base);
+        gathered.insert(gathered.end(), data, data + segment.iov_len);
+    }
+    ASSERT_EQ(gathered, serialized);
+}
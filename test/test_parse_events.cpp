@@ -0,0 +1,156 @@
+#include "TestHelpers.h"
+#include "TestTypes.h"
+
+#include <protobuf-cpp/Fixint.h>
+#include <protobuf-cpp/ParseEvents.h>
+#include <protobuf-cpp/Record.h>
+#include <protobuf-cpp/Serialize.h>
+#include <protobuf-cpp/Utils.h>
+#include <protobuf-cpp/Varint.h>
+#include <protobuf-cpp/Varlen.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using test::concat;
+
+struct Event {
+    std::string kind;
+    std::uint64_t field;
+    std::uint64_t value; // varint/fixed value or LEN payload size
+
+    bool operator==(const Event &) const = default;
+};
+
+struct RecordingVisitor {
+    std::vector<Event> events;
+
+    void on_varint(proto::Field field, proto::Varint value) {
+        events.push_back({"varint", std::to_underlying(field), value.value()});
+    }
+    void on_fixed32(proto::Field field, proto::Fixint32 value) {
+        events.push_back({"fixed32", std::to_underlying(field), value.value()});
+    }
+    void on_fixed64(proto::Field field, proto::Fixint64 value) {
+        events.push_back({"fixed64", std::to_underlying(field), value.value()});
+    }
+    void on_len(proto::Field field, std::span<const std::byte> payload) {
+        events.push_back({"len", std::to_underlying(field), payload.size()});
+    }
+};
+
+// Treats field 3 as a nested message
+struct NestedVisitor : RecordingVisitor {
+    bool begin_message(proto::Field field, std::span<const std::byte>) {
+        if (std::to_underlying(field) != 3) {
+            return false;
+        }
+        events.push_back({"begin", std::to_underlying(field), 0});
+        return true;
+    }
+    void end_message(proto::Field field) {
+        events.push_back({"end", std::to_underlying(field), 0});
+    }
+};
+
+} // namespace
+
+static_assert(proto::EventVisitor<RecordingVisitor>);
+static_assert(!proto::NestedEventVisitor<RecordingVisitor>);
+static_assert(proto::NestedEventVisitor<NestedVisitor>);
+
+TEST(ParseEvents, reports_every_wire_type) {
+    const std::vector<std::byte> payload(3, std::byte{0x7f});
+    auto data = concat(proto::Record{proto::Field{1}, proto::Varint{150u}},
+                       proto::Record{proto::Field{2}, proto::Fixint32{7u}},
+                       proto::Record{proto::Field{3}, proto::Varlen{payload}},
+                       proto::Record{proto::Field{4}, proto::Fixint64{9u}});
+
+    RecordingVisitor visitor;
+    proto::parse_events(data, visitor);
+
+    const std::vector<Event> expected = {{"varint", 1, 150},
+                                         {"fixed32", 2, 7},
+                                         {"len", 3, 3},
+                                         {"fixed64", 4, 9}};
+    ASSERT_EQ(visitor.events, expected);
+}
+
+TEST(ParseEvents, matches_serialized_struct) {
+    auto data = proto::serialize(test::DoubleInt{42, -1});
+
+    RecordingVisitor visitor;
+    proto::parse_events(data, visitor);
+
+    // -1 is zigzag encoded as 1
+    const std::vector<Event> expected = {{"varint", 1, 42}, {"varint", 2, 1}};
+    ASSERT_EQ(visitor.events, expected);
+}
+
+TEST(ParseEvents, visitor_claims_nested_messages) {
+    auto inner = concat(proto::Record{proto::Field{1}, proto::Varint{5u}});
+    auto data = concat(proto::Record{proto::Field{1}, proto::Varint{1u}},
+                       proto::Record{proto::Field{3}, proto::Varlen{inner}},
+                       proto::Record{proto::Field{4}, proto::Varlen{inner}});
+
+    NestedVisitor visitor;
+    proto::parse_events(data, visitor);
+
+    const std::vector<Event> expected = {{"varint", 1, 1}, {"begin", 3, 0},
+                                         {"varint", 1, 5}, {"end", 3, 0},
+                                         {"len", 4, 2}};
+    ASSERT_EQ(visitor.events, expected);
+}
+
+TEST(ParseEvents, malformed_input_throws) {
+    RecordingVisitor visitor;
+
+    // Truncated varint value
+    const std::vector<std::byte> truncated = {std::byte{0x08}, std::byte{0x96}};
+    ASSERT_THROW(proto::parse_events(truncated, visitor), std::runtime_error);
+
+    // LEN field claims more bytes than are available
+    const std::vector<std::byte> short_len = {std::byte{0x12}, std::byte{0x05},
+                                              std::byte{0x00}};
+    ASSERT_THROW(proto::parse_events(short_len, visitor), std::runtime_error);
+
+    // Deprecated group wire type
+    const std::vector<std::byte> group = {std::byte{0x0b}};
+    ASSERT_THROW(proto::parse_events(group, visitor), std::runtime_error);
+
+    // Field number 0 is reserved
+    const std::vector<std::byte> field_zero = {std::byte{0x00},
+                                               std::byte{0x01}};
+    ASSERT_THROW(proto::parse_events(field_zero, visitor), std::runtime_error);
+
+    // Over-long (11 byte) varint
+    std::vector<std::byte> over_long(11, std::byte{0x80});
+    over_long.insert(over_long.begin(), std::byte{0x08});
+    over_long.back() = std::byte{0x01};
+    ASSERT_THROW(proto::parse_events(over_long, visitor), std::runtime_error);
+}
+
+TEST(ParseEvents, read_field_exposes_raw_bytes) {
+    const std::vector<std::byte> payload(2, std::byte{0x01});
+    auto data = concat(proto::Record{proto::Field{2}, proto::Varlen{payload}},
+                       proto::Record{proto::Field{1}, proto::Varint{1u}});
+
+    auto deserialized = proto::read_field(data);
+    ASSERT_EQ(deserialized.num_bytes_read, 4);
+    ASSERT_EQ(deserialized.value.field_number(), proto::Field{2});
+    ASSERT_EQ(deserialized.value.wire_type(), proto::WireType::LEN);
+    ASSERT_EQ(deserialized.value.bytes.data(), data.data());
+    ASSERT_EQ(deserialized.value.bytes.size(), 4);
+    ASSERT_EQ(deserialized.value.payload.data(), data.data() + 2);
+    ASSERT_EQ(deserialized.value.payload.size(), 2);
+}
@@ -0,0 +1,116 @@
+#include "TestTypes.h"
+
+#include <protobuf-cpp/Deserialize.h>
+#include <protobuf-cpp/Fixint.h>
+#include <protobuf-cpp/Patch.h>
+#include <protobuf-cpp/Serialize.h>
+#include <protobuf-cpp/Varint.h>
+#include <protobuf-cpp/Varlen.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+TEST(Patch, fixed_width_field_is_overwritten) {
+    test::IntAndFloat_asFixed record{-3, 1.5f};
+    auto serialized = proto::serialize(record);
+    const auto size = serialized.size();
+
+    proto::patch_member<&test::IntAndFloat_asFixed::value2>(serialized, 2.5f);
+    ASSERT_EQ(serialized.size(), size);
+    record.value2 = 2.5f;
+    ASSERT_EQ(proto::deserialize<test::IntAndFloat_asFixed>(serialized),
+              record);
+}
+
+TEST(Patch, varint_of_same_size_is_overwritten) {
+    test::DoubleInt record{100, -5};
+    auto serialized = proto::serialize(record);
+    const auto *data = serialized.data();
+
+    proto::patch_member<&test::DoubleInt::value1>(serialized, 120);
+    record.value1 = 120;
+    ASSERT_EQ(serialized, proto::serialize(record));
+    ASSERT_EQ(serialized.data(), data);
+}
+
+TEST(Patch, varint_that_grows_or_shrinks_moves_the_tail) {
+    test::DoubleInt record{1, -5};
+    auto serialized = proto::serialize(record);
+
+    proto::patch_member<&test::DoubleInt::value1>(serialized, 1'000'000);
+    record.value1 = 1'000'000;
+    ASSERT_EQ(serialized, proto::serialize(record));
+
+    proto::patch_member<&test::DoubleInt::value1>(serialized, 7);
+    record.value1 = 7;
+    ASSERT_EQ(serialized, proto::serialize(record));
+
+    proto::patch_member<&test::DoubleInt::value2>(serialized, -70'000);
+    record.value2 = -70'000;
+    ASSERT_EQ(serialized, proto::serialize(record));
+}
+
+TEST(Patch, absent_field_is_appended) {
+    test::DoubleInt record{0, 9};
+    auto serialized = proto::serialize(record);
+
+    proto::patch_member<&test::DoubleInt::value1>(serialized, 300);
+    record.value1 = 300;
+    ASSERT_EQ(proto::deserialize<test::DoubleInt>(serialized), record);
+}
+
+TEST(Patch, last_occurrence_is_patched) {
+    auto serialized = proto::serialize(test::DoubleInt{1, 2});
+    auto again = proto::serialize(test::DoubleInt{3, 0});
+    serialized.insert(serialized.end(), again.begin(), again.end());
+
+    proto::patch_field(serialized, proto::Field{1}, proto::Varint{5u});
+    ASSERT_EQ(proto::deserialize<test::DoubleInt>(serialized),
+              (test::DoubleInt{5, 2}));
+
+    // The first occurrence is left alone
+    ASSERT_EQ(serialized[1], std::byte{1});
+}
+
+TEST(Patch, span_with_spare_room) {
+    std::array<std::byte, 16> buffer{};
+    auto size = proto::serialize(test::DoubleInt{1, 2}, buffer);
+
+    size = proto::patch_member<&test::DoubleInt::value1>(buffer, size, 300);
+    ASSERT_EQ(size, 5);
+    ASSERT_EQ(proto::deserialize<test::DoubleInt>(
+                  std::span{buffer}.first(size)),
+              (test::DoubleInt{300, 2}));
+
+    // Not enough room for a ten-byte value
+    ASSERT_THROW(proto::patch_field(std::span{buffer}.first(size + 2), size,
+                                    proto::Field{1},
+                                    proto::Varint{~std::uint64_t{}}),
+                 std::runtime_error);
+    ASSERT_THROW(proto::patch_field(std::span{buffer}.first(2), size,
+                                    proto::Field{1}, proto::Varint{1u}),
+                 std::runtime_error);
+}
+
+TEST(Patch, length_delimited_field) {
+    test::Document document{1, "short", "", ""};
+    auto serialized = proto::serialize(document);
+
+    proto::patch_member<&test::Document::title>(serialized,
+                                                "a much longer title");
+    document.title = "a much longer title";
+    ASSERT_EQ(proto::deserialize<test::Document>(serialized), document);
+}
+
+TEST(Patch, malformed_message_throws) {
+    std::vector<std::byte> serialized{std::byte{0x08}, std::byte{0x80}};
+    ASSERT_THROW(proto::patch_field(serialized, proto::Field{1},
+                                    proto::Varint{1u}),
+                 std::runtime_error);
+}
@@ -0,0 +1,76 @@
+#include "TestTypes.h"
+
+#include <protobuf-cpp/Deserialize.h>
+#include <protobuf-cpp/Serialize.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstddef>
+#include <optional>
+
+TEST(Presence, default_scalars_are_not_serialized) {
+    ASSERT_TRUE(proto::serialize(test::DoubleInt{0, 0}).empty());
+    ASSERT_TRUE(proto::serialize(test::IntAndFloat_asFixed{0, 0.0f}).empty());
+
+    // Only value2 is on the wire: key for field 2 plus a one byte varint
+    auto serialized = proto::serialize(test::DoubleInt{0, 1});
+    ASSERT_EQ(serialized.size(), 2);
+    ASSERT_EQ(serialized[0], std::byte{(2 << 3) | 0});
+
+    ASSERT_EQ(proto::deserialize<test::DoubleInt>(serialized),
+              (test::DoubleInt{0, 1}));
+}
+
+TEST(Presence, negative_zero_is_serialized) {
+    const test::IntAndFloat_asFixed original{0, -0.0f};
+    auto serialized = proto::serialize(original);
+    ASSERT_EQ(serialized.size(), 5);
+
+    auto deserialized =
+        proto::deserialize<test::IntAndFloat_asFixed>(serialized);
+    ASSERT_TRUE(std::signbit(deserialized.value2));
+}
+
+TEST(Presence, optional_members_have_explicit_presence) {
+    // An engaged optional is serialized even if it holds zero
+    const test::OptionalInt zero{0, 0};
+    auto serialized = proto::serialize(zero);
+    ASSERT_EQ(serialized.size(), 2);
+    ASSERT_EQ(proto::deserialize<test::OptionalInt>(serialized), zero);
+
+    const test::OptionalInt empty{std::nullopt, 7};
+    serialized = proto::serialize(empty);
+    ASSERT_EQ(serialized.size(), 2);
+    ASSERT_EQ(proto::deserialize<test::OptionalInt>(serialized), empty);
+
+    const test::OptionalInt negative{-5, 7};
+    serialized = proto::serialize(negative);
+    ASSERT_EQ(proto::deserialize<test::OptionalInt>(serialized), negative);
+}
+
+TEST(Presence, computed_presence_bitmap) {
+    auto present = proto::presence(test::DoubleInt{0, 3});
+    ASSERT_FALSE(present[0]);
+    ASSERT_TRUE(present[1]);
+
+    auto optional_present = proto::presence(test::OptionalInt{0, 0});
+    ASSERT_TRUE(optional_present[0]);
+    ASSERT_FALSE(optional_present[1]);
+}
+
+TEST(Presence, type_maintained_presence_bitmap) {
+    static_assert(proto::TracksPresence<test::SparseStatus>);
+
+    test::SparseStatus status;
+    // Not marked present, so not serialized despite being non-zero
+    status.id = 99;
+    status.set_code(0);
+
+    auto serialized = proto::serialize(status);
+    ASSERT_EQ(serialized.size(), 2);
+
+    auto deserialized = proto::deserialize<test::SparseStatus>(serialized);
+    ASSERT_EQ(deserialized.id, 0);
+    ASSERT_EQ(deserialized.code, 0);
+}
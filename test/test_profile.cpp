@@ -0,0 +1,106 @@
+#include "TestTypes.h"
+
+#include <protobuf-cpp/Profile.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+void run_calls(int count) {
+    const test::DoubleInt message{300, -5};
+    for (int i = 0; i < count; i++) {
+        const auto serialized = proto::profiled_serialize(message);
+        ASSERT_EQ(proto::profiled_deserialize<test::DoubleInt>(serialized),
+                  message);
+    }
+}
+} // namespace
+
+TEST(Profile, calls_are_aggregated_per_type_and_operation) {
+    auto &profiler = proto::CodecProfiler::global();
+    profiler.reset();
+    profiler.set_sample_period(1);
+
+    run_calls(100);
+    const test::Document document{1, "t", "b", ""};
+    std::array<std::byte, 16> buffer{};
+    ASSERT_EQ(proto::profiled_serialize(document, buffer),
+              proto::serialized_size(document));
+    profiler.set_sample_period(0);
+    run_calls(10);
+
+    const auto size = proto::serialized_size(test::DoubleInt{300, -5});
+    const auto profiles = profiler.profiles();
+    ASSERT_EQ(profiles.size(), 3);
+    ASSERT_EQ(profiles[0].message_type, "test::Document");
+    ASSERT_EQ(profiles[0].num_samples, 1);
+    for (std::size_t i = 1; i < profiles.size(); i++) {
+        ASSERT_EQ(profiles[i].message_type, "test::DoubleInt");
+        ASSERT_EQ(profiles[i].num_samples, 100);
+        ASSERT_EQ(profiles[i].num_bytes, 100 * size);
+    }
+    ASSERT_EQ(profiles[1].operation, proto::CodecOperation::Serialize);
+    ASSERT_EQ(profiles[2].operation, proto::CodecOperation::Deserialize);
+    for (const auto &profile : profiles) {
+        ASSERT_EQ(profile.has(proto::Counter::Cycles),
+                  proto::CodecProfiler::hardware_counters_available());
+    }
+
+    const auto report = profiler.report();
+    ASSERT_NE(report.find("test::DoubleInt"), std::string::npos);
+    ASSERT_NE(report.find("deserialize"), std::string::npos);
+}
+
+TEST(Profile, sampling_does_not_alias_with_call_pattern) {
+    auto &profiler = proto::CodecProfiler::global();
+    profiler.reset();
+    // Calls alternate between serialize and deserialize, so a fixed period
+    // of 2 would only ever sample one of them
+    profiler.set_sample_period(2);
+    run_calls(2000);
+    profiler.set_sample_period(0);
+
+    const auto profiles = profiler.profiles();
+    ASSERT_EQ(profiles.size(), 2);
+    for (const auto &profile : profiles) {
+        ASSERT_GT(profile.num_samples, 500);
+        ASSERT_LT(profile.num_samples, 1500);
+    }
+}
+
+TEST(Profile, shorter_period_applies_at_once) {
+    auto &profiler = proto::CodecProfiler::global();
+    profiler.set_sample_period(1'000'000);
+    run_calls(1);
+    profiler.reset();
+    profiler.set_sample_period(1);
+    run_calls(1);
+    profiler.set_sample_period(0);
+
+    const auto profiles = profiler.profiles();
+    ASSERT_EQ(profiles.size(), 2);
+    for (const auto &profile : profiles) {
+        ASSERT_EQ(profile.num_samples, 1);
+    }
+}
+
+TEST(Profile, first_call_on_a_thread_is_not_always_sampled) {
+    auto &profiler = proto::CodecProfiler::global();
+    profiler.reset();
+    profiler.set_sample_period(1'000'000);
+    std::thread{[] { run_calls(1); }}.join();
+    profiler.set_sample_period(0);
+
+    ASSERT_TRUE(profiler.profiles().empty());
+}
+
+TEST(Profile, disabled_by_default) {
+    proto::CodecProfiler profiler;
+    ASSERT_FALSE(profiler.start_sample().has_value());
+    ASSERT_TRUE(profiler.profiles().empty());
+}
@@ -127,3 +127,15 @@ TEST(Record, construct_record_with_varlen_payload) {
     ASSERT_EQ(deserialized_record.wire_type(), proto::WireType::LEN);
     ASSERT_TRUE(std::ranges::equal(deserialized_record.value().value(), value));
 }
+
+TEST(Record, varlen_deserialize_stops_at_length) {
+    std::vector<std::byte> value = {std::byte{1}, std::byte{2}};
+    auto serialized = proto::serialize(proto::Varlen{value});
+    // Trailing bytes belong to the next field and must not be consumed
+    serialized.push_back(std::byte{0x08});
+    serialized.push_back(std::byte{0x01});
+
+    auto deserialized = proto::Varlen::deserialize(serialized);
+    ASSERT_EQ(deserialized.num_bytes_read, 3);
+    ASSERT_TRUE(std::ranges::equal(deserialized.value.value(), value));
+}
@@ -0,0 +1,114 @@
+#include "TestHelpers.h"
+#include "TestTypes.h"
+
+#include <protobuf-cpp/Deserialize.h>
+#include <protobuf-cpp/Fixint.h>
+#include <protobuf-cpp/Record.h>
+#include <protobuf-cpp/Rewrite.h>
+#include <protobuf-cpp/Serialize.h>
+#include <protobuf-cpp/Utils.h>
+#include <protobuf-cpp/Varint.h>
+#include <protobuf-cpp/Varlen.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+using test::concat;
+
+const std::vector<std::byte> k_secret = {std::byte{'p'}, std::byte{'w'}};
+
+} // namespace
+
+TEST(Rewrite, identity_mapping_copies_input) {
+    auto input = concat(proto::Record{proto::Field{1}, proto::Varint{150u}},
+                        proto::Record{proto::Field{2}, proto::Varlen{k_secret}},
+                        proto::Record{proto::Field{3}, proto::Fixint64{7u}});
+    std::vector<std::byte> output(input.size());
+
+    auto num_bytes_written = proto::rewrite_fields(
+        input, output, [](proto::Field f) { return std::optional{f}; });
+
+    ASSERT_EQ(num_bytes_written, input.size());
+    ASSERT_EQ(output, input);
+}
+
+TEST(Rewrite, drops_filtered_fields) {
+    auto input = concat(proto::Record{proto::Field{1}, proto::Varint{150u}},
+                        proto::Record{proto::Field{2}, proto::Varlen{k_secret}},
+                        proto::Record{proto::Field{3}, proto::Fixint64{7u}});
+    std::vector<std::byte> output(input.size());
+
+    auto num_bytes_written = proto::rewrite_fields(
+        input, output, [](proto::Field f) -> std::optional<proto::Field> {
+            if (f == proto::Field{2}) {
+                return std::nullopt;
+            }
+            return f;
+        });
+
+    auto expected =
+        concat(proto::Record{proto::Field{1}, proto::Varint{150u}},
+               proto::Record{proto::Field{3}, proto::Fixint64{7u}});
+    output.resize(num_bytes_written);
+    ASSERT_EQ(output, expected);
+}
+
+TEST(Rewrite, renumbers_fields) {
+    auto input = concat(proto::Record{proto::Field{1}, proto::Varint{150u}},
+                        proto::Record{proto::Field{2}, proto::Varlen{k_secret}},
+                        proto::Record{proto::Field{3}, proto::Fixint32{7u}});
+    // Field 20 needs a two byte key
+    std::vector<std::byte> output(input.size() + 1);
+
+    auto num_bytes_written = proto::rewrite_fields(
+        input, output, [](proto::Field f) -> std::optional<proto::Field> {
+            if (f == proto::Field{2}) {
+                return proto::Field{20};
+            }
+            return f;
+        });
+
+    auto expected =
+        concat(proto::Record{proto::Field{1}, proto::Varint{150u}},
+               proto::Record{proto::Field{20}, proto::Varlen{k_secret}},
+               proto::Record{proto::Field{3}, proto::Fixint32{7u}});
+    ASSERT_EQ(num_bytes_written, expected.size());
+    ASSERT_EQ(output, expected);
+}
+
+TEST(Rewrite, swapping_fields_changes_decoded_members) {
+    auto input = proto::serialize(test::DoubleInt{42, 150});
+    std::vector<std::byte> output(input.size());
+
+    auto num_bytes_written = proto::rewrite_fields(
+        input, output, [](proto::Field f) {
+            return std::optional{proto::Field{3 - std::to_underlying(f)}};
+        });
+
+    // value1 is unsigned and value2 is zigzag encoded, so the raw varints
+    // are reinterpreted rather than simply swapped
+    auto decoded = proto::deserialize<test::DoubleInt>(
+        std::span{output}.first(num_bytes_written));
+    ASSERT_EQ(decoded.value1, 300u);
+    ASSERT_EQ(decoded.value2, 21);
+}
+
+TEST(Rewrite, errors) {
+    auto input = concat(proto::Record{proto::Field{1}, proto::Varint{150u}});
+    std::vector<std::byte> output(input.size() - 1);
+    auto identity = [](proto::Field f) { return std::optional{f}; };
+    ASSERT_THROW(proto::rewrite_fields(input, output, identity),
+                 std::runtime_error);
+
+    input.pop_back();
+    output.resize(input.size() + 1);
+    ASSERT_THROW(proto::rewrite_fields(input, output, identity),
+                 std::runtime_error);
+}
@@ -0,0 +1,195 @@
+#include "TestTypes.h"
+
+#include <protobuf-cpp/Deserialize.h>
+#include <protobuf-cpp/Ring.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+template <std::size_t Capacity> struct RingMemory {
+    static constexpr std::size_t k_size = proto::ring_memory_size(Capacity);
+    alignas(64) std::array<std::byte, k_size> bytes{};
+};
+
+// Removes a shared memory object however the test exits
+struct UnlinkGuard {
+    std::string name;
+    ~UnlinkGuard() { proto::SharedMemory::unlink(name); }
+};
+
+// Kills and reaps a forked child unless the test has waited for it
+class ChildGuard {
+  public:
+    explicit ChildGuard(pid_t pid) : m_pid(pid) {}
+    ChildGuard(const ChildGuard &) = delete;
+    ChildGuard &operator=(const ChildGuard &) = delete;
+    ~ChildGuard() {
+        if (m_pid > 0) {
+            ::kill(m_pid, SIGKILL);
+            ::waitpid(m_pid, nullptr, 0);
+        }
+    }
+
+    // The child's wait status, or -1 if waitpid fails
+    int wait() {
+        int status = 0;
+        const auto pid = std::exchange(m_pid, -1);
+        return ::waitpid(pid, &status, 0) == pid ? status : -1;
+    }
+
+  private:
+    pid_t m_pid;
+};
+} // namespace
+
+TEST(Ring, write_and_read) {
+    auto memory = std::make_unique<RingMemory<256>>();
+    proto::initialize_ring(memory->bytes);
+    proto::RingProducer producer{memory->bytes};
+    proto::RingConsumer consumer{memory->bytes};
+    ASSERT_EQ(producer.capacity(), 256);
+
+    test::DoubleInt message{};
+    ASSERT_FALSE(proto::try_read(consumer, message));
+
+    ASSERT_TRUE(proto::try_write(producer, test::DoubleInt{1, -1}));
+    ASSERT_TRUE(proto::try_write(producer, test::DoubleInt{2, -2}));
+    ASSERT_TRUE(proto::try_read(consumer, message));
+    ASSERT_EQ(message, (test::DoubleInt{1, -1}));
+    ASSERT_TRUE(proto::try_read(consumer, message));
+    ASSERT_EQ(message, (test::DoubleInt{2, -2}));
+    ASSERT_FALSE(proto::try_read(consumer, message));
+}
+
+TEST(Ring, full_ring_refuses_messages) {
+    auto memory = std::make_unique<RingMemory<64>>();
+    proto::initialize_ring(memory->bytes);
+    proto::RingProducer producer{memory->bytes};
+    proto::RingConsumer consumer{memory->bytes};
+
+    // Every record takes 16 bytes
+    const test::DoubleInt message{300, -300};
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(proto::try_write(producer, message));
+    }
+    ASSERT_FALSE(proto::try_write(producer, message));
+
+    ASSERT_TRUE(consumer.try_peek().has_value());
+    consumer.release();
+    ASSERT_TRUE(proto::try_write(producer, message));
+
+    ASSERT_THROW((void)producer.try_reserve(producer.max_message_size() + 1),
+                 std::runtime_error);
+}
+
+TEST(Ring, zero_copy_view_across_wraparound) {
+    auto memory = std::make_unique<RingMemory<128>>();
+    proto::initialize_ring(memory->bytes);
+    proto::RingProducer producer{memory->bytes};
+    proto::RingConsumer consumer{memory->bytes};
+
+    // Messages of varying sizes force wrapping at different offsets
+    for (std::uint32_t i = 0; i < 500; i++) {
+        const std::string body(i % 40, 'b');
+        ASSERT_TRUE(proto::try_write(
+            producer, test::Document{i, "t", body, ""}));
+
+        auto view = consumer.try_peek();
+        ASSERT_TRUE(view.has_value());
+        // The body member points into the ring
+        const auto document = proto::deserialize<test::Document>(*view);
+        ASSERT_EQ(document.id, i);
+        ASSERT_EQ(document.body, body);
+        if (!body.empty()) {
+            ASSERT_GE(static_cast<const void *>(document.body.data()),
+                      static_cast<const void *>(memory->bytes.data()));
+        }
+        consumer.release();
+    }
+}
+
+TEST(Ring, producer_and_consumer_threads) {
+    constexpr std::uint32_t k_count = 200'000;
+    auto memory = std::make_unique<RingMemory<4096>>();
+    proto::initialize_ring(memory->bytes);
+
+    std::jthread producer_thread([&] {
+        proto::RingProducer producer{memory->bytes};
+        for (std::uint32_t i = 0; i < k_count; i++) {
+            const test::DoubleInt message{i, -static_cast<std::int32_t>(i)};
+            while (!proto::try_write(producer, message)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    proto::RingConsumer consumer{memory->bytes};
+    test::DoubleInt message{};
+    for (std::uint32_t i = 0; i < k_count; i++) {
+        while (!proto::try_read(consumer, message)) {
+            std::this_thread::yield();
+        }
+        ASSERT_EQ(message, (test::DoubleInt{i, -static_cast<std::int32_t>(i)}));
+    }
+}
+
+TEST(Ring, producer_and_consumer_processes) {
+    constexpr std::uint32_t k_count = 10'000;
+    const auto name = "/protobuf-cpp-test-ring-" + std::to_string(::getpid());
+    auto shared =
+        proto::SharedMemory::create(name, proto::ring_memory_size(4096));
+    const UnlinkGuard unlink_guard{name};
+    proto::initialize_ring(shared.span());
+
+    const auto pid = ::fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        int status = 0;
+        try {
+            auto child = proto::SharedMemory::open(name);
+            proto::RingProducer producer{child.span()};
+            for (std::uint32_t i = 0; i < k_count; i++) {
+                while (!proto::try_write(producer, test::DoubleInt{i, 1})) {
+                    std::this_thread::yield();
+                }
+            }
+        } catch (...) {
+            status = 1;
+        }
+        ::_exit(status);
+    }
+
+    ChildGuard child{pid};
+    proto::RingConsumer consumer{shared.span()};
+    test::DoubleInt message{};
+    for (std::uint32_t i = 0; i < k_count; i++) {
+        while (!proto::try_read(consumer, message)) {
+            std::this_thread::yield();
+        }
+        ASSERT_EQ(message, (test::DoubleInt{i, 1}));
+    }
+    const auto status = child.wait();
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+}
+
+TEST(Ring, memory_without_ring_throws) {
+    auto memory = std::make_unique<RingMemory<64>>();
+    ASSERT_THROW(proto::RingConsumer{memory->bytes}, std::runtime_error);
+
+    std::array<std::byte, 16> too_small{};
+    ASSERT_THROW(proto::initialize_ring(too_small), std::runtime_error);
+}
@@ -0,0 +1,206 @@
+#include "TestTypes.h"
+
+#include <protobuf-cpp/Framing.h>
+#include <protobuf-cpp/Stream.h>
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+std::vector<std::byte> make_frames(std::uint32_t count) {
+    std::vector<std::byte> frames;
+    for (std::uint32_t i = 0; i < count; i++) {
+        proto::serialize_delimited(
+            test::DoubleInt{i, -static_cast<std::int32_t>(i)}, frames);
+    }
+    return frames;
+}
+
+// Write `data` into a pipe from another thread in uneven pieces
+class PipeWriter {
+  public:
+    PipeWriter(std::vector<std::byte> data, std::size_t piece_size) {
+        if (::pipe(m_fds) != 0) {
+            throw std::runtime_error("pipe failed");
+        }
+        m_thread = std::thread([this, data = std::move(data), piece_size] {
+            std::size_t offset = 0;
+            while (offset < data.size()) {
+                const auto n = std::min(piece_size, data.size() - offset);
+                if (::write(m_fds[1], data.data() + offset, n) < 0) {
+                    break;
+                }
+                offset += n;
+            }
+            ::close(m_fds[1]);
+        });
+    }
+    PipeWriter(const PipeWriter &) = delete;
+    PipeWriter &operator=(const PipeWriter &) = delete;
+    ~PipeWriter() {
+        m_thread.join();
+        ::close(m_fds[0]);
+    }
+
+    int fd() const { return m_fds[0]; }
+
+  private:
+    int m_fds[2]{};
+    std::thread m_thread;
+};
+
+} // namespace
+
+TEST(Stream, read_messages_from_pipe) {
+    PipeWriter writer(make_frames(1000), 7);
+
+    std::uint32_t expected = 0;
+    // Chunks much smaller than the stream force frames to straddle them
+    for (const auto &message : proto::read_messages<test::DoubleInt>(
+             writer.fd(), 16)) {
+        ASSERT_EQ(message,
+                  (test::DoubleInt{expected,
+                                   -static_cast<std::int32_t>(expected)}));
+        expected++;
+    }
+    ASSERT_EQ(expected, 1000);
+}
+
+TEST(Stream, frames_larger_than_chunk) {
+    std::vector<std::byte> payload(1000);
+    for (std::size_t i = 0; i < payload.size(); i++) {
+        payload[i] = static_cast<std::byte>(i);
+    }
+    std::vector<std::byte> frames(2 * proto::framed_size(payload.size()));
+    auto size = proto::write_frame(payload, frames);
+    proto::write_frame(payload, std::span{frames}.subspan(size));
+
+    PipeWriter writer(frames, 333);
+    proto::FrameReader reader(writer.fd(), 64);
+
+    for (int i = 0; i < 2; i++) {
+        auto frame = reader.next();
+        ASSERT_TRUE(frame.has_value());
+        ASSERT_TRUE(std::ranges::equal(*frame, payload));
+    }
+    ASSERT_FALSE(reader.next().has_value());
+}
+
+TEST(Stream, read_messages_from_file) {
+    const auto frames = make_frames(5000);
+    std::FILE *file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    ASSERT_EQ(std::fwrite(frames.data(), 1, frames.size(), file),
+              frames.size());
+    std::fflush(file);
+    std::rewind(file);
+
+    std::size_t count = 0;
+    for (const auto &message :
+         proto::read_messages<test::DoubleInt>(::fileno(file))) {
+        ASSERT_EQ(message.value1, count);
+        count++;
+    }
+    ASSERT_EQ(count, 5000);
+    std::fclose(file);
+}
+
+TEST(Stream, empty_stream) {
+    PipeWriter writer({}, 1);
+    auto reader = proto::read_messages<test::DoubleInt>(writer.fd());
+    ASSERT_TRUE(reader.begin() == reader.end());
+}
+
+TEST(Stream, truncated_stream_throws) {
+    auto frames = make_frames(3);
+    frames.pop_back();
+    PipeWriter writer(frames, 4);
+
+    proto::FrameReader reader(writer.fd(), 8);
+    ASSERT_TRUE(reader.next().has_value());
+    ASSERT_TRUE(reader.next().has_value());
+    ASSERT_THROW((void)reader.next(), std::runtime_error);
+}
+
+TEST(Stream, oversized_frame_throws) {
+    // A frame of 4 bytes is at the limit, one of 6 bytes is over it
+    std::vector<std::byte> frames(10, std::byte{0x7f});
+    frames[0] = std::byte{3};
+    frames[4] = std::byte{5};
+    PipeWriter writer(frames, 2);
+
+    proto::FrameReader reader(writer.fd(), 3, proto::FrameFormat::Delimited,
+                              4);
+    ASSERT_EQ(reader.next()->size(), 3);
+    ASSERT_THROW((void)reader.next(), std::runtime_error);
+}
+
+TEST(Stream, reader_stops_while_blocked_on_read) {
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    {
+        // Nothing is ever written, so the read-ahead thread is blocked when
+        // the reader is destroyed
+        proto::FrameReader reader(fds[0]);
+    }
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+namespace {
+
+std::vector<std::byte> make_checksummed_frames(std::uint32_t count) {
+    std::vector<std::byte> frames;
+    for (std::uint32_t i = 0; i < count; i++) {
+        proto::serialize_delimited(
+            test::DoubleInt{i, -static_cast<std::int32_t>(i)}, frames,
+            proto::FrameFormat::Checksummed);
+    }
+    return frames;
+}
+
+} // namespace
+
+TEST(Stream, read_checksummed_messages) {
+    // Try chunk sizes around the frame size, so that frames, headers and
+    // checksums straddle chunks in every possible way
+    for (std::size_t chunk_size : {1, 2, 5, 9, 16, 4096}) {
+        PipeWriter writer(make_checksummed_frames(500), 13);
+
+        std::uint32_t expected = 0;
+        for (const auto &message : proto::read_messages<test::DoubleInt>(
+                 writer.fd(), chunk_size, proto::FrameFormat::Checksummed)) {
+            ASSERT_EQ(message.value1, expected) << chunk_size;
+            expected++;
+        }
+        ASSERT_EQ(expected, 500);
+    }
+}
+
+TEST(Stream, checksum_mismatch_throws) {
+    for (std::size_t chunk_size : {3, 64, 4096}) {
+        auto frames = make_checksummed_frames(200);
+        // Corrupt a payload byte somewhere in the middle
+        frames[frames.size() / 2] ^= std::byte{0x04};
+        PipeWriter writer(frames, 4096);
+
+        proto::FrameReader reader(writer.fd(), chunk_size,
+                                  proto::FrameFormat::Checksummed);
+        ASSERT_THROW(
+            {
+                while (reader.next().has_value()) {
+                }
+            },
+            std::runtime_error)
+            << chunk_size;
+    }
+}
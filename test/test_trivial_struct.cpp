@@ -7,6 +7,13 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
 TEST(TrivialStruct, singleint_serialize_deserialize) {
     static_assert(std::is_trivially_copyable_v<test::SingleInt>,
                   "SingleInt should be trivially copyable");
@@ -55,3 +62,45 @@ TEST(TrivialStruct, signed_int_and_float_serialize_deserialize) {
         proto::deserialize<test::IntAndFloat_asFixed>(serialized);
     ASSERT_EQ(deserialized, original);
 }
+
+TEST(TrivialStruct, serialize_into_span_matches_vector) {
+    constexpr test::DoubleInt original{42, -150};
+
+    auto serialized = proto::serialize(original);
+    ASSERT_EQ(serialized.size(), proto::serialized_size(original));
+
+    std::array<std::byte, 32> buffer{};
+    auto num_bytes_written = proto::serialize(original, buffer);
+    ASSERT_EQ(num_bytes_written, serialized.size());
+    ASSERT_TRUE(std::ranges::equal(std::span{buffer}.first(num_bytes_written),
+                                   serialized));
+
+    std::array<std::byte, 2> too_small{};
+    ASSERT_THROW(proto::serialize(original, too_small), std::runtime_error);
+}
+
+TEST(TrivialStruct, int32_min_uses_five_bytes) {
+    constexpr test::DoubleInt original{
+        std::numeric_limits<std::uint32_t>::max(),
+        std::numeric_limits<std::int32_t>::min()};
+
+    // Two one-byte keys and two five-byte values
+    auto serialized = proto::serialize(original);
+    ASSERT_EQ(serialized.size(), 12);
+    ASSERT_EQ(serialized.size(), proto::serialized_size(original));
+    ASSERT_EQ(proto::deserialize<test::DoubleInt>(serialized), original);
+}
+
+TEST(TrivialStruct, overlong_varint_for_member_throws) {
+    // Field 1 (uint32_t) holding a six-byte varint
+    std::vector<std::byte> serialized{std::byte{0x08}};
+    auto value = proto::serialize(proto::Varint{1ULL << 35});
+    serialized.insert(serialized.end(), value.begin(), value.end());
+    ASSERT_THROW((void)proto::deserialize<test::DoubleInt>(serialized),
+                 std::runtime_error);
+
+    // Truncated varint
+    serialized.resize(3);
+    ASSERT_THROW((void)proto::deserialize<test::DoubleInt>(serialized),
+                 std::runtime_error);
+}
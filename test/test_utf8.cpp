@@ -0,0 +1,148 @@
+#include "TestTypes.h"
+
+#include <protobuf-cpp/Deserialize.h>
+#include <protobuf-cpp/Extract.h>
+#include <protobuf-cpp/Gather.h>
+#include <protobuf-cpp/Json.h>
+#include <protobuf-cpp/Serialize.h>
+#include <protobuf-cpp/Utf8.h>
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+std::span<const std::byte> bytes(std::string_view text) {
+    return std::as_bytes(std::span{text.data(), text.size()});
+}
+
+// Both implementations must agree, and match the expectation
+void expect_valid(std::string_view text, bool valid) {
+    EXPECT_EQ(proto::is_valid_utf8_scalar(bytes(text)), valid) << text;
+    EXPECT_EQ(proto::is_valid_utf8(bytes(text)), valid) << text;
+}
+
+} // namespace
+
+TEST(Utf8, valid_sequences) {
+    expect_valid("", true);
+    expect_valid("plain ascii", true);
+    expect_valid("caf\xc3\xa9", true);
+    expect_valid("\xe2\x82\xac 20", true);
+    expect_valid("\xf0\x9f\x98\x80", true);
+    expect_valid("\xed\x9f\xbf", true);     // U+D7FF
+    expect_valid("\xee\x80\x80", true);     // U+E000
+    expect_valid("\xf4\x8f\xbf\xbf", true); // U+10FFFF
+    expect_valid(std::string_view{"\0", 1}, true);
+}
+
+TEST(Utf8, invalid_sequences) {
+    expect_valid("\x80", false);             // lone continuation
+    expect_valid("\xc3", false);             // truncated
+    expect_valid("\xc0\xaf", false);         // overlong 2-byte
+    expect_valid("\xe0\x80\xaf", false);     // overlong 3-byte
+    expect_valid("\xf0\x80\x80\xaf", false); // overlong 4-byte
+    expect_valid("\xed\xa0\x80", false);     // surrogate
+    expect_valid("\xf4\x90\x80\x80", false); // above U+10FFFF
+    expect_valid("\xf5\x80\x80\x80", false); // invalid lead
+    expect_valid("\xff", false);
+    expect_valid("\xe2\x82", false);
+    expect_valid("\xc3\xa9\xa9", false); // extra continuation
+}
+
+TEST(Utf8, simd_matches_scalar_across_block_boundaries) {
+    const std::vector<std::string> sequences{
+        "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\x80",
+        "\xc3",     "\xed\xa0\x80", "\xf4\x90\x80\x80", "\xe0\x80\xaf"};
+
+    // Place every sequence at every offset around the 32-byte blocks
+    for (const auto &sequence : sequences) {
+        for (std::size_t offset = 0; offset < 100; offset++) {
+            std::string text(offset, 'a');
+            text += sequence;
+            for (std::size_t padding : {0, 1, 2, 40}) {
+                auto padded = text + std::string(padding, 'b');
+                ASSERT_EQ(proto::is_valid_utf8(bytes(padded)),
+                          proto::is_valid_utf8_scalar(bytes(padded)))
+                    << offset << " " << padding;
+            }
+        }
+    }
+}
+
+TEST(Utf8, simd_matches_scalar_on_random_input) {
+    std::mt19937 rng{1234};
+    const std::vector<std::string> pieces{
+        "a", "z ", "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\x80",
+        "\xc0", "\xed\xa0\x80", "\xf4\x8f\xbf\xbf"};
+    std::uniform_int_distribution<std::size_t> pick(0, pieces.size() - 1);
+
+    for (int i = 0; i < 2000; i++) {
+        std::string text;
+        const auto count = 1 + rng() % 60;
+        for (std::size_t j = 0; j < count; j++) {
+            text += pieces[pick(rng)];
+        }
+        ASSERT_EQ(proto::is_valid_utf8(bytes(text)),
+                  proto::is_valid_utf8_scalar(bytes(text)))
+            << text;
+    }
+}
+
+TEST(Utf8, string_members_roundtrip) {
+    const std::string body = "Stra\xc3\x9f" "e und Pl\xc3\xa4tze";
+    const test::Document document{7, "title \xe2\x82\xac", body, "raw"};
+
+    auto serialized = proto::serialize(document);
+    ASSERT_EQ(serialized.size(), proto::serialized_size(document));
+
+    auto deserialized = proto::deserialize<test::Document>(serialized);
+    ASSERT_EQ(deserialized, document);
+
+    // string_view members reference the serialized buffer
+    ASSERT_GE(deserialized.body.data(),
+              reinterpret_cast<const char *>(serialized.data()));
+    ASSERT_LT(deserialized.body.data(),
+              reinterpret_cast<const char *>(serialized.data() +
+                                             serialized.size()));
+}
+
+TEST(Utf8, invalid_string_member_throws) {
+    const test::Document document{1, "bad \xc0\xaf", "", ""};
+    auto serialized = proto::serialize(document);
+    ASSERT_THROW((void)proto::deserialize<test::Document>(serialized),
+                 std::runtime_error);
+}
+
+TEST(Utf8, validation_can_be_disabled_per_member) {
+    const test::Document document{1, "", "", "\xff\xfe raw bytes"};
+    auto serialized = proto::serialize(document);
+    ASSERT_EQ(proto::deserialize<test::Document>(serialized), document);
+}
+
+TEST(Utf8, string_members_in_other_paths) {
+    const std::string large_title(10'000, 'x');
+    const test::Document document{3, large_title, "b\xc3\xa9", ""};
+    auto serialized = proto::serialize(document);
+
+    ASSERT_EQ(proto::to_json<test::Document>(serialized),
+              "{\"id\":3,\"title\":\"" + large_title +
+                  "\",\"body\":\"b\xc3\xa9\"}");
+
+    std::vector<std::byte> frames;
+    proto::serialize_delimited(document, frames);
+    ASSERT_EQ(proto::extract_member<&test::Document::title>(frames),
+              std::vector<std::string>{large_title});
+
+    proto::GatherBuffer out;
+    proto::serialize_gather(document, out);
+    ASSERT_EQ(out.segments().size(), 3);
+    ASSERT_EQ(out.segments()[1].iov_base, document.title.data());
+}
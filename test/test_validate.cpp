@@ -0,0 +1,143 @@
+#include "TestTypes.h"
+
+#include <protobuf-cpp/Deserialize.h>
+#include <protobuf-cpp/Serialize.h>
+#include <protobuf-cpp/Validate.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+std::vector<std::byte> bytes(std::initializer_list<int> values) {
+    std::vector<std::byte> result;
+    for (auto value : values) {
+        result.push_back(static_cast<std::byte>(value));
+    }
+    return result;
+}
+
+test::RoutingTable make_table() {
+    test::RoutingTable table{};
+    table.version = 7;
+    for (std::uint32_t i = 0; i < 40; i++) {
+        table.routes["10.1." + std::to_string(i)] = i * 1000;
+        table.names[i] = "node-" + std::to_string(i);
+        table.weights[static_cast<std::int32_t>(i)] = i * 0.5;
+    }
+    return table;
+}
+
+template <typename T> void expect_valid(const T &obj) {
+    const auto serialized = proto::serialize(obj);
+    const auto validation = proto::validate<T>(serialized);
+    EXPECT_TRUE(validation);
+    EXPECT_EQ(validation.offset, serialized.size());
+}
+
+template <typename T>
+proto::ValidationError error_of(const std::vector<std::byte> &data) {
+    return proto::validate<T>(data).error;
+}
+} // namespace
+
+TEST(Validate, serialized_messages_are_valid) {
+    expect_valid(test::DoubleInt{300, -5});
+    expect_valid(test::OptionalInt{0, 9});
+    expect_valid(test::Document{1, "title", "body", "raw"});
+    expect_valid(test::Telemetry{1, 2.0, 3.0, 4.0f, 5, 6});
+    expect_valid(make_table());
+    ASSERT_TRUE(proto::validate<test::DoubleInt>({}));
+}
+
+TEST(Validate, malformed_structure) {
+    using E = proto::ValidationError;
+    // Varint of 11 bytes
+    ASSERT_EQ(error_of<test::DoubleInt>(bytes({0x08, 0xff, 0xff, 0xff, 0xff,
+                                                0xff, 0xff, 0xff, 0xff, 0xff,
+                                                0xff, 0x01})),
+              E::MalformedVarint);
+    // Varint cut short
+    ASSERT_EQ(error_of<test::DoubleInt>(bytes({0x08, 0x80})),
+              E::MalformedVarint);
+    // LEN field longer than the message
+    ASSERT_EQ(error_of<test::Document>(bytes({0x12, 0x05, 'a', 'b'})),
+              E::Truncated);
+    ASSERT_EQ(error_of<test::DoubleInt>(bytes({0x0d, 0x01, 0x02})),
+              E::Truncated);
+    // Field number 0, and the group wire types
+    ASSERT_EQ(error_of<test::DoubleInt>(bytes({0x00, 0x01})), E::InvalidKey);
+    ASSERT_EQ(error_of<test::DoubleInt>(bytes({0x0b})), E::InvalidKey);
+}
+
+TEST(Validate, member_types) {
+    using E = proto::ValidationError;
+    // value1 is a Varint member sent as fixed32
+    ASSERT_EQ(error_of<test::DoubleInt>(bytes({0x0d, 0x01, 0x02, 0x03, 0x04})),
+              E::WireTypeMismatch);
+    // Six-byte varint for a 32-bit member
+    const auto too_long =
+        bytes({0x08, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01});
+    ASSERT_EQ(error_of<test::DoubleInt>(too_long), E::VarintTooLong);
+    ASSERT_THROW((void)proto::deserialize<test::DoubleInt>(too_long),
+                 std::runtime_error);
+    // Invalid UTF-8 is rejected in title but allowed in raw
+    ASSERT_EQ(error_of<test::Document>(bytes({0x12, 0x01, 0xff})),
+              E::InvalidUtf8);
+    ASSERT_TRUE(proto::validate<test::Document>(bytes({0x22, 0x01, 0xff})));
+    // Unknown fields are only checked for structure
+    ASSERT_TRUE(proto::validate<test::DoubleInt>(
+        bytes({0x4a, 0x02, 0xff, 0xff, 0x50, 0x01})));
+}
+
+TEST(Validate, nested_map_entries) {
+    // routes entry whose value (field 2) is sent as LEN
+    const auto serialized =
+        bytes({0x08, 0x01, 0x12, 0x05, 0x0a, 0x01, 'k', 0x12, 0x00});
+    const auto validation = proto::validate<test::RoutingTable>(serialized);
+    ASSERT_EQ(validation.error, proto::ValidationError::WireTypeMismatch);
+    // The offset points at the offending field inside the entry
+    ASSERT_EQ(validation.offset, 7);
+}
+
+TEST(Validate, valid_messages_decode_without_throwing) {
+    const auto serialized = proto::serialize(make_table());
+    std::mt19937 rng{11};
+    std::size_t num_valid = 0;
+    for (int i = 0; i < 5000; i++) {
+        auto mutated = serialized;
+        mutated.resize(rng() % (serialized.size() + 1));
+        for (int flips = 0; flips < 3 && !mutated.empty(); flips++) {
+            mutated[rng() % mutated.size()] ^=
+                static_cast<std::byte>(1u << (rng() % 8));
+        }
+        if (proto::validate<test::RoutingTable>(mutated)) {
+            num_valid++;
+            ASSERT_NO_THROW(
+                (void)proto::deserialize<test::RoutingTable>(mutated));
+        }
+    }
+    ASSERT_GT(num_valid, 0);
+}
+
+TEST(Validate, varint_end_mask_matches_continuation_bits) {
+    std::array<std::byte, 64> block{};
+    std::mt19937 rng{3};
+    for (auto &byte : block) {
+        byte = static_cast<std::byte>(rng());
+    }
+    std::uint64_t expected = 0;
+    for (std::size_t i = 0; i < block.size(); i++) {
+        if ((block[i] & std::byte{0x80}) == std::byte{0}) {
+            expected |= std::uint64_t{1} << i;
+        }
+    }
+    ASSERT_EQ(proto::varint_end_mask(block.data()), expected);
+}
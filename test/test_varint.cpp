@@ -150,3 +150,84 @@ TEST(Varint, ZigzagEncoding) {
                   .as<std::uint64_t>(),
               std::numeric_limits<std::uint64_t>::max());
 }
+
+/**
+ * Verify that signed values are zigzag encoded within their own width
+ */
+TEST(Varint, zigzag_uses_type_width) {
+    ASSERT_EQ(proto::Varint{std::numeric_limits<std::int32_t>::min()}.size(),
+              5);
+    ASSERT_EQ(proto::Varint{std::numeric_limits<std::int32_t>::min()}
+                  .as<std::int32_t>(),
+              std::numeric_limits<std::int32_t>::min());
+    ASSERT_EQ(proto::Varint{std::numeric_limits<std::int16_t>::min()}.size(),
+              3);
+    ASSERT_EQ(proto::Varint{std::numeric_limits<std::int8_t>::min()}.size(),
+              2);
+}
+
+/**
+ * Verify that serialize_as produces the same bytes as a Varint
+ */
+TEST(Varint, serialize_as_matches_varint) {
+    auto check = [](auto value) {
+        std::array<std::byte, proto::Varint::k_max_size> buffer{};
+        auto size = proto::Varint::serialize_as(value, buffer);
+        auto expected = proto::serialize(proto::Varint{value});
+        ASSERT_TRUE(std::ranges::equal(std::span{buffer}.first(size),
+                                       expected))
+            << +value;
+
+        auto deserialized =
+            proto::Varint::deserialize_as<decltype(value)>(buffer);
+        ASSERT_EQ(deserialized.num_bytes_read, size);
+        ASSERT_EQ(deserialized.value, value);
+    };
+
+    for (auto v : max_values) {
+        check(v);
+        check(static_cast<std::uint32_t>(v));
+        check(static_cast<std::int32_t>(v));
+        check(static_cast<std::int64_t>(v));
+        check(static_cast<std::uint8_t>(v));
+        check(static_cast<std::int16_t>(v));
+    }
+    check(std::numeric_limits<std::int32_t>::min());
+    check(std::numeric_limits<std::int64_t>::min());
+    check(true);
+
+    std::array<std::byte, 1> small{};
+    ASSERT_THROW(proto::Varint::serialize_as(std::uint32_t{300}, small),
+                 std::runtime_error);
+}
+
+/**
+ * Verify that deserialize_as reads no more bytes than its type needs
+ */
+TEST(Varint, deserialize_as_is_bounded_by_type) {
+    // 2^14 needs three bytes, one more than any uint8_t
+    auto serialized = proto::serialize(proto::Varint{1U << 14});
+    ASSERT_EQ(proto::Varint::deserialize_as<std::uint8_t>(serialized)
+                  .num_bytes_read,
+              0);
+    ASSERT_EQ(proto::Varint::deserialize_as<std::uint16_t>(serialized)
+                  .num_bytes_read,
+              3);
+
+    // A ten-byte encoding is too long for any 32-bit type
+    serialized = proto::serialize(proto::Varint{max_values[9]});
+    ASSERT_EQ(proto::Varint::deserialize_as<std::uint32_t>(serialized)
+                  .num_bytes_read,
+              0);
+    ASSERT_EQ(proto::Varint::deserialize_as<std::int64_t>(serialized)
+                  .num_bytes_read,
+              10);
+
+    // Truncated input
+    serialized.pop_back();
+    ASSERT_EQ(proto::Varint::deserialize_as<std::uint64_t>(serialized)
+                  .num_bytes_read,
+              0);
+    ASSERT_EQ(proto::Varint::deserialize_as<std::uint64_t>({}).num_bytes_read,
+              0);
+}